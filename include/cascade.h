@@ -63,9 +63,16 @@ class Cascade : public std::iostream {
     Cascade& set_fopen_dirs(const std::string& path);
     Cascade& set_include_dirs(const std::string& path);
     Cascade& set_enable_inlining(bool enable);
-    Cascade& set_open_loop_target(size_t n);
+    Cascade& set_enable_fusion(bool enable);
+    Cascade& set_enable_tiering(bool enable);
+    Cascade& set_promotion_threshold(size_t percent);
+    Cascade& set_open_loop_target(double n);
     Cascade& set_quartus_server(const std::string& host, size_t port);
+    Cascade& set_verilator_build(size_t opt_level, bool enable_lto, size_t jobs);
     Cascade& set_profile_interval(size_t n);
+    Cascade& set_parallel_threads(size_t n);
+    Cascade& set_cache_path(const std::string& path);
+    Cascade& set_cache_capacity(size_t mb);
     Cascade& set_stdin(std::streambuf* sb);
     Cascade& set_stdout(std::streambuf* sb);
     Cascade& set_stderr(std::streambuf* sb);
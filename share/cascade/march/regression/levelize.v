@@ -0,0 +1,11 @@
+`ifndef __SHARE_CASCADE_MARCH_REGRESSION_LEVELIZE_V
+`define __SHARE_CASCADE_MARCH_REGRESSION_LEVELIZE_V
+
+`include "share/cascade/stdlib/stdlib.v"
+
+(*__target="sw", __levelize="true"*)
+Root root();
+
+Clock clock();
+
+`endif
@@ -0,0 +1,11 @@
+`ifndef __SHARE_CASCADE_MARCH_REGRESSION_SW_VM_V
+`define __SHARE_CASCADE_MARCH_REGRESSION_SW_VM_V
+
+`include "share/cascade/stdlib/stdlib.v"
+
+(*__target="sw_vm"*)
+Root root();
+
+Clock clock();
+
+`endif
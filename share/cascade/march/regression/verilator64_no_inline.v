@@ -0,0 +1,11 @@
+`ifndef __SHARE_CASCADE_MARCH_REGRESSION_VERILATOR64_NO_INLINE_V
+`define __SHARE_CASCADE_MARCH_REGRESSION_VERILATOR64_NO_INLINE_V
+
+`include "share/cascade/stdlib/stdlib.v"
+
+(*__target="sw;verilator64", __no_inline="true"*)
+Root root();
+
+Clock clock();
+
+`endif
@@ -0,0 +1,16 @@
+// The initial block in M should run exactly once, no matter how many times
+// the engine it's compiled into is rebuilt.
+
+module M(clk);
+  input wire clk;
+  initial $write("once");
+endmodule
+
+M m(clock.val);
+
+reg[63:0] count = 0;
+always @(posedge clock.val) begin
+  count <= count + 1;
+  if (count == 1024) 
+    $finish;
+end
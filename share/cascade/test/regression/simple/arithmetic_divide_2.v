@@ -0,0 +1,26 @@
+// Division of values which are wider than a machine word. This covers
+// divisors which cross word boundaries, divisors larger than the dividend,
+// division by zero (which evaluates to zero), and signed operands.
+
+reg[127:0] a = 128'h123456789abcdeffedcba9876543210;
+reg[127:0] b = 128'h10000000000000003;
+reg[127:0] c = 128'h5;
+reg[127:0] d = 128'h10000000000000000;
+reg[127:0] e = 128'hffffffffffffffffffffffffffffffff;
+reg[127:0] z = 128'h0;
+reg signed[127:0] f = 128'hfffffffedcba9876543210fedcba9877;
+reg signed[127:0] s = 128'h7;
+reg signed[127:0] n = 128'hfffffffffffffffeffffffffffffffff;
+reg[191:0] x = 192'hfedcba98765432100123456789abcdef1122334455667788;
+reg[191:0] y = 192'h1ffffffffffffffff;
+
+initial begin
+  $write("%h ", a / b);
+  $write("%h ", c / d);
+  $write("%h ", a / z);
+  $write("%h ", e / d);
+  $write("%h ", f / s);
+  $write("%h ", f / n);
+  $write("%h ", x / y);
+  $finish;
+end
@@ -0,0 +1,16 @@
+// Powers of values which are wider than a machine word. Results wrap
+// modulo 2^128.
+
+reg[127:0] a = 128'h3;
+reg[127:0] b = 128'h10000000000000001;
+reg[127:0] c = 128'h2;
+reg[127:0] z = 128'h0;
+
+initial begin
+  $write("%h ", a ** 100);
+  $write("%h ", b ** 5);
+  $write("%h ", c ** 127);
+  $write("%h ", c ** 128);
+  $write("%h ", z ** 0);
+  $finish;
+end
@@ -0,0 +1,49 @@
+// A chain of continuous assigns which compute a fibonacci sequence. The
+// assigns are declared in reverse order, and the last link feeds a
+// combinational cycle, so a naive schedule evaluates most links many times
+// before the chain settles.
+
+reg[31:0] in = 0;
+wire[31:0] w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15, w16, w17, w18, w19, w20, w21, w22, w23, w24, w25, w26, w27, w28, w29;
+wire[31:0] p, q;
+
+assign q = w29 ^ (p & 32'd0);
+assign p = q;
+assign w29 = w28 + w27;
+assign w28 = w27 + w26;
+assign w27 = w26 + w25;
+assign w26 = w25 + w24;
+assign w25 = w24 + w23;
+assign w24 = w23 + w22;
+assign w23 = w22 + w21;
+assign w22 = w21 + w20;
+assign w21 = w20 + w19;
+assign w20 = w19 + w18;
+assign w19 = w18 + w17;
+assign w18 = w17 + w16;
+assign w17 = w16 + w15;
+assign w16 = w15 + w14;
+assign w15 = w14 + w13;
+assign w14 = w13 + w12;
+assign w13 = w12 + w11;
+assign w12 = w11 + w10;
+assign w11 = w10 + w9;
+assign w10 = w9 + w8;
+assign w9 = w8 + w7;
+assign w8 = w7 + w6;
+assign w7 = w6 + w5;
+assign w6 = w5 + w4;
+assign w5 = w4 + w3;
+assign w4 = w3 + w2;
+assign w3 = w2 + w1;
+assign w2 = w1 + w0;
+assign w1 = in + 1;
+assign w0 = in;
+
+always @(posedge clock.val) begin
+  $write("%d ", q);
+  in <= in + 1;
+  if (in == 19) begin
+    $finish;
+  end
+end
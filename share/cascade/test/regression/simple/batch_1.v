@@ -0,0 +1,16 @@
+// This test mixes continuous assignments, non-blocking assignments, and
+// system tasks, so that every step of a remote engine produces both writes
+// and updates.
+
+reg[7:0] a = 0;
+reg[7:0] b = 0;
+wire[7:0] c = a + b;
+
+always @(posedge clock.val) begin
+  $write("%d ", c);
+  a <= a + 1;
+  b <= c;
+  if (a == 5) begin
+    $finish;
+  end
+end
@@ -0,0 +1,21 @@
+// Mixes blocking assignments to constant array subscripts with a case
+// statement and non-blocking updates.
+
+reg[7:0] mem[3:0];
+reg[7:0] sum = 0;
+reg[3:0] count = 0;
+
+always @(posedge clock.val) begin
+  mem[0] = count;
+  mem[1] = mem[0] + 1;
+  case (count)
+    0: sum <= 1;
+    3: sum <= sum + mem[1];
+    default: sum <= sum + 2;
+  endcase
+  count <= count + 1;
+  if (count == 5) begin
+    $write("%d", sum);
+    $finish;
+  end
+end
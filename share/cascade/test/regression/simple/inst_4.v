@@ -0,0 +1,25 @@
+// Several independent counters whose outputs are only combined by the root.
+
+module Count #(parameter S = 1) (clk, out);
+  input wire clk;
+  output reg[31:0] out;
+
+  always @(posedge clk) begin
+    out <= out + S;
+  end
+endmodule
+
+wire[31:0] a, b, c, d;
+Count #(1) c1(clock.val, a);
+Count #(2) c2(clock.val, b);
+Count #(3) c3(clock.val, c);
+Count #(4) c4(clock.val, d);
+
+reg[31:0] n = 0;
+always @(posedge clock.val) begin
+  n <= n + 1;
+  if (n == 100) begin
+    $write("%d", a + b + c + d);
+    $finish;
+  end
+end
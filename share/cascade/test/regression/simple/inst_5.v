@@ -0,0 +1,23 @@
+// A parent and a child which both run long enough to be moved to hardware.
+// When neither is inlined, each one occupies a separate slot on the device.
+
+module Count(clk, out);
+  input wire clk;
+  output reg[31:0] out;
+
+  always @(posedge clk) begin
+    out <= out + 1;
+  end
+endmodule
+
+wire[31:0] a;
+Count c(clock.val, a);
+
+reg[31:0] n = 0;
+always @(posedge clock.val) begin
+  n <= n + 2;
+  if (a == 4000000) begin
+    $write("%d %d", a, n);
+    $finish;
+  end
+end
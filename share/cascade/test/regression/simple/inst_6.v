@@ -0,0 +1,27 @@
+// Several independent modules which all print on the same clock tick. None of
+// them communicate, so each one is scheduled in a separate partition.
+
+module Emit #(parameter C = 1) (clk);
+  input wire clk;
+
+  reg[31:0] n = 0;
+  always @(posedge clk) begin
+    n <= n + 1;
+    if (n == 10) begin
+      $write("%d%d", C, C);
+    end
+  end
+endmodule
+
+Emit #(1) e1(clock.val);
+Emit #(2) e2(clock.val);
+Emit #(3) e3(clock.val);
+Emit #(4) e4(clock.val);
+
+reg[31:0] n = 0;
+always @(posedge clock.val) begin
+  n <= n + 1;
+  if (n == 20) begin
+    $finish;
+  end
+end
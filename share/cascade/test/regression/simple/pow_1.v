@@ -0,0 +1,16 @@
+// Raises a series of 64-bit values to a power whose result overflows 64
+// bits. The result wraps modulo 2^64.
+
+reg[63:0] b = 3;
+reg[63:0] acc = 0;
+reg[15:0] count = 0;
+
+always @(posedge clock.val) begin
+  acc <= acc ^ (b ** 41);
+  b <= b + 2;
+  count <= count + 1;
+  if (count == 4096) begin
+    $write("%h", acc);
+    $finish;
+  end
+end
@@ -0,0 +1,20 @@
+// Raises every signed base in [-4,3] to every signed exponent in [-8,7].
+// Negative exponents produce 0, except for bases of 1 and -1.
+
+reg signed[2:0] b = 0;
+reg signed[3:0] e = 0;
+reg signed[7:0] r;
+reg[63:0] acc = 0;
+reg[15:0] count = 0;
+
+always @(posedge clock.val) begin
+  r = b ** e;
+  acc <= acc * 31 + {56'b0, r};
+  b <= b + 1;
+  e <= e + (b == 3);
+  count <= count + 1;
+  if (count == 4096) begin
+    $write("%h", acc);
+    $finish;
+  end
+end
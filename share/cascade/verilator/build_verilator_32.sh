@@ -2,6 +2,17 @@
 
 # $1 = unique compilation name
 # $2 = cxx compiler path
+# $3 = optimization level (defaults to 3)
+# $4 = 1 to enable link time optimization, 0 to disable it (defaults to 1)
+# $5 = number of parallel compiler invocations (defaults to 1)
+OPT=${3:-3}
+LTO=${4:-1}
+JOBS=${5:-1}
+if [ $LTO -eq 1 ] ; then
+  LTO_ARGS="-flto"
+else
+  LTO_ARGS=""
+fi
 
 # Check whether cxx compiler maps to clang or g++
 $2 --version | grep clang 
@@ -12,23 +23,38 @@ else
   VER_INSTALL=/usr/share/verilator/
   ARGS="-ftemplate-depth=4096 -fconstexpr-depth=4096"
 fi
+CXXFLAGS="-I$VER_INSTALL/include -I$VER_INSTALL/include/vltstd -DVL_PRINTF=printf -DVM_COVERAGE=0 -DVM_SC=0 -DVM_TRACE=0 -faligned-new $ARGS -Wno-parentheses-equality -Wno-sign-compare -Wno-uninitialized -Wno-unused-parameter -Wno-unused-variable -Wno-shadow -O$OPT -fno-stack-protector -DNDEBUG $LTO_ARGS -DVL_INLINE_OPT=inline"
+
+# Invoke verilator: fake_main.cpp is just here to guarantee that verilator produces all of the output we expect it to. Splitting the output lets us compile the model in parallel below.
+verilator -Mdir $1 --prefix Vprogram_logic -Wno-lint -Wno-fatal -cc -O3 --x-assign fast --x-initial fast --noassert --clk clk --output-split 20000 --output-split-cfuncs 2000 $1.v --exe fake_main.cpp || exit 1
 
-# Invoke verilator: fake_main.cpp is just here to guarantee that verilator produces all of the output we expect it to (namely $1/verilated.o)
-verilator -Mdir $1 --prefix Vprogram_logic -Wno-lint -Wno-fatal -cc -O3 --x-assign fast --x-initial fast --noassert --clk clk $1.v --exe fake_main.cpp
+# The verilated runtime doesn't depend on the program, only on the compiler, its flags, and the version of verilator. Build it once per combination and share it between compilations. We build into a temporary file and rename it into place so concurrent builds never see a partial object.
+RUNTIME=/tmp/verilator/runtime/`echo "$2 $CXXFLAGS \`verilator --version\`" | cksum | cut -d' ' -f1`
+if [ ! -f $RUNTIME/verilated.o ] ; then
+  mkdir -p $RUNTIME
+  $2 $CXXFLAGS -c -o $RUNTIME/verilated.o.$$ $VER_INSTALL/include/verilated.cpp || exit 1
+  mv $RUNTIME/verilated.o.$$ $RUNTIME/verilated.o
+fi
 
-# Invoke verilator's Makefile: We don't care about the binary this produces, all we're interested in are the object files ($1/Vprogram_logic_ALL.a, $1/verilated.o)
+# Compile the generated model JOBS translation units at a time. Compilers run as direct children of this script so that stop_compile() can kill them.
 cd $1
-$2 -I.  -MMD -I$VER_INSTALL/include -I$VER_INSTALL/include/vltstd -DVL_PRINTF=printf -DVM_COVERAGE=0 -DVM_SC=0 -DVM_TRACE=0 -faligned-new $ARGS -Wno-parentheses-equality -Wno-sign-compare -Wno-uninitialized -Wno-unused-parameter -Wno-unused-variable -Wno-shadow  -O3 -fno-stack-protector -DNDEBUG -flto -DVL_INLINE_OPT=inline -c -o verilated.o $VER_INSTALL/include/verilated.cpp 
-perl $VER_INSTALL/bin/verilator_includer -DVL_INCLUDE_OPT=include Vprogram_logic.cpp > Vprogram_logic__ALLcls.cpp 
-$2 -I.  -MMD -I$VER_INSTALL/include -I$VER_INSTALL/include/vltstd -DVL_PRINTF=printf -DVM_COVERAGE=0 -DVM_SC=0 -DVM_TRACE=0 -faligned-new $ARGS -Wno-parentheses-equality -Wno-sign-compare -Wno-uninitialized -Wno-unused-parameter -Wno-unused-variable -Wno-shadow  -O3 -fno-stack-protector -DNDEBUG -flto -DVL_INLINE_OPT=inline -c -o Vprogram_logic__ALLcls.o Vprogram_logic__ALLcls.cpp 
-perl $VER_INSTALL/bin/verilator_includer -DVL_INCLUDE_OPT=include Vprogram_logic__Syms.cpp > Vprogram_logic__ALLsup.cpp 
-$2 -I.  -MMD -I$VER_INSTALL/include -I$VER_INSTALL/include/vltstd -DVL_PRINTF=printf -DVM_COVERAGE=0 -DVM_SC=0 -DVM_TRACE=0 -faligned-new $ARGS -Wno-parentheses-equality -Wno-sign-compare -Wno-uninitialized -Wno-unused-parameter -Wno-unused-variable -Wno-shadow  -O3 -fno-stack-protector -DNDEBUG -flto -DVL_INLINE_OPT=inline -c -o Vprogram_logic__ALLsup.o Vprogram_logic__ALLsup.cpp 
-ar r Vprogram_logic__ALL.a Vprogram_logic__ALLcls.o Vprogram_logic__ALLsup.o 
-ranlib Vprogram_logic__ALL.a 
+N=0
+for SRC in Vprogram_logic*.cpp ; do
+  $2 -I. $CXXFLAGS -c -o ${SRC%.cpp}.o $SRC &
+  N=$((N+1))
+  if [ $N -ge $JOBS ] ; then
+    wait
+    N=0
+  fi
+done
+wait
+for SRC in Vprogram_logic*.cpp ; do
+  [ -f ${SRC%.cpp}.o ] || exit 1
+done
 cd -
 
 # Compile our harness file, which wraps invocations of verilator in extern "C" functions. 
-$2 --std=c++17 -fno-stack-protector -DNDEBUG -flto -I$VER_INSTALL/include/ -I$1 -c harness_32.cpp -o $1/harness.o
+$2 --std=c++17 -fno-stack-protector -DNDEBUG -O$OPT $LTO_ARGS -I$VER_INSTALL/include/ -I$1 -c harness_32.cpp -o $1/harness.o || exit 1
 
 # Wrap everything up in a dll
-$2 -fPIC -shared -flto -o $1/libverilator.so $1/harness.o $1/Vprogram_logic__ALL.a $1/verilated.o
+$2 -fPIC -shared -O$OPT $LTO_ARGS -o $1/libverilator.so $1/harness.o $1/Vprogram_logic*.o $RUNTIME/verilated.o || exit 1
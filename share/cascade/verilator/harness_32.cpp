@@ -4,78 +4,85 @@
 using namespace std;
 
 namespace {
-  
-enum Request {
-  READY = 0,
-  READ,
-  WRITE,
-  WAIT,
-  DONE_1,
-  DONE_2
-};
 
 Vprogram_logic* pl_;
-bool running_;
-Request req_;
-uint16_t addr_;
-uint32_t val_;
+
+// Evaluates the model and advances the clock by half a cycle.
+inline void step() {
+  pl_->eval();
+  pl_->clk = !pl_->clk;
+}
+
+// Holds a bus request until the slave drops waitrequest, which it holds for
+// as long as it has work to do (this includes running an open loop to
+// completion).
+inline void request() {
+  step();
+  while (pl_->s0_waitrequest) {
+    step();
+  }
+}
+
+// Deasserts the current request and gives the bus time to return to idle.
+inline void release() {
+  pl_->s0_read = 0;
+  pl_->s0_write = 0;
+  step();
+  step();
+  step();
+}
+
+// Drives a bus request to completion in the caller's thread.
+inline void transact() {
+  request();
+  release();
+}
 
 } // namespace
 
 extern "C" void verilator_init() {
   pl_ = new Vprogram_logic();
-  req_ = READY;
 }
 
-extern "C" void verilator_start() {
-  for (running_ = true; running_; ) {
-    switch (req_) {
-      case READY:
-        break;
-      case READ:
-        pl_->s0_address = addr_;
-        pl_->s0_read = 1;
-        req_ = WAIT;
-        break;
-      case WRITE:
-        pl_->s0_address = addr_;
-        pl_->s0_writedata = val_;
-        pl_->s0_write = 1;
-        req_ = WAIT;
-        break;
-      case WAIT:
-        if (!pl_->s0_waitrequest) {
-          pl_->s0_read = 0;
-          pl_->s0_write = 0;
-          req_ = DONE_1;
-        }
-        break;
-      case DONE_1:
-        req_ = DONE_2;
-        break;
-      case DONE_2:
-        req_ = READY;
-        break;
-    }
-    pl_->eval();
-    pl_->clk = !pl_->clk;
-  }
+extern "C" void verilator_stop() {
   pl_->final();
   delete pl_;
 }
 
-extern "C" void verilator_stop() {
-  running_ = false;
-}
-
 extern "C" void verilator_write(uint16_t addr, uint32_t val) {
-  addr_ = addr;
-  val_ = val;
-  for (req_ = WRITE; req_ != READY;);
+  pl_->s0_address = addr;
+  pl_->s0_writedata = val;
+  pl_->s0_write = 1;
+  transact();
 }
 
 extern "C" uint32_t verilator_read(uint16_t addr) {
-  addr_ = addr;
-  for (req_ = READ; req_ != READY;);
+  pl_->s0_address = addr;
+  pl_->s0_read = 1;
+  transact();
   return pl_->s0_readdata;
 }
+
+// Bursts hold the bus for the entire range of addresses. The slave treats
+// each change of address as a new request, so each word costs a single
+// handshake rather than a full transaction.
+
+extern "C" void verilator_write_burst(uint16_t addr, const uint32_t* vals, uint32_t n) {
+  pl_->s0_write = 1;
+  for (uint32_t i = 0; i < n; ++i) {
+    pl_->s0_address = addr + i;
+    pl_->s0_writedata = vals[i];
+    request();
+  }
+  release();
+}
+
+extern "C" void verilator_read_burst(uint16_t addr, uint32_t* vals, uint32_t n) {
+  pl_->s0_read = 1;
+  for (uint32_t i = 0; i < n; ++i) {
+    pl_->s0_address = addr + i;
+    request();
+    vals[i] = pl_->s0_readdata;
+  }
+  release();
+}
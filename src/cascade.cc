@@ -36,7 +36,9 @@
 #include "target/core/avmm/de10/de10_compiler.h"
 #include "target/core/avmm/ulx3s/ulx3s_compiler.h"
 #include "target/core/avmm/verilator/verilator_compiler.h"
+#include "target/core/native/native_compiler.h"
 #include "target/core/sw/sw_compiler.h"
+#include "target/core/sw/vm_compiler.h"
 #include "target/core/proxy/proxy_compiler.h"
 
 using namespace std;
@@ -47,12 +49,15 @@ Cascade::Cascade() : eval_(this), iostream(&sb_), sb_() {
   is_running_ = false;
 
   set_enable_inlining(true);
-  set_open_loop_target(1);
+  set_enable_fusion(false);
+  set_open_loop_target(10);
 
   runtime_.get_compiler()->set("avalon32", new avmm::Avalon32Compiler());
   runtime_.get_compiler()->set("de10", new avmm::De10Compiler());
+  runtime_.get_compiler()->set("native", new native::NativeCompiler());
   runtime_.get_compiler()->set("proxy", new proxy::ProxyCompiler());
   runtime_.get_compiler()->set("sw", new sw::SwCompiler());
+  runtime_.get_compiler()->set("sw_vm", new sw::VmCompiler());
   runtime_.get_compiler()->set("ulx3s32", new avmm::Ulx3s32Compiler());
   runtime_.get_compiler()->set("verilator32", new avmm::Verilator32Compiler());
   #if __x86_64__ || __ppc64__
@@ -85,7 +90,25 @@ Cascade& Cascade::set_enable_inlining(bool enable) {
   return *this;
 }
 
-Cascade& Cascade::set_open_loop_target(size_t n) {
+Cascade& Cascade::set_enable_fusion(bool enable) {
+  assert(!is_running_);
+  runtime_.set_enable_fusion(enable);
+  return *this;
+}
+
+Cascade& Cascade::set_enable_tiering(bool enable) {
+  assert(!is_running_);
+  runtime_.set_enable_tiering(enable);
+  return *this;
+}
+
+Cascade& Cascade::set_promotion_threshold(size_t percent) {
+  assert(!is_running_);
+  runtime_.set_promotion_threshold(percent);
+  return *this;
+}
+
+Cascade& Cascade::set_open_loop_target(double n) {
   assert(!is_running_);
   runtime_.set_open_loop_target(n);
   return *this;
@@ -100,12 +123,43 @@ Cascade& Cascade::set_quartus_server(const string& host, size_t port) {
   return *this;
 }
 
+Cascade& Cascade::set_verilator_build(size_t opt_level, bool enable_lto, size_t jobs) {
+  assert(!is_running_);
+  auto* vc32 = runtime_.get_compiler()->get("verilator32");
+  assert(vc32 != nullptr);
+  static_cast<avmm::Verilator32Compiler*>(vc32)->set_opt_level(opt_level).set_lto(enable_lto).set_num_jobs(jobs);
+  #if __x86_64__ || __ppc64__
+  auto* vc64 = runtime_.get_compiler()->get("verilator64");
+  assert(vc64 != nullptr);
+  static_cast<avmm::Verilator64Compiler*>(vc64)->set_opt_level(opt_level).set_lto(enable_lto).set_num_jobs(jobs);
+  #endif
+  return *this;
+}
+
 Cascade& Cascade::set_profile_interval(size_t n) {
   assert(!is_running_);
   runtime_.set_profile_interval(n);
   return *this;
 }
 
+Cascade& Cascade::set_parallel_threads(size_t n) {
+  assert(!is_running_);
+  runtime_.set_parallel_threads(n);
+  return *this;
+}
+
+Cascade& Cascade::set_cache_path(const string& path) {
+  assert(!is_running_);
+  runtime_.get_compiler()->get_cache().set_path(path);
+  return *this;
+}
+
+Cascade& Cascade::set_cache_capacity(size_t mb) {
+  assert(!is_running_);
+  runtime_.get_compiler()->get_cache().set_capacity(mb << 20);
+  return *this;
+}
+
 Cascade& Cascade::set_stdin(streambuf* sb) {
   assert(!is_running_);
   runtime_.rdbuf(0, sb);
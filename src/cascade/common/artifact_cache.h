@@ -0,0 +1,290 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_ARTIFACT_CACHE_H
+#define CASCADE_SRC_COMMON_ARTIFACT_CACHE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "common/system.h"
+
+namespace cascade {
+
+// This class implements a persistent, content-addressed store for the
+// artifacts produced by slow back-end compilations (shared objects,
+// bitstreams, etc). Entries are keyed by the text which produced them and
+// survive between runs, so that restarting on the same design can skip the
+// build entirely. Every entry records its key and a checksum of its payload;
+// entries which fail either check on lookup are treated as misses and
+// removed. The total size of the cache is bounded, and least recently used
+// entries are evicted first. Multiple processes may safely share the same
+// directory.
+
+class ArtifactCache {
+  public:
+    ArtifactCache();
+    ~ArtifactCache() = default;
+
+    // Configuration Interface:
+    //
+    // Sets the directory that entries are stored in, and the maximum number of
+    // bytes that they may occupy. Setting capacity to zero disables the cache.
+    ArtifactCache& set_path(const std::string& path);
+    ArtifactCache& set_capacity(size_t bytes);
+
+    // Cache Interface:
+    //
+    // Copies the artifact associated with key to dest. Returns false if no
+    // valid entry exists.
+    bool get(const std::string& key, const std::string& dest);
+    // Associates the contents of src with key, evicting entries as necessary.
+    void put(const std::string& key, const std::string& src);
+
+    // Returns a checksum of n bytes starting at c. Unlike std::hash, this is
+    // stable between builds, so it's safe to use in keys.
+    static uint64_t hash(const char* c, size_t n);
+
+  private:
+    // Entry Header:
+    struct Header {
+      char magic[8];
+      uint64_t key_size;
+      uint64_t payload_size;
+      uint64_t checksum;
+    };
+
+    std::mutex lock_;
+    std::string path_;
+    size_t capacity_;
+
+    // Helper Methods:
+    std::string entry(const std::string& key) const;
+    void evict();
+};
+
+inline ArtifactCache::ArtifactCache() {
+  set_path("/tmp/cascade/cache/");
+  set_capacity(size_t(1) << 30);
+}
+
+inline ArtifactCache& ArtifactCache::set_path(const std::string& path) {
+  std::lock_guard<std::mutex> lg(lock_);
+  path_ = path;
+  return *this;
+}
+
+inline ArtifactCache& ArtifactCache::set_capacity(size_t bytes) {
+  std::lock_guard<std::mutex> lg(lock_);
+  capacity_ = bytes;
+  return *this;
+}
+
+inline bool ArtifactCache::get(const std::string& key, const std::string& dest) {
+  // The lock only protects our configuration. Entries are replaced
+  // atomically and validated below, so there's no reason to hold it while we
+  // read what may be a very large payload.
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lg(lock_);
+    if (capacity_ == 0) {
+      return false;
+    }
+    path = entry(key);
+  }
+
+  std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+  if (!ifs.is_open()) {
+    return false;
+  }
+  const auto size = static_cast<uint64_t>(std::max<std::streamoff>(ifs.tellg(), 0));
+  ifs.seekg(0);
+
+  // Read the entry and check that it's intact before trusting it. The sizes
+  // in the header have to account for exactly the rest of the file, which
+  // keeps a corrupt header from asking us to allocate an arbitrary amount of
+  // memory. Anything which fails these checks is garbage, and we may as well
+  // reclaim the space.
+  Header h;
+  ifs.read(reinterpret_cast<char*>(&h), sizeof(h));
+  auto valid = ifs.good() && std::equal(h.magic, h.magic+8, "CASCADE") &&
+    (h.key_size <= size - sizeof(h)) && (h.payload_size == size - sizeof(h) - h.key_size);
+  std::string k;
+  std::string payload;
+  if (valid) {
+    k.resize(h.key_size);
+    ifs.read(&k[0], h.key_size);
+    valid = ifs.good();
+  }
+  // An intact entry for a different key means that two keys collided. That
+  // entry is still good, so leave it alone and treat this as a miss.
+  if (valid && (k != key)) {
+    return false;
+  }
+  if (valid) {
+    payload.resize(h.payload_size);
+    ifs.read(&payload[0], h.payload_size);
+    valid = ifs.good() && (ifs.peek() == EOF) && (hash(payload.data(), payload.size()) == h.checksum);
+  }
+  ifs.close();
+  if (!valid) {
+    unlink(path.c_str());
+    return false;
+  }
+
+  std::ofstream ofs(dest, std::ios::binary | std::ios::trunc);
+  ofs.write(payload.data(), payload.size());
+  ofs.close();
+  if (!ofs) {
+    return false;
+  }
+
+  // Bump the modification time of this entry. This is the order that
+  // entries are evicted in.
+  utimes(path.c_str(), nullptr);
+  return true;
+}
+
+inline void ArtifactCache::put(const std::string& key, const std::string& src) {
+  std::lock_guard<std::mutex> lg(lock_);
+  if (capacity_ == 0) {
+    return;
+  }
+
+  std::ifstream ifs(src, std::ios::binary);
+  if (!ifs.is_open()) {
+    return;
+  }
+  const std::string payload((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  ifs.close();
+  if (sizeof(Header) + key.size() + payload.size() > capacity_) {
+    return;
+  }
+
+  Header h = {{'C','A','S','C','A','D','E','\0'}, key.size(), payload.size(), hash(payload.data(), payload.size())};
+
+  // Write the entry under a name which is unique to this thread and then
+  // move it into place. Rename is atomic, so concurrent readers will see
+  // either nothing or a complete entry.
+  System::execute("mkdir -p " + path_);
+  const auto path = entry(key);
+  std::stringstream ss;
+  ss << path << ".tmp." << getpid() << "." << std::this_thread::get_id();
+  const auto tmp = ss.str();
+  std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+  ofs.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  ofs.write(key.data(), key.size());
+  ofs.write(payload.data(), payload.size());
+  ofs.close();
+  if (!ofs || (rename(tmp.c_str(), path.c_str()) != 0)) {
+    unlink(tmp.c_str());
+    return;
+  }
+
+  evict();
+}
+
+inline uint64_t ArtifactCache::hash(const char* c, size_t n) {
+  // 64-bit FNV-1a. Unlike std::hash, this is guaranteed to be stable between
+  // builds, which matters for keys that live on disk.
+  uint64_t res = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < n; ++i) {
+    res = (res ^ uint8_t(c[i])) * 0x100000001b3ull;
+  }
+  return res;
+}
+
+inline std::string ArtifactCache::entry(const std::string& key) const {
+  char buffer[17];
+  snprintf(buffer, 17, "%016llx", static_cast<unsigned long long>(hash(key.data(), key.size())));
+  return path_ + "/" + buffer + ".art";
+}
+
+inline void ArtifactCache::evict() {
+  auto* dir = opendir(path_.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+
+  struct Entry {
+    std::string path;
+    size_t size;
+    struct timespec time;
+  };
+  std::vector<Entry> entries;
+  size_t total = 0;
+  for (auto* de = readdir(dir); de != nullptr; de = readdir(dir)) {
+    const std::string name = de->d_name;
+    if ((name.length() < 4) || (name.substr(name.length()-4) != ".art")) {
+      continue;
+    }
+    struct stat st;
+    const auto path = path_ + "/" + name;
+    if (stat(path.c_str(), &st) != 0) {
+      continue;
+    }
+    #ifdef __APPLE__
+    entries.push_back({path, size_t(st.st_size), st.st_mtimespec});
+    #else
+    entries.push_back({path, size_t(st.st_size), st.st_mtim});
+    #endif
+    total += st.st_size;
+  }
+  closedir(dir);
+
+  if (total <= capacity_) {
+    return;
+  }
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return (a.time.tv_sec != b.time.tv_sec) ? (a.time.tv_sec < b.time.tv_sec) : (a.time.tv_nsec < b.time.tv_nsec);
+  });
+  for (auto& e : entries) {
+    if (total <= capacity_) {
+      break;
+    }
+    unlink(e.path.c_str());
+    total -= e.size;
+  }
+}
+
+} // namespace cascade
+
+#endif
@@ -40,12 +40,17 @@
 #include <string>
 #include <type_traits>
 #include <vector>
+#include "common/bits_kernels.h"
 #include "common/serializable.h"
+#include "common/small_vector.h"
 #include "common/vector.h"
 
 namespace cascade {
 
-// This class is the fundamental representation of a bit string. 
+// This class is the fundamental representation of a bit string. Values of up
+// to 128 bits are stored inline, and the operators below all provide a fast
+// path for values which fit in a single word. Only wider values pay for a
+// heap allocation or the multi-word loops.
 
 template <typename T, typename BT, typename ST>
 class BitsBase : public Serializable {
@@ -125,8 +130,10 @@ class BitsBase : public Serializable {
     //
     // Apply an arithmetic operator to operands and store the result here.
     // These methods all assume equivalent bit-width between operands and
-    // destination and do not sign extend. These methods all work on signed,
-    // unsigned, and real values (with the exception of mod).
+    // destination and do not sign extend (with the exception of pow, whose
+    // exponent is self-determined). These methods all work on signed,
+    // unsigned, and real values (with the exception of mod). Division by zero
+    // evaluates to zero.
     void arithmetic_plus(const BitsBase& lhs);
     void arithmetic_plus(const BitsBase& lhs, const BitsBase& rhs);
     void arithmetic_minus(const BitsBase& lhs);
@@ -218,8 +225,8 @@ class BitsBase : public Serializable {
     bool operator>=(const BitsBase& rhs) const;
 
   private:
-    // Bit-string representation
-    Vector<T> val_;
+    // Bit-string representation, inline up to 128 bits
+    SmallVector<T, 16/sizeof(T)> val_;
     // Total number of bits in this string
     uint32_t size_;
     // How is this value being interpreted
@@ -249,6 +256,8 @@ class BitsBase : public Serializable {
     // Shift Helpers:
     void bitwise_sll_const(const BitsBase& lhs, size_t samt);
     void bitwise_sxr_const(const BitsBase& lhs, size_t samt, bool arith);
+    // Division Helper: Multi-word long division; stores quotient or remainder
+    void divide_words(const BitsBase& lhs, const BitsBase& rhs, bool mod);
 
     // Returns the nth (possibly greater than val_.size()th) word of this value.
     // Performs sign extension as necessary.
@@ -497,6 +506,10 @@ inline bool BitsBase<T, BT, ST>::to_bool() const {
   if (type_ == Type::REAL) {
     return *reinterpret_cast<const double*>(val_.data()) != 0.0;
   }
+  // Fast Path: Single word values
+  if (val_.size() == 1) {
+    return val_[0] != 0;
+  }
   // Otherwise check whether any bits are non-zero.
   for (const auto& v : val_) {
     if (v) {
@@ -618,9 +631,11 @@ inline void BitsBase<T, BT, ST>::bitwise_and(const BitsBase& lhs, const BitsBase
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
-    val_[i] = lhs.val_[i] & rhs.val_[i];
+  if (val_.size() == 1) {
+    val_[0] = lhs.val_[0] & rhs.val_[0];
+    return;
   }
+  BitsKernels<T>::bitwise_and(val_.data(), lhs.val_.data(), rhs.val_.data(), val_.size());
 }
 
 template <typename T, typename BT, typename ST>
@@ -629,9 +644,11 @@ inline void BitsBase<T, BT, ST>::bitwise_or(const BitsBase& lhs, const BitsBase&
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
-    val_[i] = lhs.val_[i] | rhs.val_[i];
+  if (val_.size() == 1) {
+    val_[0] = lhs.val_[0] | rhs.val_[0];
+    return;
   }
+  BitsKernels<T>::bitwise_or(val_.data(), lhs.val_.data(), rhs.val_.data(), val_.size());
 }
 
 template <typename T, typename BT, typename ST>
@@ -640,9 +657,11 @@ inline void BitsBase<T, BT, ST>::bitwise_xor(const BitsBase& lhs, const BitsBase
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
-    val_[i] = lhs.val_[i] ^ rhs.val_[i];
+  if (val_.size() == 1) {
+    val_[0] = lhs.val_[0] ^ rhs.val_[0];
+    return;
   }
+  BitsKernels<T>::bitwise_xor(val_.data(), lhs.val_.data(), rhs.val_.data(), val_.size());
 }
 
 template <typename T, typename BT, typename ST>
@@ -651,9 +670,12 @@ inline void BitsBase<T, BT, ST>::bitwise_xnor(const BitsBase& lhs, const BitsBas
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
-    val_[i] = ~(lhs.val_[i] ^ rhs.val_[i]);
+  if (val_.size() == 1) {
+    val_[0] = ~(lhs.val_[0] ^ rhs.val_[0]);
+    trim();
+    return;
   }
+  BitsKernels<T>::bitwise_xnor(val_.data(), lhs.val_.data(), rhs.val_.data(), val_.size());
   trim();
 }
 
@@ -689,9 +711,12 @@ inline void BitsBase<T, BT, ST>::bitwise_not(const BitsBase& lhs) {
   assert(!is_real() && !lhs.is_real());
   assert(size() == lhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
-    val_[i] = ~lhs.val_[i];
+  if (val_.size() == 1) {
+    val_[0] = ~lhs.val_[0];
+    trim();
+    return;
   }
+  BitsKernels<T>::bitwise_not(val_.data(), lhs.val_.data(), val_.size());
   trim();
 }
 
@@ -715,6 +740,11 @@ inline void BitsBase<T, BT, ST>::arithmetic_plus(const BitsBase& lhs, const Bits
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
+  if (val_.size() == 1) {
+    val_[0] = lhs.val_[0] + rhs.val_[0];
+    trim();
+    return;
+  }
   T carry = 0;
   for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
     val_[i] = lhs.val_[i] + rhs.val_[i] + carry;
@@ -737,6 +767,11 @@ inline void BitsBase<T, BT, ST>::arithmetic_minus(const BitsBase& lhs) {
 
   assert(size() == lhs.size());
 
+  if (val_.size() == 1) {
+    val_[0] = ~lhs.val_[0] + static_cast<T>(1);
+    trim();
+    return;
+  }
   T carry = 1;
   for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
     val_[i] = ~lhs.val_[i];
@@ -758,6 +793,11 @@ inline void BitsBase<T, BT, ST>::arithmetic_minus(const BitsBase& lhs, const Bit
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
+  if (val_.size() == 1) {
+    val_[0] = lhs.val_[0] - rhs.val_[0];
+    trim();
+    return;
+  }
   T carry = 0;
   for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
     val_[i] = lhs.val_[i] - rhs.val_[i] - carry;
@@ -781,19 +821,30 @@ inline void BitsBase<T, BT, ST>::arithmetic_multiply(const BitsBase& lhs, const
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
+  if (val_.size() == 1) {
+    val_[0] = lhs.val_[0] * rhs.val_[0];
+    trim();
+    return;
+  }
+
   // This is the optimized space algorithm described in wiki's multiplication
   // algorithm article. The code is simplified here, as we can assume that both
-  // inputs and the result are capped at S words. 
+  // inputs and the result are capped at S words. Column sums can exceed the
+  // width of BT, so we keep track of overflow in a third word.
 
   const auto S = val_.size();
   BT tot = 0;
+  T over = 0;
   for (size_t ri = 0; ri < S; ++ri) {
     for (size_t bi = 0; bi <= ri; ++bi) {
       size_t ai = ri - bi;
-      tot += static_cast<BT>(lhs.val_[ai]) * static_cast<BT>(rhs.val_[bi]);
+      const auto prod = static_cast<BT>(lhs.val_[ai]) * static_cast<BT>(rhs.val_[bi]);
+      tot += prod;
+      over += (tot < prod) ? 1 : 0;
     }
     val_[ri] = static_cast<T>(tot);
-    tot >>= bits_per_word();
+    tot = (tot >> bits_per_word()) | (static_cast<BT>(over) << bits_per_word());
+    over = 0;
   }
   trim();
 }
@@ -809,17 +860,20 @@ inline void BitsBase<T, BT, ST>::arithmetic_divide(const BitsBase& lhs, const Bi
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  // TODO(eschkufz) This only words for single word inputs
-  assert(val_.size() == 1);
-
-  if ((lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
-    const ST l = lhs.is_neg_signed() ? (lhs.val_[0] | (static_cast<BT>(-1) << size_)) : lhs.val_[0];
-    const ST r = rhs.is_neg_signed() ? (rhs.val_[0] | (static_cast<BT>(-1) << rhs.size_)) : rhs.val_[0]; 
-    val_[0] = l / r;
-  } else {
-    val_[0] = lhs.val_[0] / rhs.val_[0];
+  // Fast Path: Single word values
+  if (val_.size() == 1) {
+    if ((lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
+      const auto l = static_cast<ST>(lhs.signed_get(0));
+      const auto r = static_cast<ST>(rhs.signed_get(0));
+      // Negate rather than divide by -1 to avoid overflowing on the minimum value
+      val_[0] = (r == 0) ? static_cast<T>(0) : (r == -1) ? (static_cast<T>(0) - static_cast<T>(l)) : static_cast<T>(l / r);
+    } else {
+      val_[0] = (rhs.val_[0] == 0) ? static_cast<T>(0) : (lhs.val_[0] / rhs.val_[0]);
+    }
+    trim();
+    return;
   }
-  trim();
+  divide_words(lhs, rhs, false);
 }
 
 template <typename T, typename BT, typename ST>
@@ -828,33 +882,90 @@ inline void BitsBase<T, BT, ST>::arithmetic_mod(const BitsBase& lhs, const BitsB
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  // TODO(eschkufz) This only words for single word inputs
-  assert(val_.size() == 1);
-
-  if ((lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
-    const ST l = lhs.is_neg_signed() ? (lhs.val_[0] | (static_cast<BT>(-1) << size_)) : lhs.val_[0];
-    const ST r = rhs.is_neg_signed() ? (rhs.val_[0] | (static_cast<BT>(-1) << rhs.size_)) : rhs.val_[0]; 
-    val_[0] = l % r;
-  } else {
-    val_[0] = lhs.val_[0] % rhs.val_[0];
+  // Fast Path: Single word values
+  if (val_.size() == 1) {
+    if ((lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
+      const auto l = static_cast<ST>(lhs.signed_get(0));
+      const auto r = static_cast<ST>(rhs.signed_get(0));
+      // Anything mod -1 is zero; this also avoids overflowing on the minimum value
+      val_[0] = ((r == 0) || (r == -1)) ? static_cast<T>(0) : static_cast<T>(l % r);
+    } else {
+      val_[0] = (rhs.val_[0] == 0) ? static_cast<T>(0) : (lhs.val_[0] % rhs.val_[0]);
+    }
+    trim();
+    return;
   }
-  trim();
+  divide_words(lhs, rhs, true);
 }
 
 template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::arithmetic_pow(const BitsBase& lhs, const BitsBase& rhs) {
-  // TODO(eschkufz) There's a lot wrong here:
-  // 1. We're not respecting verilog semantics (wrt sign and result)
-  // 2. This only works for single word inputs
-  // 3. We're not supporting reals, which this should be defined for
+  if (lhs.is_real() || rhs.is_real()) {
+    assert(size() == 64);
+    *reinterpret_cast<double*>(val_.data()) = std::pow(lhs.to_double(), rhs.to_double());
+    return;
+  }
 
-  assert(!lhs.is_real() && !rhs.is_real());
+  // No resize. This method preserves the bit-width of lhs. The exponent is
+  // self-determined, so its width is unconstrained.
   assert(size() == lhs.size());
-  assert(size() == rhs.size());
-  assert(val_.size() == 1);
 
-  // No resize. This method preserves the bit-width of lhs
-  val_[0] = std::pow(lhs.val_[0], rhs.val_[0]);
+  // Negative exponents: 1 and -1 are the only bases with non-zero results.
+  // We don't have an x value, so 0 ** -n evaluates to 0 as well.
+  if (rhs.is_neg_signed()) {
+    const auto one = (lhs.val_[0] == 1) && std::all_of(lhs.val_.begin()+1, lhs.val_.end(), [](T t) {return t == 0;});
+    auto neg_one = lhs.is_neg_signed();
+    for (size_t i = 0, ie = val_.size(); neg_one && (i < ie); ++i) {
+      neg_one = lhs.signed_get(i) == static_cast<T>(-1);
+    }
+    std::fill(val_.begin(), val_.end(), static_cast<T>(0));
+    if (one || (neg_one && !rhs.get(0))) {
+      val_[0] = 1;
+    } else if (neg_one) {
+      std::fill(val_.begin(), val_.end(), static_cast<T>(-1));
+    }
+    trim();
+    return;
+  }
+
+  // Fast Path: Single word values. Square and multiply, modulo 2^size.
+  if (val_.size() == 1) {
+    T base = lhs.val_[0];
+    T res = 1;
+    for (size_t i = 0, ie = rhs.val_.size(); i < ie; ++i) {
+      for (auto e = rhs.val_[i], j = static_cast<T>(0); (j < bits_per_word()) && ((i+1 < ie) || (e != 0)); ++j, e >>= 1) {
+        if (e & 1) {
+          res *= base;
+        }
+        base *= base;
+      }
+    }
+    val_[0] = res;
+    trim();
+    return;
+  }
+
+  // Otherwise, square and multiply using multi-word multiplication
+  auto top = rhs.size_;
+  while ((top > 0) && !rhs.get(top-1)) {
+    --top;
+  }
+  BitsBase base = lhs;
+  BitsBase res = lhs;
+  BitsBase temp = lhs;
+  std::fill(res.val_.begin(), res.val_.end(), static_cast<T>(0));
+  res.val_[0] = 1;
+  for (size_t i = 0; i < top; ++i) {
+    if (rhs.get(i)) {
+      temp.arithmetic_multiply(res, base);
+      std::swap(res.val_, temp.val_);
+    }
+    if (i+1 < top) {
+      temp.arithmetic_multiply(base, base);
+      std::swap(base.val_, temp.val_);
+    }
+  }
+  val_ = res.val_;
   trim();
 }
 
@@ -925,22 +1036,16 @@ template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::reduce_and(const BitsBase& lhs) {
   assert(!is_real() && !lhs.is_real());
   // Logical operations always yield unsigned results
-  for (size_t i = 0, ie = lhs.val_.size()-1; i < ie; ++i) {
-    if (lhs.val_[i] != static_cast<T>(-1)) {
-      val_[0] = static_cast<T>(0);
-      trim();
-      return;
-    }
-  }
-  const auto mask = (static_cast<T>(1) << (size_ % bits_per_word())) - 1;
-  if ((lhs.val_.back() & mask) != mask) {
-    val_[0] = static_cast<T>(0);
+  const auto lover = lhs.size_ % bits_per_word();
+  const auto mask = (lover == 0) ? static_cast<T>(-1) : ((static_cast<T>(1) << lover) - 1);
+  if (lhs.val_.size() == 1) {
+    val_[0] = (lhs.val_[0] == mask) ? static_cast<T>(1) : static_cast<T>(0);
     trim();
-    return; 
+    return;
   }
-  val_[0] = static_cast<T>(1);
+  const auto res = BitsKernels<T>::all_ones(lhs.val_.data(), lhs.val_.size()-1) && (lhs.val_.back() == mask);
+  val_[0] = res ? static_cast<T>(1) : static_cast<T>(0);
   trim();
-  return;
 }
 
 template <typename T, typename BT, typename ST>
@@ -953,14 +1058,12 @@ inline void BitsBase<T, BT, ST>::reduce_nand(const BitsBase& lhs) {
 template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::reduce_or(const BitsBase& lhs) {
   assert(!is_real() && !lhs.is_real());
-  for (size_t i = 0, ie = lhs.val_.size(); i < ie; ++i) {
-    if (lhs.val_[i]) {
-      val_[0] = static_cast<T>(1);
-      trim();
-      return;
-    }
+  if (lhs.val_.size() == 1) {
+    val_[0] = (lhs.val_[0] != 0) ? static_cast<T>(1) : static_cast<T>(0);
+    trim();
+    return;
   }
-  val_[0] = static_cast<T>(0);
+  val_[0] = BitsKernels<T>::any(lhs.val_.data(), lhs.val_.size()) ? static_cast<T>(1) : static_cast<T>(0);
   trim();
 }
 
@@ -974,11 +1077,7 @@ inline void BitsBase<T, BT, ST>::reduce_nor(const BitsBase& lhs) {
 template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::reduce_xor(const BitsBase& lhs) {
   assert(!is_real() && !lhs.is_real());
-  size_t cnt = 0;
-  for (size_t i = 0, ie = lhs.val_.size(); i < ie; ++i) {
-    cnt += __builtin_popcount(lhs.val_[i]);
-  }
-  val_[0] = static_cast<T>(cnt % 2);
+  val_[0] = static_cast<T>(BitsKernels<T>::popcount(lhs.val_.data(), lhs.val_.size()) % 2);
   trim();
 }
 
@@ -993,10 +1092,14 @@ template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::concat(const BitsBase& rhs) {
   assert(!is_real() && !rhs.is_real());
 
-  bitwise_sll_const(*this, rhs.size_);
-  for (size_t i = 0, ie = std::min(val_.size(), rhs.val_.size()); i < ie; ++i) {
-    val_[i] |= rhs.val_[i];
+  if (val_.size() == 1) {
+    val_[0] = (rhs.size_ >= bits_per_word()) ? static_cast<T>(0) : (val_[0] << rhs.size_);
+    trim();
+    val_[0] |= rhs.val_[0];
+    return;
   }
+  bitwise_sll_const(*this, rhs.size_);
+  BitsKernels<T>::bitwise_or(val_.data(), val_.data(), rhs.val_.data(), std::min(val_.size(), rhs.val_.size()));
 }
 
 template <typename T, typename BT, typename ST>
@@ -1015,7 +1118,16 @@ inline bool BitsBase<T, BT, ST>::eq(const BitsBase& rhs) const {
     return eq(temp);
   }
 
-  size_t i = 0;
+  if (val_.size() == 1) {
+    const auto lover = size_ % bits_per_word();
+    const auto mask = (lover == 0) ? static_cast<T>(-1) : ((static_cast<T>(1) << lover) - 1);
+    return val_[0] == (rhs.signed_get(0) & mask);
+  }
+  // Below the top word of either value, signed_get() is the identity
+  size_t i = std::min(val_.size(), rhs.val_.size()) - 1;
+  if (!BitsKernels<T>::equal(val_.data(), rhs.val_.data(), i)) {
+    return false;
+  }
   for (size_t ie = val_.size()-1; i < ie; ++i) {
     const auto rval = rhs.signed_get(i);
     if (val_[i] != rval) {
@@ -1112,6 +1224,11 @@ inline void BitsBase<T, BT, ST>::assign(const BitsBase& rhs) {
   }
 
   assert(!is_real() && !rhs.is_real());
+  if (val_.size() == 1) {
+    val_[0] = rhs.signed_get(0);
+    trim();
+    return;
+  }
   for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
     val_[i] = rhs.signed_get(i);
   }
@@ -1301,12 +1418,10 @@ inline bool BitsBase<T, BT, ST>::operator==(const BitsBase& rhs) const {
   }
 
   assert(size_ == rhs.size_);
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
-    if (val_[i] != rhs.val_[i]) {
-      return false;
-    }
+  if (val_.size() == 1) {
+    return val_[0] == rhs.val_[0];
   }
-  return true;
+  return BitsKernels<T>::equal(val_.data(), rhs.val_.data(), val_.size());
 }
 
 template <typename T, typename BT, typename ST>
@@ -1333,6 +1448,12 @@ inline bool BitsBase<T, BT, ST>::operator<(const BitsBase& rhs) const {
   }
 
   assert(size_ == rhs.size_);
+  if (val_.size() == 1) {
+    if ((type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
+      return static_cast<ST>(signed_get(0)) < static_cast<ST>(rhs.signed_get(0));
+    } 
+    return val_[0] < rhs.val_[0];
+  }
   if ((type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
     const auto lneg = is_neg_signed();
     const auto rneg = rhs.is_neg_signed();
@@ -1371,6 +1492,12 @@ inline bool BitsBase<T, BT, ST>::operator<=(const BitsBase& rhs) const {
   }
 
   assert(size_ == rhs.size_);
+  if (val_.size() == 1) {
+    if ((type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
+      return static_cast<ST>(signed_get(0)) <= static_cast<ST>(rhs.signed_get(0));
+    } 
+    return val_[0] <= rhs.val_[0];
+  }
   if ((type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
     const auto lneg = is_neg_signed();
     const auto rneg = rhs.is_neg_signed();
@@ -1634,6 +1761,13 @@ template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::bitwise_sll_const(const BitsBase& lhs, size_t samt) {
   assert(!is_real() && !lhs.is_real());
   assert(size() == lhs.size());
+
+  // Fast Path: Single word values
+  if (val_.size() == 1) {
+    val_[0] = (samt >= bits_per_word()) ? static_cast<T>(0) : (lhs.val_[0] << samt);
+    trim();
+    return;
+  }
   
   // Easy Case: We're not actually shifting
   if (samt == 0) {
@@ -1643,33 +1777,30 @@ inline void BitsBase<T, BT, ST>::bitwise_sll_const(const BitsBase& lhs, size_t s
     return;
   }
 
-  // This algorithm works from highest to lowest order, one word at a time
-  // word: The current word we're looking at
-  // top/bottom: The words that will be shifted into word; word can equal top
+  // Another Easy Case: We're shifting more bits than we have here
+  if (samt >= size_) {
+    std::fill(val_.begin(), val_.end(), static_cast<T>(0));
+    return;
+  }
 
-  // How many words ahead is bottom?
-  const auto delta = ((samt + bits_per_word()) - 1) / bits_per_word();
-  // How many bits are we taking from bottom and shifting top?
+  // How many whole words are we shifting and how many bits are left over?
+  const auto delta = samt / bits_per_word();
   const auto bamt = samt % bits_per_word();
-  // Create a mask for extracting the highest bamt bits from bottom
-  const auto mamt = bits_per_word() - bamt;
-  const auto mask = ((static_cast<T>(1) << bamt) - 1) << mamt;
+  // How many words of lhs survive the shift?
+  const auto cnt = val_.size() - delta;
 
-  // Work our way down until bottom hits zero
-  int w = val_.size() - 1;
-  for (int b = w-delta; b >= 0; --w, --b) {
-    if (bamt == 0) {
-      val_[w] = lhs.val_[b];
-    } else {
-      val_[w] = (lhs.val_[b+1] << bamt) | ((lhs.val_[b] & mask) >> mamt);
-    }
+  // Both cases work from highest to lowest order, so it's safe for lhs to be
+  // this value.
+  if (bamt == 0) {
+    std::copy_backward(lhs.val_.begin(), lhs.val_.begin()+cnt, val_.end());
+  } else {
+    // Everything above the bottom word is a funnel shift of adjacent words
+    BitsKernels<T>::funnel_shl(val_.data()+delta+1, lhs.val_.data()+1, lhs.val_.data(), cnt-1, bamt);
+    // There's one more block to build where bottom is implicitly zero
+    val_[delta] = lhs.val_[0] << bamt;
   }
-  // There's one more block to build where bottom is implicitly zero
-  val_[w--] = (bamt == 0) ? static_cast<T>(0) : (lhs.val_[0] << bamt);
   // Everything else is zero
-  for (; w >= 0; --w) {
-    val_[w] = static_cast<T>(0);
-  }
+  std::fill(val_.begin(), val_.begin()+delta, static_cast<T>(0));
   // Trim the top and we're done
   trim();
 }
@@ -1679,6 +1810,20 @@ inline void BitsBase<T, BT, ST>::bitwise_sxr_const(const BitsBase& lhs, size_t s
   assert(!is_real() && !lhs.is_real());
   assert(size() == lhs.size());
 
+  // Fast Path: Single word values. Negative values are sign extended to a
+  // full word so that we can rely on the native arithmetic shift.
+  if (val_.size() == 1) {
+    const auto neg = arith && lhs.get(size_-1);
+    const auto val = neg ? (lhs.val_[0] | (static_cast<T>(-1) << (size_-1))) : lhs.val_[0];
+    if (samt >= size_) {
+      val_[0] = neg ? static_cast<T>(-1) : static_cast<T>(0);
+    } else {
+      val_[0] = neg ? static_cast<T>(static_cast<ST>(val) >> samt) : (val >> samt);
+    }
+    trim();
+    return;
+  }
+
   // Easy Case: We're not actually shifting
   if (samt == 0) {
     for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
@@ -1692,53 +1837,167 @@ inline void BitsBase<T, BT, ST>::bitwise_sxr_const(const BitsBase& lhs, size_t s
     for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
       val_[i] = val;
     }
+    trim();
     return;
   }
 
-  // This algorithm works from lowest to highest order, one word at a time
-  // word: The current word we're looking at
-  // top/bottom: The words that will be shifted into word; word can equal bottom
-
   // Is the highest order bit a 1 and do we care?
   const auto idx = (size_-1) % bits_per_word();
   const auto hob = arith && ((lhs.val_.back() & (static_cast<T>(1) << idx)) != 0); 
-  // How many words ahead is top?
-  const auto delta = ((samt + bits_per_word()) - 1) / bits_per_word();
-  // How many bits are we taking from top and shifting bottom?
-  const auto bamt = samt % bits_per_word();
-  // Create a mask for extracting the lowest bamt bits from top
-  const auto mamt = bits_per_word() - bamt;
-  const auto mask = (static_cast<T>(1) << bamt) - 1;
   // val_ is an array of unsigned values. If we are working with signed values,
   // we want the top bits of the top-most word to be filled with ones.
-  // This is only used in the case where hob is set and the top word is not
-  // completely full.
-  const auto upper_most_word = ((static_cast<T>(-1) << idx) | lhs.val_.back());
+  const auto top = hob ? ((static_cast<T>(-1) << idx) | lhs.val_.back()) : lhs.val_.back();
+  const auto pad = hob ? static_cast<T>(-1) : static_cast<T>(0);
 
-  // Work our way up until top goes out of range
-  size_t w = 0;
-  for (size_t t = w+delta, te = val_.size(); t < te; ++w, ++t) {
-    if (bamt == 0) {
-      val_[w] = lhs.val_[t];
-    } else {
-      const auto upper_most = (t == (val_.size() - 1)) ? upper_most_word : lhs.val_[t];
-      val_[w] = (lhs.val_[t-1] >> bamt) | ((upper_most & mask) << mamt);
-    }
-  }
-  // There's one more block to build where top is implicitly zero
-  if (hob) {
-    val_[w++] = (bamt == 0) ? static_cast<T>(-1) : ((upper_most_word >> bamt) | (mask << mamt));
+  // How many whole words are we shifting and how many bits are left over?
+  const auto delta = samt / bits_per_word();
+  const auto bamt = samt % bits_per_word();
+  const auto mamt = bits_per_word() - bamt;
+  // How many words of lhs survive the shift?
+  const auto cnt = val_.size() - delta;
+
+  // Both cases work from lowest to highest order, so it's safe for lhs to be
+  // this value.
+  if (bamt == 0) {
+    std::copy(lhs.val_.begin()+delta, lhs.val_.end()-1, val_.begin());
+    val_[cnt-1] = top;
   } else {
-    val_[w++] = (bamt == 0) ? static_cast<T>(0) : (lhs.val_.back() >> bamt);
+    // Everything below the top two words is a funnel shift of adjacent words
+    if (cnt >= 2) {
+      BitsKernels<T>::funnel_shr(val_.data(), lhs.val_.data()+delta, lhs.val_.data()+delta+1, cnt-2, bamt);
+      val_[cnt-2] = (lhs.val_[val_.size()-2] >> bamt) | (top << mamt);
+    }
+    // There's one more block to build where top is implicitly zero or ones
+    val_[cnt-1] = (top >> bamt) | (pad << mamt);
   }
   // Everything else is zero or padded 1s
-  for (size_t we = val_.size(); w < we; ++w) {
-    val_[w] = hob ? static_cast<T>(-1) : static_cast<T>(0);
-  }
+  std::fill(val_.begin()+cnt, val_.end(), pad);
   // Trim since we could have introduced trailing 1s
   trim();
 }
 
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::divide_words(const BitsBase& lhs, const BitsBase& rhs, bool mod) {
+  const auto S = val_.size();
+  const auto W = bits_per_word();
+
+  // Divide magnitudes and fix up signs at the end. The quotient is negative
+  // if the signs of the inputs differ, the remainder takes the sign of the
+  // dividend.
+  const auto sgn = (lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED);
+  const auto lneg = sgn && lhs.is_neg_signed();
+  const auto rneg = sgn && rhs.is_neg_signed();
+  BitsBase u = lhs;
+  if (lneg) {
+    u.invert_add_one();
+  }
+  BitsBase v = rhs;
+  if (rneg) {
+    v.invert_add_one();
+  }
+
+  // How many significant words are there in the divisor? We don't have an x
+  // value, so division by zero evaluates to zero.
+  auto n = S;
+  while ((n > 0) && (v.val_[n-1] == 0)) {
+    --n;
+  }
+  std::fill(val_.begin(), val_.end(), static_cast<T>(0));
+  if (n == 0) {
+    return;
+  }
+
+  // Scratch space, inline up to 256 bits
+  using Scratch = SmallVector<T, 32/sizeof(T)>;
+  Scratch q(S, 0);
+  Scratch r(S, 0);
+
+  // Easy Case: Short division by a single word
+  if (n == 1) {
+    BT rem = 0;
+    for (size_t i = S; i-- > 0; ) {
+      const auto num = (rem << W) | u.val_[i];
+      q[i] = static_cast<T>(num / v.val_[0]);
+      rem = num % v.val_[0];
+    }
+    r[0] = static_cast<T>(rem);
+  }
+  // Hard Case: Knuth's Algorithm D (TAOCP Vol. 2, 4.3.1). Normalize so that
+  // the top word of the divisor has its high bit set, which bounds the error
+  // in each estimated quotient word by two.
+  else {
+    const auto s = static_cast<size_t>(__builtin_clzll(v.val_[n-1])) - (64 - W);
+    Scratch vn(n);
+    Scratch un(S+1);
+    for (size_t i = n-1; i > 0; --i) {
+      vn[i] = (v.val_[i] << s) | ((s == 0) ? 0 : (v.val_[i-1] >> (W-s)));
+    }
+    vn[0] = v.val_[0] << s;
+    un[S] = (s == 0) ? 0 : (u.val_[S-1] >> (W-s));
+    for (size_t i = S-1; i > 0; --i) {
+      un[i] = (u.val_[i] << s) | ((s == 0) ? 0 : (u.val_[i-1] >> (W-s)));
+    }
+    un[0] = u.val_[0] << s;
+
+    const auto b = static_cast<BT>(1) << W;
+    for (size_t j = S-n+1; j-- > 0; ) {
+      // Estimate the next quotient word from the top two words of the
+      // remainder and refine it using the next word of the divisor.
+      const auto num = (static_cast<BT>(un[j+n]) << W) | un[j+n-1];
+      auto qhat = num / vn[n-1];
+      auto rhat = num % vn[n-1];
+      while ((qhat >= b) || (qhat * vn[n-2] > ((rhat << W) | un[j+n-2]))) {
+        --qhat;
+        rhat += vn[n-1];
+        if (rhat >= b) {
+          break;
+        }
+      }
+
+      // Multiply and subtract
+      T carry = 0;
+      T borrow = 0;
+      for (size_t i = 0; i < n; ++i) {
+        const auto p = qhat * vn[i] + carry;
+        carry = static_cast<T>(p >> W);
+        const auto lo = static_cast<T>(p);
+        const auto d = un[i+j] - lo;
+        const auto b1 = (un[i+j] < lo);
+        un[i+j] = d - borrow;
+        borrow = (b1 || (d < borrow)) ? 1 : 0;
+      }
+      const auto d = un[j+n] - carry;
+      const auto b1 = (un[j+n] < carry);
+      un[j+n] = d - borrow;
+      borrow = (b1 || (d < borrow)) ? 1 : 0;
+
+      // If we subtracted too much, add back one multiple of the divisor
+      if (borrow) {
+        --qhat;
+        BT sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+          sum = static_cast<BT>(un[i+j]) + vn[i] + (sum >> W);
+          un[i+j] = static_cast<T>(sum);
+        }
+        un[j+n] += static_cast<T>(sum >> W);
+      }
+      q[j] = static_cast<T>(qhat);
+    }
+
+    // Unnormalize the remainder
+    for (size_t i = 0; i < n; ++i) {
+      r[i] = (un[i] >> s) | ((s == 0) ? 0 : (un[i+1] << (W-s)));
+    }
+  }
+
+  const auto& res = mod ? r : q;
+  std::copy(res.begin(), res.end(), val_.begin());
+  if (mod ? lneg : (lneg != rneg)) {
+    invert_add_one();
+  }
+  trim();
+}
+
 template <typename T, typename BT, typename ST>
 inline T BitsBase<T, BT, ST>::signed_get(size_t n) const {
   // Easiest Case: This is an unisgned value, so return what's in range or zero
@@ -0,0 +1,440 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_BITS_KERNELS_H
+#define CASCADE_SRC_COMMON_BITS_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CASCADE_BITS_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace cascade {
+
+// This class provides the word-array loops which back the multi-word paths
+// in Bits. On x86_64 hosts which support AVX2 (determined once, at runtime)
+// these loops process 256 bits at a time; everywhere else they fall back on
+// scalar implementations. Arrays shorter than a single vector always take the
+// scalar path.
+//
+// Destination arrays may alias source arrays. Funnel shifts additionally
+// support the overlapping, offset aliasing that occurs when shifting in place:
+// left shifts work from high to low order words, right shifts from low to
+// high.
+
+template <typename T>
+struct BitsKernels {
+  static_assert((sizeof(T) == 4) || (sizeof(T) == 8), "BitsKernels is only defined for 32- and 64-bit words");
+
+  // Word-wise logic: d[i] = a[i] op b[i]
+  static void bitwise_and(T* d, const T* a, const T* b, size_t n);
+  static void bitwise_or(T* d, const T* a, const T* b, size_t n);
+  static void bitwise_xor(T* d, const T* a, const T* b, size_t n);
+  static void bitwise_xnor(T* d, const T* a, const T* b, size_t n);
+  static void bitwise_not(T* d, const T* a, size_t n);
+
+  // Reductions
+  static bool all_ones(const T* a, size_t n);
+  static bool any(const T* a, size_t n);
+  static bool equal(const T* a, const T* b, size_t n);
+  static size_t popcount(const T* a, size_t n);
+
+  // Funnel shifts for 0 < s < bits per word:
+  // shl: d[i] = (hi[i] << s) | (lo[i] >> (W-s)), computed from n-1 down to 0
+  // shr: d[i] = (lo[i] >> s) | (hi[i] << (W-s)), computed from 0 up to n-1
+  static void funnel_shl(T* d, const T* hi, const T* lo, size_t n, size_t s);
+  static void funnel_shr(T* d, const T* lo, const T* hi, size_t n, size_t s);
+
+  private:
+    // Number of words in a 256-bit vector
+    static constexpr size_t lanes_ = 32 / sizeof(T);
+    // Number of bits in a word
+    static constexpr size_t bits_ = 8 * sizeof(T);
+
+    // Returns true if the vector path should be used for n words
+    static bool use_avx2(size_t n);
+
+#ifdef CASCADE_BITS_KERNELS_AVX2
+    static bool has_avx2();
+
+    enum class Logic : uint8_t {
+      AND = 0,
+      OR,
+      XOR,
+      XNOR,
+      NOT
+    };
+
+    template <Logic L>
+    __attribute__((target("avx2"))) static size_t avx2_logic(T* d, const T* a, const T* b, size_t n);
+    __attribute__((target("avx2"))) static bool avx2_all_ones(const T* a, size_t n);
+    __attribute__((target("avx2"))) static bool avx2_any(const T* a, size_t n);
+    __attribute__((target("avx2"))) static bool avx2_equal(const T* a, const T* b, size_t n);
+    __attribute__((target("avx2,popcnt"))) static size_t avx2_popcount(const T* a, size_t n);
+    __attribute__((target("avx2"))) static size_t avx2_funnel_shl(T* d, const T* hi, const T* lo, size_t n, size_t s);
+    __attribute__((target("avx2"))) static size_t avx2_funnel_shr(T* d, const T* lo, const T* hi, size_t n, size_t s);
+    __attribute__((target("avx2"))) static __m256i avx2_sll(__m256i x, size_t s);
+    __attribute__((target("avx2"))) static __m256i avx2_srl(__m256i x, size_t s);
+#endif
+};
+
+template <typename T>
+inline void BitsKernels<T>::bitwise_and(T* d, const T* a, const T* b, size_t n) {
+  size_t i = 0;
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    i = avx2_logic<Logic::AND>(d, a, b, n);
+  }
+#endif
+  for (; i < n; ++i) {
+    d[i] = a[i] & b[i];
+  }
+}
+
+template <typename T>
+inline void BitsKernels<T>::bitwise_or(T* d, const T* a, const T* b, size_t n) {
+  size_t i = 0;
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    i = avx2_logic<Logic::OR>(d, a, b, n);
+  }
+#endif
+  for (; i < n; ++i) {
+    d[i] = a[i] | b[i];
+  }
+}
+
+template <typename T>
+inline void BitsKernels<T>::bitwise_xor(T* d, const T* a, const T* b, size_t n) {
+  size_t i = 0;
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    i = avx2_logic<Logic::XOR>(d, a, b, n);
+  }
+#endif
+  for (; i < n; ++i) {
+    d[i] = a[i] ^ b[i];
+  }
+}
+
+template <typename T>
+inline void BitsKernels<T>::bitwise_xnor(T* d, const T* a, const T* b, size_t n) {
+  size_t i = 0;
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    i = avx2_logic<Logic::XNOR>(d, a, b, n);
+  }
+#endif
+  for (; i < n; ++i) {
+    d[i] = ~(a[i] ^ b[i]);
+  }
+}
+
+template <typename T>
+inline void BitsKernels<T>::bitwise_not(T* d, const T* a, size_t n) {
+  size_t i = 0;
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    i = avx2_logic<Logic::NOT>(d, a, a, n);
+  }
+#endif
+  for (; i < n; ++i) {
+    d[i] = ~a[i];
+  }
+}
+
+template <typename T>
+inline bool BitsKernels<T>::all_ones(const T* a, size_t n) {
+  // Most values are decided by their first word; don't pay for dispatch
+  if ((n > 0) && (a[0] != static_cast<T>(-1))) {
+    return false;
+  }
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    return avx2_all_ones(a, n);
+  }
+#endif
+  for (size_t i = 0; i < n; ++i) {
+    if (a[i] != static_cast<T>(-1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+inline bool BitsKernels<T>::any(const T* a, size_t n) {
+  // Most values are decided by their first word; don't pay for dispatch
+  if ((n > 0) && (a[0] != 0)) {
+    return true;
+  }
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    return avx2_any(a, n);
+  }
+#endif
+  for (size_t i = 0; i < n; ++i) {
+    if (a[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+inline bool BitsKernels<T>::equal(const T* a, const T* b, size_t n) {
+  // Most values are decided by their first word; don't pay for dispatch
+  if ((n > 0) && (a[0] != b[0])) {
+    return false;
+  }
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    return avx2_equal(a, b, n);
+  }
+#endif
+  for (size_t i = 0; i < n; ++i) {
+    if (a[i] != b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+inline size_t BitsKernels<T>::popcount(const T* a, size_t n) {
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    return avx2_popcount(a, n);
+  }
+#endif
+  size_t cnt = 0;
+  for (size_t i = 0; i < n; ++i) {
+    cnt += __builtin_popcountll(a[i]);
+  }
+  return cnt;
+}
+
+template <typename T>
+inline void BitsKernels<T>::funnel_shl(T* d, const T* hi, const T* lo, size_t n, size_t s) {
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    n = avx2_funnel_shl(d, hi, lo, n, s);
+  }
+#endif
+  for (size_t i = n; i-- > 0; ) {
+    d[i] = (hi[i] << s) | (lo[i] >> (bits_-s));
+  }
+}
+
+template <typename T>
+inline void BitsKernels<T>::funnel_shr(T* d, const T* lo, const T* hi, size_t n, size_t s) {
+  size_t i = 0;
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  if (use_avx2(n)) {
+    i = avx2_funnel_shr(d, lo, hi, n, s);
+  }
+#endif
+  for (; i < n; ++i) {
+    d[i] = (lo[i] >> s) | (hi[i] << (bits_-s));
+  }
+}
+
+template <typename T>
+inline bool BitsKernels<T>::use_avx2(size_t n) {
+#ifdef CASCADE_BITS_KERNELS_AVX2
+  return (n >= lanes_) && has_avx2();
+#else
+  (void) n;
+  return false;
+#endif
+}
+
+#ifdef CASCADE_BITS_KERNELS_AVX2
+
+template <typename T>
+inline bool BitsKernels<T>::has_avx2() {
+  static const bool res = __builtin_cpu_supports("avx2");
+  return res;
+}
+
+template <typename T>
+template <typename BitsKernels<T>::Logic L>
+inline size_t BitsKernels<T>::avx2_logic(T* d, const T* a, const T* b, size_t n) {
+  const auto ones = _mm256_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + lanes_ <= n; i += lanes_) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+    const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b+i));
+    __m256i z;
+    switch (L) {
+      case Logic::AND:
+        z = _mm256_and_si256(x, y);
+        break;
+      case Logic::OR:
+        z = _mm256_or_si256(x, y);
+        break;
+      case Logic::XOR:
+        z = _mm256_xor_si256(x, y);
+        break;
+      case Logic::XNOR:
+        z = _mm256_xor_si256(_mm256_xor_si256(x, y), ones);
+        break;
+      default:
+        z = _mm256_xor_si256(x, ones);
+        break;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d+i), z);
+  }
+  return i;
+}
+
+template <typename T>
+inline bool BitsKernels<T>::avx2_all_ones(const T* a, size_t n) {
+  const auto ones = _mm256_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + lanes_ <= n; i += lanes_) {
+    if (!_mm256_testc_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i)), ones)) {
+      return false;
+    }
+  }
+  for (; i < n; ++i) {
+    if (a[i] != static_cast<T>(-1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+inline bool BitsKernels<T>::avx2_any(const T* a, size_t n) {
+  size_t i = 0;
+  for (; i + lanes_ <= n; i += lanes_) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+    if (!_mm256_testz_si256(x, x)) {
+      return true;
+    }
+  }
+  for (; i < n; ++i) {
+    if (a[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+inline bool BitsKernels<T>::avx2_equal(const T* a, const T* b, size_t n) {
+  size_t i = 0;
+  for (; i + lanes_ <= n; i += lanes_) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+    const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b+i));
+    const auto z = _mm256_xor_si256(x, y);
+    if (!_mm256_testz_si256(z, z)) {
+      return false;
+    }
+  }
+  for (; i < n; ++i) {
+    if (a[i] != b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+inline size_t BitsKernels<T>::avx2_popcount(const T* a, size_t n) {
+  // Hardware popcount, 64 bits at a time, with four independent accumulators
+  // to hide the instruction's latency.
+  const auto* c = reinterpret_cast<const uint8_t*>(a);
+  const auto bytes = n * sizeof(T);
+  uint64_t cnt[4] = {0, 0, 0, 0};
+  size_t i = 0;
+  for (; i + 32 <= bytes; i += 32) {
+    uint64_t w[4];
+    memcpy(w, c+i, 32);
+    cnt[0] += _mm_popcnt_u64(w[0]);
+    cnt[1] += _mm_popcnt_u64(w[1]);
+    cnt[2] += _mm_popcnt_u64(w[2]);
+    cnt[3] += _mm_popcnt_u64(w[3]);
+  }
+  for (; i < bytes; i += sizeof(T)) {
+    T w;
+    memcpy(&w, c+i, sizeof(T));
+    cnt[0] += _mm_popcnt_u64(w);
+  }
+  return cnt[0] + cnt[1] + cnt[2] + cnt[3];
+}
+
+template <typename T>
+inline size_t BitsKernels<T>::avx2_funnel_shl(T* d, const T* hi, const T* lo, size_t n, size_t s) {
+  // Work from the top down and return the number of low order words which
+  // still need to be computed.
+  for (; n >= lanes_; n -= lanes_) {
+    const auto i = n - lanes_;
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi+i));
+    const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lo+i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d+i), _mm256_or_si256(avx2_sll(x, s), avx2_srl(y, bits_-s)));
+  }
+  return n;
+}
+
+template <typename T>
+inline size_t BitsKernels<T>::avx2_funnel_shr(T* d, const T* lo, const T* hi, size_t n, size_t s) {
+  // Work from the bottom up and return the number of words computed
+  size_t i = 0;
+  for (; i + lanes_ <= n; i += lanes_) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lo+i));
+    const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi+i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d+i), _mm256_or_si256(avx2_srl(x, s), avx2_sll(y, bits_-s)));
+  }
+  return i;
+}
+
+template <typename T>
+inline __m256i BitsKernels<T>::avx2_sll(__m256i x, size_t s) {
+  const auto cnt = _mm_cvtsi64_si128(static_cast<long long>(s));
+  return (sizeof(T) == 8) ? _mm256_sll_epi64(x, cnt) : _mm256_sll_epi32(x, cnt);
+}
+
+template <typename T>
+inline __m256i BitsKernels<T>::avx2_srl(__m256i x, size_t s) {
+  const auto cnt = _mm_cvtsi64_si128(static_cast<long long>(s));
+  return (sizeof(T) == 8) ? _mm256_srl_epi64(x, cnt) : _mm256_srl_epi32(x, cnt);
+}
+
+#endif
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,159 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_POLLER_H
+#define CASCADE_SRC_COMMON_POLLER_H
+
+#include <algorithm>
+#include <vector>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#else
+#include <poll.h>
+#endif
+
+namespace cascade {
+
+// This class reports which of a set of file descriptors are ready to be read
+// from. On linux it's backed by epoll, so the cost of a call to wait() depends
+// only on the number of descriptors which are ready. Everywhere else it falls
+// back on poll.
+
+class Poller {
+  public:
+    Poller();
+    ~Poller();
+
+    // Adds or removes a file descriptor from the set being watched. Returns
+    // false if the descriptor couldn't be added or removed.
+    bool insert(int fd);
+    bool erase(int fd);
+
+    // Blocks for up to timeout milliseconds, and then returns the descriptors
+    // which are ready to be read from. The result is valid until the next call.
+    const std::vector<int>& wait(int timeout);
+
+  private:
+#ifdef __linux__
+    int fd_;
+    std::vector<struct epoll_event> events_;
+#else
+    std::vector<struct pollfd> fds_;
+#endif
+    std::vector<int> ready_;
+};
+
+#ifdef __linux__
+
+inline Poller::Poller() {
+  fd_ = epoll_create1(0);
+}
+
+inline Poller::~Poller() {
+  if (fd_ != -1) {
+    ::close(fd_);
+  }
+}
+
+inline bool Poller::insert(int fd) {
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.fd = fd;
+  if ((fd_ == -1) || (epoll_ctl(fd_, EPOLL_CTL_ADD, fd, &ev) != 0)) {
+    return false;
+  }
+  events_.resize(events_.size()+1);
+  return true;
+}
+
+inline bool Poller::erase(int fd) {
+  if (epoll_ctl(fd_, EPOLL_CTL_DEL, fd, nullptr) != 0) {
+    return false;
+  }
+  events_.resize(events_.size()-1);
+  return true;
+}
+
+inline const std::vector<int>& Poller::wait(int timeout) {
+  ready_.clear();
+  if (events_.empty()) {
+    return ready_;
+  }
+  const auto n = epoll_wait(fd_, events_.data(), events_.size(), timeout);
+  for (auto i = 0; i < n; ++i) {
+    ready_.push_back(events_[i].data.fd);
+  }
+  return ready_;
+}
+
+#else
+
+inline Poller::Poller() { }
+
+inline Poller::~Poller() { }
+
+inline bool Poller::insert(int fd) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  fds_.push_back(pfd);
+  return true;
+}
+
+inline bool Poller::erase(int fd) {
+  const auto itr = std::remove_if(fds_.begin(), fds_.end(), [fd](const struct pollfd& pfd) {
+    return pfd.fd == fd;
+  });
+  if (itr == fds_.end()) {
+    return false;
+  }
+  fds_.erase(itr, fds_.end());
+  return true;
+}
+
+inline const std::vector<int>& Poller::wait(int timeout) {
+  ready_.clear();
+  if (::poll(fds_.data(), fds_.size(), timeout) > 0) {
+    for (const auto& pfd : fds_) {
+      if (pfd.revents != 0) {
+        ready_.push_back(pfd.fd);
+      }
+    }
+  }
+  return ready_;
+}
+
+#endif
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,302 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+
+#ifndef CASCADE_SRC_COMMON_SMALL_VECTOR_H
+#define CASCADE_SRC_COMMON_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cassert>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+namespace cascade {
+
+// This class is a variant of Vector which stores up to N elements inline and
+// only falls back on the heap when a call to resize exceeds that capacity.
+// Like Vector, it assumes no more than 2^16 elements, and won't
+// over-provision when a call to resize exceeds capacity. This class is only
+// defined for trivially copyable types.
+
+template <typename T, size_t N>
+class SmallVector {
+  public:
+    typedef size_t size_type;
+    typedef ptrdiff_t	difference_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* iterator;
+    typedef const T* const_iterator; 
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T	value_type;
+
+    SmallVector();
+    SmallVector(size_type n, const value_type& v = value_type());
+    SmallVector(const SmallVector& rhs);
+    SmallVector(SmallVector&& rhs);
+    SmallVector& operator=(const SmallVector& rhs);
+    SmallVector& operator=(SmallVector&& rhs);
+    ~SmallVector();
+
+    iterator begin();
+    const_iterator begin() const;
+    iterator end();
+    const_iterator end() const;
+
+    size_type size() const;
+    void resize(size_type n, const value_type& v = value_type());
+    size_type capacity() const;
+    bool empty() const;
+    void reserve(size_type n);
+
+    reference operator[](size_t idx);
+    const_reference operator[](size_t idx) const;
+
+    reference front();
+    const_reference front() const;
+    reference back();
+    const_reference back() const;
+    pointer data();
+    const_pointer data() const;
+
+    void push_back(const value_type& v);
+    void pop_back();
+    void clear();
+
+  private:
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVector is only defined for trivially copyable types");
+    static_assert((N > 0) && (N <= 0xffffu), "SmallVector requires 0 < N < 2^16");
+
+    T* ts_;
+    uint16_t size_;
+    uint16_t capacity_;    
+    T buf_[N];
+
+    // Returns true if this vector is using inline storage
+    bool is_inline() const;
+};
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::SmallVector() {
+  ts_ = buf_;
+  size_ = 0;
+  capacity_ = N;
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::SmallVector(size_type n, const value_type& v) : SmallVector() {
+  resize(n, v);
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::SmallVector(const SmallVector& rhs) : SmallVector() {
+  reserve(rhs.size_);
+  std::copy(rhs.begin(), rhs.end(), ts_);
+  size_ = rhs.size_;
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::SmallVector(SmallVector&& rhs) : SmallVector() {
+  *this = std::move(rhs);
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>& SmallVector<T,N>::operator=(const SmallVector& rhs) {
+  if (this != &rhs) {
+    reserve(rhs.size_);
+    std::copy(rhs.begin(), rhs.end(), ts_);
+    size_ = rhs.size_;
+  }
+  return *this;
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>& SmallVector<T,N>::operator=(SmallVector&& rhs) {
+  if (this == &rhs) {
+    return *this;
+  }
+  // Inline storage can't be stolen, so we'll need to copy it
+  if (rhs.is_inline()) {
+    return *this = static_cast<const SmallVector&>(rhs);
+  }
+  if (!is_inline()) {
+    delete[] ts_;
+  }
+  ts_ = rhs.ts_;
+  size_ = rhs.size_;
+  capacity_ = rhs.capacity_;
+
+  rhs.ts_ = rhs.buf_;
+  rhs.size_ = 0;
+  rhs.capacity_ = N;
+
+  return *this;
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::~SmallVector() {
+  if (!is_inline()) {
+    delete[] ts_;
+  }
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::iterator SmallVector<T,N>::begin() {
+  return ts_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_iterator SmallVector<T,N>::begin() const {
+  return ts_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::iterator SmallVector<T,N>::end() {
+  return ts_ + size_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_iterator SmallVector<T,N>::end() const {
+  return ts_ + size_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::size_type SmallVector<T,N>::size() const {
+  return size_;
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::resize(size_type n, const value_type& v) {
+  assert(n <= static_cast<size_t>(0xffffu));
+  if (n > size_) {
+    reserve(n);
+    std::fill(ts_ + size_, ts_ + n, v);
+  }
+  size_ = n;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::size_type SmallVector<T,N>::capacity() const {
+  return capacity_;
+}
+
+template <typename T, size_t N>
+inline bool SmallVector<T,N>::empty() const {
+  return size_ == 0;
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::reserve(size_type n) {
+  assert(n <= static_cast<size_t>(0xffffu));
+  if (capacity_ >= n) {
+    return;
+  }
+  auto new_ts = new T[n];
+  std::copy(ts_, ts_ + size_, new_ts);
+  if (!is_inline()) {
+    delete[] ts_;
+  }
+  ts_ = new_ts; 
+  capacity_ = n;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::reference SmallVector<T,N>::operator[](size_t idx) {
+  assert(idx < size_);
+  return ts_[idx];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_reference SmallVector<T,N>::operator[](size_t idx) const {
+  assert(idx < size_);
+  return ts_[idx];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::reference SmallVector<T,N>::front() {
+  assert(size_ > 0);
+  return ts_[0];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_reference SmallVector<T,N>::front() const {
+  assert(size_ > 0);
+  return ts_[0];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::reference SmallVector<T,N>::back() {
+  assert(size_ > 0);
+  return ts_[size_ - 1];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_reference SmallVector<T,N>::back() const {
+  assert(size_ > 0);
+  return ts_[size_ - 1];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::pointer SmallVector<T,N>::data() {
+  return ts_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_pointer SmallVector<T,N>::data() const {
+  return ts_;
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::push_back(const value_type& v) {
+  if (size_ == capacity_) {
+    reserve(size_ + 1);
+  }
+  ts_[size_++] = v;
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::pop_back() {
+  assert(size_ > 0);
+  --size_;
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::clear() {
+  size_ = 0;
+}
+
+template <typename T, size_t N>
+inline bool SmallVector<T,N>::is_inline() const {
+  return ts_ == buf_;
+}
+
+} // namespace cascade
+
+#endif
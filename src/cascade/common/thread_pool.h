@@ -31,11 +31,16 @@
 #ifndef CASCADE_SRC_COMMON_THREAD_POOL_H
 #define CASCADE_SRC_COMMON_THREAD_POOL_H
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <stack>
 #include <thread>
 #include <vector>
 #include "common/thread.h"
@@ -45,12 +50,55 @@ namespace cascade {
 // This class represents an abstract pool of compute. It is provided so that
 // objects can schedule Jobs (ie: methods returning void which can be handled
 // asynchronously) and block on their completion.
+//
+// Each thread owns a queue for each priority class. Jobs scheduled by a pool
+// thread are placed on its own queue, and all others are dealt out round
+// robin. Threads run their own most recent job first, and steal the oldest job
+// from another thread when they run out. No job is started while a job of a
+// higher priority is waiting. Jobs may be scheduled with a Token, and jobs
+// whose token is cancelled before they start are discarded.
 
 class ThreadPool : public Thread {
   public:
     // Job Typedef:
     typedef std::function<void()> Job;
 
+    // Priority Classes:
+    enum class Priority : uint8_t {
+      HIGH = 0,
+      NORMAL,
+      LOW
+    };
+
+    // Cancellation Tokens:
+    //
+    // Tokens are cheap to copy, and copies share state. Cancelling a token
+    // can't interrupt a job which has already started, but a job can poll the
+    // token that it was scheduled with.
+    class Token {
+      public:
+        Token();
+        void cancel();
+        bool is_cancelled() const;
+      private:
+        friend class ThreadPool;
+        explicit Token(std::nullptr_t);
+        std::shared_ptr<std::atomic<bool>> flag_;
+    };
+
+    // Statistics:
+    struct Stats {
+      // Jobs which are waiting to run, and the most that have ever been
+      size_t depth;
+      size_t max_depth;
+      // Jobs which ran, and jobs which were discarded 
+      size_t executed;
+      size_t cancelled;
+      // Time between scheduling and starting a job, in microseconds
+      uint64_t total_wait;
+      uint64_t max_wait;
+    };
+
     // Constructors:
     ThreadPool();
     ~ThreadPool() override = default;
@@ -60,6 +108,14 @@ class ThreadPool : public Thread {
 
     // Schedule a new job. Ignores jobs scheduled between stop() and start().
     void insert(Job job);
+    // Identical to the single argument form, but with priority p.
+    void insert(Job job, Priority p);
+    // Identical to the two argument form, but job is discarded if t is
+    // cancelled before it starts. If alt is provided, it is run in its place.
+    void insert(Job job, Priority p, const Token& t, Job alt = Job());
+
+    // Returns a snapshot of this pool's statistics. This method is thread-safe.
+    Stats get_stats();
 
   protected:
     // Start a new pool of num_threads_ threads.
@@ -68,68 +124,192 @@ class ThreadPool : public Thread {
     void stop_logic() override;
   
   private:
+    // Queue Entries:
+    struct Entry {
+      Job job;
+      Job alt;
+      Token token = Token(nullptr);
+      std::chrono::steady_clock::time_point time;
+    };
+    // Per-Thread Queues:
+    struct Queue {
+      std::mutex lock;
+      std::deque<Entry> jobs[3];
+    };
+
     std::mutex lock_;
     std::condition_variable cv_;
 
     size_t num_threads_;
     std::vector<std::thread> threads_;
-    std::stack<Job> jobs_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::atomic<int64_t> pending_;
+    std::atomic<size_t> next_;
+
+    std::mutex stats_lock_;
+    Stats stats_;
+
+    // Returns the index of the calling thread's queue, or -1 if the calling
+    // thread doesn't belong to this pool.
+    int self() const;
+    static std::pair<const ThreadPool*, int>& local();
 
-    std::pair<bool, Job> get();
+    bool get(size_t idx, Entry& e);
+    void record(const Entry& e, bool cancelled);
 };
 
+inline ThreadPool::Token::Token() : flag_(std::make_shared<std::atomic<bool>>(false)) { }
+
+inline ThreadPool::Token::Token(std::nullptr_t) : flag_(nullptr) { }
+
+inline void ThreadPool::Token::cancel() {
+  if (flag_ != nullptr) {
+    *flag_ = true;
+  }
+}
+
+inline bool ThreadPool::Token::is_cancelled() const {
+  return (flag_ != nullptr) && *flag_;
+}
+
 inline ThreadPool::ThreadPool() : Thread() {
+  pending_ = 0;
+  next_ = 0;
+  stats_ = Stats{0, 0, 0, 0, 0, 0};
   set_num_threads(1);
 }
 
 inline ThreadPool& ThreadPool::set_num_threads(size_t n) {
-  num_threads_ = n;
+  assert(pending_ == 0);
+  num_threads_ = std::max(n, static_cast<size_t>(1));
+  queues_.clear();
+  for (size_t i = 0; i < num_threads_; ++i) {
+    queues_.emplace_back(new Queue());
+  }
   return *this;
 }
 
 inline void ThreadPool::insert(Job job) {
-  {
+  insert(job, Priority::NORMAL, Token(nullptr));
+}
+
+inline void ThreadPool::insert(Job job, Priority p) {
+  insert(job, p, Token(nullptr));
+}
+
+inline void ThreadPool::insert(Job job, Priority p, const Token& t, Job alt) {
+  const auto s = self();
+  const auto idx = (s != -1) ? static_cast<size_t>(s) : (next_++ % queues_.size());
+  // Count the job before publishing it. Once it's in a queue, another thread
+  // can steal it and record it as finished before we'd get the chance.
+  { 
+    std::lock_guard<std::mutex> lg(stats_lock_);
+    stats_.depth++;
+    stats_.max_depth = std::max(stats_.max_depth, stats_.depth);
+  }
+  { 
+    std::lock_guard<std::mutex> lg(queues_[idx]->lock);
+    queues_[idx]->jobs[static_cast<size_t>(p)].push_back({job, alt, t, std::chrono::steady_clock::now()});
+  }
+  { 
     std::lock_guard<std::mutex> lg(lock_);
-    jobs_.push(job);
+    ++pending_;
   }
   cv_.notify_one();
 }
 
+inline ThreadPool::Stats ThreadPool::get_stats() {
+  std::lock_guard<std::mutex> lg(stats_lock_);
+  return stats_;
+}
+
 inline void ThreadPool::run_logic() {
   for (size_t i = 0; i < num_threads_; ++i) {
-    threads_.push_back(std::thread([this]{
-      while (true) {
-        auto job = get();
-        if (job.first) {
-          job.second();
+    threads_.push_back(std::thread([this, i]{
+      local() = std::make_pair(this, static_cast<int>(i));
+      for (Entry e; get(i, e); ) {
+        if (e.token.is_cancelled()) {
+          record(e, true);
+          if (e.alt) {
+            e.alt();
+          }
         } else {
-          return;
+          record(e, false);
+          e.job();
         }
+        e = Entry();
       }
+      local() = std::make_pair(nullptr, -1);
     }));
   }  
 }
 
 inline void ThreadPool::stop_logic() {
+  { 
+    std::lock_guard<std::mutex> lg(lock_);
+  }
   cv_.notify_all();
   for (auto& t : threads_) {
     t.join(); 
   }
-  assert(jobs_.empty());
+  assert(pending_ == 0);
   threads_.clear();
 }
 
-inline std::pair<bool, ThreadPool::Job> ThreadPool::get() {
-  std::unique_lock<std::mutex> ul(lock_);
-  while (jobs_.empty() && !stop_requested()) {
-    cv_.wait(ul);
+inline int ThreadPool::self() const {
+  const auto& l = local();
+  return (l.first == this) ? l.second : -1;
+}
+
+inline std::pair<const ThreadPool*, int>& ThreadPool::local() {
+  static thread_local std::pair<const ThreadPool*, int> l(nullptr, -1);
+  return l;
+}
+
+inline bool ThreadPool::get(size_t idx, Entry& e) {
+  const auto n = queues_.size();
+  while (true) {
+    // Look for work in priority order: first our own newest job, then the
+    // oldest job belonging to someone else.
+    for (size_t p = 0; p < 3; ++p) {
+      for (size_t k = 0; k < n; ++k) {
+        auto& q = *queues_[(idx + k) % n];
+        std::lock_guard<std::mutex> lg(q.lock);
+        auto& jobs = q.jobs[p];
+        if (jobs.empty()) {
+          continue;
+        }
+        if (k == 0) {
+          e = std::move(jobs.back());
+          jobs.pop_back();
+        } else {
+          e = std::move(jobs.front());
+          jobs.pop_front();
+        }
+        --pending_;
+        return true;
+      }
+    }
+    // Nothing to do. Go to sleep until there is, or exit if we're stopping.
+    std::unique_lock<std::mutex> ul(lock_);
+    cv_.wait(ul, [this]{return (pending_ > 0) || stop_requested();});
+    if (pending_ <= 0) {
+      return false;
+    }
   }
-  if (!jobs_.empty()) {
-    auto res = jobs_.top();
-    jobs_.pop();
-    return std::make_pair(true, res);
+}
+
+inline void ThreadPool::record(const Entry& e, bool cancelled) {
+  const auto wait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - e.time).count();
+  std::lock_guard<std::mutex> lg(stats_lock_);
+  stats_.depth--;
+  if (cancelled) {
+    stats_.cancelled++;
+  } else {
+    stats_.executed++;
+    stats_.total_wait += wait;
+    stats_.max_wait = std::max(stats_.max_wait, static_cast<uint64_t>(wait));
   }
-  return std::make_pair(false, Job());
 }
 
 } // namespace cascade
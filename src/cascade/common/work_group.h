@@ -0,0 +1,171 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_WORK_GROUP_H
+#define CASCADE_SRC_COMMON_WORK_GROUP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cascade {
+
+// This class represents a fixed group of threads which cooperate with the
+// calling thread to run a batch of independent jobs to completion. Unlike
+// ThreadPool, which is designed for long running asynchronous jobs, it is
+// designed for many short synchronous batches. Jobs are claimed from a shared
+// counter, so threads which finish early pick up work which others have not
+// yet started.
+
+class WorkGroup {
+  public:
+    // Job Typedef:
+    typedef std::function<void(size_t)> Job;
+
+    // Constructors:
+    WorkGroup();
+    ~WorkGroup();
+
+    // Parameter Interface:
+    //
+    // Sets the total number of threads (including the caller) which run jobs.
+    // This method must be called before the first call to run().
+    WorkGroup& set_num_threads(size_t n);
+
+    // Invokes job(0) through job(n-1) and blocks until they have all returned.
+    void run(size_t n, const Job& job);
+
+  private:
+    std::mutex lock_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+
+    size_t num_threads_;
+    std::vector<std::thread> threads_;
+    bool stop_;
+    size_t gen_;
+    size_t active_;
+
+    const Job* job_;
+    size_t n_;
+    std::atomic<size_t> next_;
+
+    void work();
+};
+
+inline WorkGroup::WorkGroup() {
+  num_threads_ = 1;
+  stop_ = false;
+  gen_ = 0;
+  active_ = 0;
+  job_ = nullptr;
+  n_ = 0;
+  next_ = 0;
+}
+
+inline WorkGroup::~WorkGroup() {
+  {
+    std::lock_guard<std::mutex> lg(lock_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& t : threads_) {
+    t.join();
+  }
+}
+
+inline WorkGroup& WorkGroup::set_num_threads(size_t n) {
+  num_threads_ = (n > 0) ? n : 1;
+  return *this;
+}
+
+inline void WorkGroup::run(size_t n, const Job& job) {
+  // Fast Path: Don't wake anyone up if there's nothing to share
+  if ((n <= 1) || (num_threads_ == 1)) {
+    for (size_t i = 0; i < n; ++i) {
+      job(i);
+    }
+    return;
+  }
+
+  // Start helper threads on first use
+  if (threads_.empty()) {
+    for (size_t i = 1; i < num_threads_; ++i) {
+      threads_.push_back(std::thread([this]{
+        for (size_t gen = 0; ; ) {
+          {
+            std::unique_lock<std::mutex> ul(lock_);
+            work_cv_.wait(ul, [this, gen]{return stop_ || (gen_ != gen);});
+            if (stop_) {
+              return;
+            }
+            gen = gen_;
+          }
+          work();
+          {
+            std::lock_guard<std::mutex> lg(lock_);
+            if (--active_ == 0) {
+              done_cv_.notify_one();
+            }
+          }
+        }
+      }));
+    }
+  }
+
+  // Publish the batch, help out, and then wait for stragglers
+  {
+    std::lock_guard<std::mutex> lg(lock_);
+    job_ = &job;
+    n_ = n;
+    next_ = 0;
+    active_ = threads_.size();
+    ++gen_;
+  }
+  work_cv_.notify_all();
+  work();
+
+  std::unique_lock<std::mutex> ul(lock_);
+  done_cv_.wait(ul, [this]{return active_ == 0;});
+}
+
+inline void WorkGroup::work() {
+  for (auto i = next_.fetch_add(1); i < n_; i = next_.fetch_add(1)) {
+    (*job_)(i);
+  }
+}
+
+} // namespace cascade
+
+#endif
@@ -49,6 +49,14 @@ void DataPlane::register_id(const VId id) {
   if (id >= write_buf_.size()) {
     write_buf_.resize(id+1); 
   }
+  if (id >= deferred_.size()) {
+    deferred_.resize(id+1, 0);
+    pending_.resize(id+1, 0);
+  }
+}
+
+size_t DataPlane::size() const {
+  return readers_.size();
 }
 
 void DataPlane::register_reader(Engine* e, VId id) {
@@ -122,9 +130,7 @@ void DataPlane::write(VId id, const Bits* bits) {
     return;
   } 
   write_buf_[id] = *bits;
-  for (auto* e : readers_[id]) {
-    e->read(id, &write_buf_[id]);
-  } 
+  notify(id);
 }
 
 void DataPlane::write(VId id, bool b) {
@@ -135,9 +141,49 @@ void DataPlane::write(VId id, bool b) {
     return;
   } 
   write_buf_[id].flip(0);
+  notify(id);
+}
+
+void DataPlane::defer(VId id) {
+  assert(id < deferred_.size());
+  if (!deferred_[id]) {
+    deferred_[id] = 1;
+    deferred_ids_.push_back(id);
+    sort(deferred_ids_.begin(), deferred_ids_.end());
+  }
+}
+
+void DataPlane::clear_deferred() {
+  // Anything left pending is delivered rather than lost
+  flush();
+  for (auto id : deferred_ids_) {
+    deferred_[id] = 0;
+  }
+  deferred_ids_.clear();
+}
+
+bool DataPlane::flush() {
+  auto res = false;
+  for (auto id : deferred_ids_) {
+    if (pending_[id]) {
+      pending_[id] = 0;
+      for (auto* e : readers_[id]) {
+        e->mark(id, &write_buf_);
+      }
+      res = true;
+    }
+  }
+  return res;
+}
+
+void DataPlane::notify(VId id) {
+  if (deferred_[id]) {
+    pending_[id] = 1;
+    return;
+  }
   for (auto* e : readers_[id]) {
-    e->read(id, &write_buf_[id]);
-  } 
+    e->mark(id, &write_buf_);
+  }
 }
 
 } // namespace cascade
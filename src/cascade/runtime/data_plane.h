@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_RUNTIME_DATA_PLANE_H
 #define CASCADE_SRC_RUNTIME_DATA_PLANE_H
 
+#include <cstdint>
 #include <vector>
 #include "common/bits.h"
 #include "runtime/ids.h"
@@ -43,6 +44,11 @@ class Engine;
 // and the runtime is able to implement the semantics of the verilog reference
 // model.  Although the implementation does not enforce it. Conceptually, there
 // should be exactly one DataPlane in the runtime.
+//
+// Each id owns a single canonical copy of its value. Writes which change that
+// value mark the id dirty in each of its readers rather than copying it to
+// them. Readers pull the value out of the canonical copy the next time they
+// run, and only the engines which were marked are scheduled.
 
 class DataPlane {
   public:
@@ -52,6 +58,8 @@ class DataPlane {
 
     // Id Interface:
     void register_id(VId id);
+    // Returns one more than the largest registered id
+    size_t size() const;
 
     // Reader Interface:
     void register_reader(Engine* e, VId id);
@@ -71,12 +79,30 @@ class DataPlane {
     void write(VId id, const Bits* bits);
     void write(VId id, bool b);
 
+    // Deferral Interface:
+    //
+    // Writes to a deferred id update its value but don't notify its readers
+    // until the next call to flush(). This allows engines which share an id to
+    // write to it from different threads without racing on its readers.
+    void defer(VId id);
+    // Returns every id to its default, undeferred state.
+    void clear_deferred();
+    // Notifies the readers of every deferred id which changed since the last
+    // call to flush(), in id order. Returns true if there were any.
+    bool flush();
+
   private:
     // Registries:
     std::vector<std::vector<Engine*>> readers_;
     std::vector<std::vector<Engine*>> writers_;
-    // Buffers:
+    // Canonical Values:
     std::vector<Bits> write_buf_;
+    // Deferral State:
+    std::vector<uint8_t> deferred_;
+    std::vector<uint8_t> pending_;
+    std::vector<VId> deferred_ids_;
+
+    void notify(VId id);
 };
 
 } // namespace cascade
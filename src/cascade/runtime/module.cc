@@ -31,14 +31,17 @@
 #include "runtime/module.h"
 
 #include <cassert>
+#include <functional>
 #include <iostream>
 #include <mutex>
 #include <sstream>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include "runtime/data_plane.h"
 #include "runtime/isolate.h"
 #include "runtime/runtime.h"
+#include "runtime/tier_policy.h"
 #include "target/compiler.h"
 #include "target/engine.h"
 #include "target/state.h"
@@ -122,6 +125,7 @@ Module::Module(const ModuleDeclaration* psrc, Runtime* rt, Module* parent) {
 
   engine_ = rt_->get_compiler()->compile_stub(rt_->get_next_id(), psrc);
   version_ = 0;
+  hash_ = 0;
 }
 
 Module::~Module() {
@@ -158,22 +162,27 @@ void Module::synchronize(size_t n) {
   for (auto i = psrc_->begin_items()+idx, ie = psrc_->end_items(); i != ie; ++i) {
     (*i)->accept(&inst);
   }
-  // Recompile everything 
+  // Recompile anything that's changed
   for (auto i = iterator(this), ie = end(); i != ie; ++i) {
     const auto ignore = (*i == this) ? (psrc_->size_items() - n) : 0;
-    (*i)->compile_and_replace(ignore);
+    (*i)->compile_and_replace(ignore, false);
   }
   // Synchronize subscriptions with the dataplane. Note that we do this *after*
   // recompilation.  This guarantees that the variable names used by
-  // Isolate::isolate() are deterministic.
+  // Isolate::isolate() are deterministic. Fused modules don't have engines of
+  // their own; their subscriptions belong to the root of their group.
   for (auto i = iterator(this), ie = end(); i != ie; ++i) {
-    for (auto* r : ModuleInfo((*i)->psrc_).reads()) {
-      const auto gid = rt_->get_isolate()->isolate(r);
+    if ((*i)->is_fused()) {
+      continue;
+    }
+    unordered_set<VId> ins;
+    unordered_set<VId> outs;
+    (*i)->get_io(ins, outs);
+    for (auto gid : outs) {
       rt_->get_data_plane()->register_id(gid);
       rt_->get_data_plane()->register_writer((*i)->engine_, gid);
     }
-    for (auto* w : ModuleInfo((*i)->psrc_).writes()) {
-      const auto gid = rt_->get_isolate()->isolate(w);
+    for (auto gid : ins) {
       rt_->get_data_plane()->register_id(gid);
       rt_->get_data_plane()->register_reader((*i)->engine_, gid);
     }
@@ -186,10 +195,14 @@ void Module::rebuild() {
   // Recall that compilation takes over ownership of a module's source code.
   for (auto i = iterator(this), ie = end(); i != ie; ++i) {
     const auto ignore = (*i)->psrc_->size_items();
-    (*i)->compile_and_replace(ignore);
+    (*i)->compile_and_replace(ignore, true);
   }
 }
 
+void Module::demote() {
+  compile_and_replace(psrc_->size_items(), true);
+}
+
 void Module::save(ostream& os) {
   os << size() << endl;
 
@@ -310,8 +323,7 @@ void Module::Instantiator::visit(const ModuleInstantiation* mi) {
 
 
 
-ModuleDeclaration* Module::regenerate_ir_source(size_t ignore) {
-  auto* md = rt_->get_isolate()->isolate(psrc_, ignore);
+void Module::transform_ir_source(ModuleDeclaration* md) {
   const auto* std = md->get_attrs()->get<String>("__std");
   const auto is_logic = (std != nullptr) && (std->get_readable_val() == "logic");
   if (is_logic) {
@@ -326,13 +338,220 @@ ModuleDeclaration* Module::regenerate_ir_source(size_t ignore) {
     DeadCodeEliminate().run(md);
     BlockFlatten().run(md);
   }
-  return md;
 }
 
-void Module::compile_and_replace(size_t ignore) {
-  // Generate new code and bump the sequence number for this module
-  auto* md = regenerate_ir_source(ignore); 
+bool Module::is_fused() const {
+  if (!rt_->get_enable_fusion() || (parent_ == nullptr)) {
+    return false;
+  }
+  const auto* std = psrc_->get_attrs()->get<String>("__std");
+  if ((std == nullptr) || !std->eq("logic")) {
+    return false;
+  }
+  for (const auto* a : {"__std", "__target", "__loc"}) {
+    const auto* lhs = psrc_->get_attrs()->get<String>(a);
+    const auto* rhs = parent_->psrc_->get_attrs()->get<String>(a);
+    if ((lhs == nullptr) || (rhs == nullptr) || !lhs->eq(rhs->get_readable_val())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Module::get_group(vector<Module*>& group) {
+  for (auto* c : children_) {
+    if (c->is_fused()) {
+      group.push_back(c);
+      c->get_group(group);
+    }
+  }
+}
+
+void Module::get_io(unordered_set<VId>& ins, unordered_set<VId>& outs) {
+  vector<Module*> group(1, this);
+  get_group(group);
+
+  unordered_set<VId> produced;
+  unordered_set<VId> consumed;
+  for (auto* m : group) {
+    for (auto* r : ModuleInfo(m->psrc_).reads()) {
+      produced.insert(rt_->get_isolate()->isolate(r));
+    }
+    for (auto* w : ModuleInfo(m->psrc_).writes()) {
+      consumed.insert(rt_->get_isolate()->isolate(w));
+    }
+  }
+  if (group.size() == 1) {
+    ins.insert(consumed.begin(), consumed.end());
+    outs.insert(produced.begin(), produced.end());
+    return;
+  }
+
+  // Ids which are produced and consumed inside of the group only need to be
+  // visible to the dataplane if some other module also touches them.
+  unordered_set<const Module*> members(group.begin(), group.end());
+  auto* top = this;
+  while (top->parent_ != nullptr) {
+    top = top->parent_;
+  }
+  unordered_set<VId> ext_produced;
+  unordered_set<VId> ext_consumed;
+  for (auto i = top->begin(), ie = top->end(); i != ie; ++i) {
+    if (members.find(*i) != members.end()) {
+      continue;
+    }
+    for (auto* r : ModuleInfo((*i)->psrc_).reads()) {
+      ext_produced.insert(rt_->get_isolate()->isolate(r));
+    }
+    for (auto* w : ModuleInfo((*i)->psrc_).writes()) {
+      ext_consumed.insert(rt_->get_isolate()->isolate(w));
+    }
+  }
+  for (auto gid : produced) {
+    if ((consumed.find(gid) == consumed.end()) || (ext_consumed.find(gid) != ext_consumed.end()) || (ext_produced.find(gid) != ext_produced.end())) {
+      outs.insert(gid);
+    }
+  }
+  for (auto gid : consumed) {
+    if ((produced.find(gid) == produced.end()) || (ext_produced.find(gid) != ext_produced.end())) {
+      ins.insert(gid);
+    }
+  }
+}
+
+ModuleDeclaration* Module::isolate(size_t ignore, bool force) {
+  auto* md = rt_->get_isolate()->isolate(psrc_, ignore);
+  vector<Module*> group;
+  get_group(group);
+  if (group.empty()) {
+    return md;
+  }
+
+  // Modules which have already been compiled into this engine have already
+  // run their initial blocks.
+  vector<ModuleDeclaration*> mds(1, md);
+  for (auto* m : group) {
+    const auto m_ignore = (force || (m->version_ > 0)) ? m->psrc_->size_items() : 0;
+    mds.push_back(rt_->get_isolate()->isolate(m->psrc_, m_ignore));
+  }
+  return fuse(mds);
+}
+
+ModuleDeclaration* Module::fuse(vector<ModuleDeclaration*>& mds) {
+  unordered_set<VId> ins;
+  unordered_set<VId> outs;
+  get_io(ins, outs);
+
+  // Isolated variable names are globally unique, so the only declarations
+  // that can collide are ports and the localparams which stand in for
+  // external parameters. When a port appears more than once, keep the
+  // declaration from the module which writes it: that's the one which knows
+  // whether it's a register and what its initial value is.
+  vector<const ModuleItem*> decls;
+  unordered_map<string, size_t> index;
+  for (auto* md : mds) {
+    for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+      string name;
+      if ((*i)->is(Node::Tag::port_declaration)) {
+        name = static_cast<const PortDeclaration*>(*i)->get_decl()->get_id()->front_ids()->get_readable_sid();
+      } else if ((*i)->is(Node::Tag::localparam_declaration)) {
+        name = static_cast<const LocalparamDeclaration*>(*i)->get_id()->front_ids()->get_readable_sid();
+        if (name.substr(0, 3) != "__x") {
+          continue;
+        }
+      } else {
+        continue;
+      }
+      const auto itr = index.find(name);
+      if (itr == index.end()) {
+        index[name] = decls.size();
+        decls.push_back(*i);
+      } else if ((*i)->is(Node::Tag::port_declaration)) {
+        const auto* prev = static_cast<const PortDeclaration*>(decls[itr->second]);
+        const auto* pd = static_cast<const PortDeclaration*>(*i);
+        if ((prev->get_type() == PortDeclaration::Type::INPUT) && (pd->get_type() != PortDeclaration::Type::INPUT)) {
+          decls[itr->second] = pd;
+        }
+      }
+    }
+  }
+
+  auto* res = new ModuleDeclaration(mds[0]->get_attrs()->clone(), mds[0]->get_id()->clone());
+  for (const auto* d : decls) {
+    if (d->is(Node::Tag::localparam_declaration)) {
+      res->push_back_items(d->clone());
+      continue;
+    }
+    // Ports which only connect modules in the group become ordinary variables
+    const auto* pd = static_cast<const PortDeclaration*>(d);
+    const auto* id = pd->get_decl()->get_id();
+    VId vid = 0;
+    stringstream ss(id->front_ids()->get_readable_sid().substr(3));
+    ss >> vid;
+    const auto in = ins.find(vid) != ins.end();
+    const auto out = outs.find(vid) != outs.end();
+    if (!in && !out) {
+      res->push_back_items(pd->get_decl()->clone());
+      continue;
+    }
+    res->push_back_ports(new ArgAssign(nullptr, id->clone()));
+    auto* port = pd->clone();
+    port->set_type((in && out) ? PortDeclaration::Type::INOUT : in ? PortDeclaration::Type::INPUT : PortDeclaration::Type::OUTPUT);
+    res->push_back_items(port);
+  }
+  for (auto* md : mds) {
+    for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+      if ((*i)->is(Node::Tag::port_declaration)) {
+        continue;
+      }
+      if ((*i)->is(Node::Tag::localparam_declaration) && (index.find(static_cast<const LocalparamDeclaration*>(*i)->get_id()->front_ids()->get_readable_sid()) != index.end())) {
+        continue;
+      }
+      res->push_back_items((*i)->clone());
+    }
+    delete md;
+  }
+  mds.clear();
+
+  return res;
+}
+
+void Module::compile_and_replace(size_t ignore, bool force) {
+  // Modules which are fused with their parent are compiled along with it
+  if (is_fused()) {
+    return;
+  }
+  // Generate new code. If it's identical to what we generated last time,
+  // there's no reason to throw away our engine or any jit compilations which
+  // are in flight for it. Isolated code is already in a canonical form, and
+  // the transformations below are deterministic, so there's no need to run
+  // them before comparing.
+  auto* md = isolate(ignore, force);
+  stringstream text;
+  text << md;
+  const auto hash = std::hash<string>()(text.str());
+  if (!force && (version_ > 0) && (hash == hash_)) {
+    delete md;
+    return;
+  }
+
+  // Otherwise, finish generating code and bump the sequence number for this
+  // module and any modules which are fused into it. Once they've been
+  // compiled, their initial blocks have run.
+  transform_ir_source(md);
+  hash_ = hash;
   const auto this_version = ++version_;
+  vector<Module*> group;
+  get_group(group);
+  for (auto* m : group) {
+    ++m->version_;
+  }
+
+  // Anything still in flight for the previous version will be thrown away, so
+  // there's no reason to let it finish. 
+  if (this_version > 1) {
+    rt_->get_compiler()->stop_compile(engine_->get_id());
+  }
 
   // Record human readable name for this module
   const auto* iid = static_cast<const ModuleInstantiation*>(psrc_->get_parent())->get_iid();
@@ -374,8 +593,9 @@ void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const st
   if (pass > 1) {
     DeleteInitial().run(md);
   }
-  // Invariant: First pass for logic must be sw
-  if (std->eq("logic") && (pass == 1) && !md->get_attrs()->get<String>("__target")->eq("sw")) {
+  // Invariant: First pass for logic must be sw (or its bytecode variant)
+  const auto* target = md->get_attrs()->get<String>("__target");
+  if (std->eq("logic") && (pass == 1) && !target->eq("sw") && !target->eq("sw_vm")) {
     rt_->get_compiler()->fatal("Pass 1 compilation for logic must target software!");
     delete md;
     delete md2;
@@ -410,6 +630,7 @@ void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const st
         ostream(rt_->rdbuf(Runtime::stdinfo_)) << "Aborted " << info << endl;
       } else {
         engine_->replace_with(e);
+        rt_->get_tier_policy()->promoted(this);
         ostream(rt_->rdbuf(Runtime::stdinfo_)) << "Finished " << info << endl;
       }
       rt_->reset_open_loop_itrs();
@@ -422,14 +643,55 @@ void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const st
     });
   }
 
-  // Run jit compilation asynchronously
-  if (jit && !engine_->is_stub() && (e != nullptr)) {
-    rt_->schedule_asynchronous(Runtime::Asynchronous([this, md2, version, id, pass, info]{
-      compile_and_replace(md2, version, id, pass+1);
-    }));
+  // Run jit compilation asynchronously. If there's a tier policy, it decides
+  // when (and whether) that happens. Otherwise, the first handoff is what the
+  // user is waiting on, so it jumps ahead of any further refinements.
+  if (jit && !engine_->is_stub() && (e != nullptr) && rt_->get_tier_policy()->is_enabled()) {
+    rt_->get_tier_policy()->request(this, count_passes(md2),
+      [this, md2, version, id, pass](size_t n) {
+        skip_passes(md2, n);
+        compile_and_replace(md2, version, id, pass+1);
+      },
+      [md2]{
+        delete md2;
+      },
+      rt_->get_compiler()->get_token(engine_->get_id())
+    );
+  } else if (jit && !engine_->is_stub() && (e != nullptr)) {
+    rt_->schedule_asynchronous(
+      Runtime::Asynchronous([this, md2, version, id, pass]{
+        compile_and_replace(md2, version, id, pass+1);
+      }),
+      Runtime::Asynchronous([md2]{
+        delete md2;
+      }),
+      (pass == 1) ? ThreadPool::Priority::HIGH : ThreadPool::Priority::LOW,
+      rt_->get_compiler()->get_token(engine_->get_id())
+    );
   } else {
     delete md2;
   }
 }
 
+size_t Module::count_passes(const ModuleDeclaration* md) const {
+  const auto& t = md->get_attrs()->get<String>("__target")->get_readable_val();
+  const auto& l = md->get_attrs()->get<String>("__loc")->get_readable_val();
+  return 1 + static_cast<size_t>(std::max(count(t.begin(), t.end(), ';'), count(l.begin(), l.end(), ';')));
+}
+
+void Module::skip_passes(ModuleDeclaration* md, size_t n) const {
+  // Annotations with fewer passes than n keep their last entry
+  for (const auto* a : {"__target", "__loc"}) {
+    auto s = md->get_attrs()->get<String>(a)->get_readable_val();
+    for (size_t i = 0; i < n; ++i) {
+      const auto sep = s.find_first_of(';');
+      if (sep == string::npos) {
+        break;
+      }
+      s = s.substr(sep+1);
+    }
+    md->get_attrs()->set_or_replace(a, new String(s));
+  }
+}
+
 } // namespace cascade
@@ -34,7 +34,9 @@
 #include <forward_list>
 #include <iosfwd>
 #include <stddef.h>
+#include <unordered_set>
 #include <vector>
+#include "runtime/ids.h"
 #include "verilog/ast/visitors/editor.h"
 #include "verilog/ast/visitors/visitor.h"
 
@@ -78,6 +80,10 @@ class Module {
     void synchronize(size_t n);
     // Forces a recompilation of the entire module hierarchy.
     void rebuild();
+    // Forces a recompilation of this module alone, starting over from its
+    // first compilation pass. This method is subject to the same constraints
+    // as rebuild().
+    void demote();
     // Dumps the state of the module hierarchy to an ostream. 
     void save(std::ostream& os);
     // Reads the state of the module hierarchy from an istream. 
@@ -109,11 +115,34 @@ class Module {
     // Engine State:
     Engine* engine_;
     size_t version_;
+    size_t hash_;
+
+    // Fusion Helpers:
+    //
+    // Returns true if this module is compiled into its parent's engine rather
+    // than its own. This is the case when fusion is enabled and the two share
+    // the same standard library type and annotations.
+    bool is_fused() const;
+    // Appends the modules which are compiled into this module's engine.
+    void get_group(std::vector<Module*>& group);
+    // Returns the ids which the engine for this module reads from and writes
+    // to the dataplane. Ids which are only passed between modules in the same
+    // group are omitted.
+    void get_io(std::unordered_set<VId>& ins, std::unordered_set<VId>& outs);
+    // Returns isolated code for this module and every module in its group.
+    ModuleDeclaration* isolate(size_t ignore, bool force);
+    // Merges the isolated code for a group of modules into a single module.
+    // Takes ownership of mds.
+    ModuleDeclaration* fuse(std::vector<ModuleDeclaration*>& mds);
 
     // Helper Methods:
-    ModuleDeclaration* regenerate_ir_source(size_t ignore);
-    void compile_and_replace(size_t ignore);
+    void transform_ir_source(ModuleDeclaration* md);
+    void compile_and_replace(size_t ignore, bool force);
     void compile_and_replace(ModuleDeclaration* md, size_t version, const std::string& id, size_t pass);
+    // Returns the number of jit passes left in md's annotations.
+    size_t count_passes(const ModuleDeclaration* md) const;
+    // Removes the next n jit passes from md's annotations.
+    void skip_passes(ModuleDeclaration* md, size_t n) const;
 };
 
 } // namespace cascade
@@ -30,12 +30,15 @@
 
 #include "runtime/runtime.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <sstream>
+#include <unordered_map>
 #include "common/incstream.h"
 #include "common/indstream.h"
 #include "common/system.h"
@@ -43,6 +46,7 @@
 #include "runtime/isolate.h"
 #include "runtime/module.h"
 #include "runtime/nullbuf.h"
+#include "runtime/tier_policy.h"
 #include "target/compiler/local_compiler.h"
 #include "target/engine.h"
 #include "verilog/analyze/evaluate.h"
@@ -57,16 +61,27 @@
 
 using namespace std;
 
+namespace {
+
+// The index of the partition running on this thread, if any.
+thread_local size_t partition_id_ = numeric_limits<size_t>::max();
+
+} // namespace
+
 namespace cascade {
 
 Runtime::Runtime() : Thread() {
   include_dirs_ = System::src_root();
   fopen_dirs_ = "./";
   disable_inlining_ = false;
+  enable_fusion_ = false;
   enable_open_loop_ = false;
+  enable_batching_ = false;
   open_loop_itrs_ = 2;
-  open_loop_target_ = 1;
+  open_loop_rate_ = 0;
+  set_open_loop_target(10);
   profile_interval_ = 0;
+  parallel_threads_ = 0;
 
   pool_.set_num_threads(4);
   pool_.run();
@@ -77,6 +92,7 @@ Runtime::Runtime() : Thread() {
   compiler_ = new LocalCompiler(this);
   dp_ = new DataPlane();
   isolate_ = new Isolate();
+  tier_policy_ = new TierPolicy(this);
 
   program_ = new Program();
   root_ = nullptr;
@@ -84,6 +100,7 @@ Runtime::Runtime() : Thread() {
 
   finished_ = false;
   item_evals_ = 0;
+  ints_pending_ = false;
 
   schedule_all_ = false;
   clock_ = nullptr;
@@ -91,6 +108,7 @@ Runtime::Runtime() : Thread() {
 
   begin_time_ = ::time(nullptr);
   last_time_ = ::time(nullptr);
+  last_tier_check_ = ::time(nullptr);
   logical_time_ = 0;
 
   for (size_t i = 0; i < 6; ++i) {
@@ -119,6 +137,7 @@ Runtime::~Runtime() {
   compiler_->stop_compile();
   pool_.stop_now();
   compiler_->stop_async();
+  delete tier_policy_;
 
   // INVARIANT: All outstanding asynchronous threads have finished executing,
   // and any interrupts scheduled by those threads have either fizzled or had
@@ -154,8 +173,8 @@ Runtime& Runtime::set_include_dirs(const string& s) {
   return *this;
 }
 
-Runtime& Runtime::set_open_loop_target(size_t olt) {
-  open_loop_target_ = olt;
+Runtime& Runtime::set_open_loop_target(double olt) {
+  open_loop_target_ = static_cast<uint64_t>(std::max(olt, 0.0) * 1000000);
   return *this;
 }
 
@@ -164,12 +183,33 @@ Runtime& Runtime::set_disable_inlining(bool di) {
   return *this;
 }
 
+Runtime& Runtime::set_enable_fusion(bool ef) {
+  enable_fusion_ = ef;
+  return *this;
+}
+
 Runtime& Runtime::set_profile_interval(size_t n) {
   profile_interval_ = n;
   last_check_ = ::time(nullptr);
   return *this;
 }
 
+Runtime& Runtime::set_parallel_threads(size_t n) {
+  parallel_threads_ = n;
+  workers_.set_num_threads(n);
+  return *this;
+}
+
+Runtime& Runtime::set_enable_tiering(bool et) {
+  tier_policy_->set_enabled(et);
+  return *this;
+}
+
+Runtime& Runtime::set_promotion_threshold(size_t percent) {
+  tier_policy_->set_promotion_threshold(percent);
+  return *this;
+}
+
 DataPlane* Runtime::get_data_plane() {
   return dp_;
 }
@@ -182,6 +222,14 @@ Isolate* Runtime::get_isolate() {
   return isolate_;
 }
 
+TierPolicy* Runtime::get_tier_policy() {
+  return tier_policy_;
+}
+
+bool Runtime::get_enable_fusion() const {
+  return enable_fusion_;
+}
+
 Engine::Id Runtime::get_next_id() {
   return next_id_++;
 }
@@ -229,6 +277,7 @@ bool Runtime::schedule_interrupt(Interrupt int_) {
       int_();
     }    
   });
+  ints_pending_.store(true, memory_order_relaxed);
   return true;
 }
 
@@ -245,6 +294,7 @@ bool Runtime::schedule_interrupt(Interrupt int_, Interrupt alt) {
       alt();  
     }
   });
+  ints_pending_.store(true, memory_order_relaxed);
   return true;
 }
 
@@ -283,6 +333,10 @@ void Runtime::schedule_asynchronous(Asynchronous async) {
   pool_.insert(async); 
 }
 
+void Runtime::schedule_asynchronous(Asynchronous async, Asynchronous alt, ThreadPool::Priority p, const ThreadPool::Token& t) {
+  pool_.insert(async, p, t, alt);
+}
+
 bool Runtime::is_finished() const {
   return finished_;
 }
@@ -290,10 +344,14 @@ bool Runtime::is_finished() const {
 void Runtime::reset_open_loop_itrs() {
   schedule_interrupt([this]{
     open_loop_itrs_ = 2;
+    open_loop_rate_ = 0;
   });
 }
 
 void Runtime::debug(uint32_t action, const string& arg) {
+  if (defer_task([this, action, arg]{debug(action, arg);})) {
+    return;
+  }
   schedule_interrupt([this, action, arg]{
     const auto* r = resolve(arg);
     if (r == nullptr) {
@@ -324,6 +382,10 @@ void Runtime::debug(uint32_t action, const string& arg) {
 }
 
 void Runtime::finish(uint32_t arg) {
+  if (defer_task([this, arg]{finish(arg);})) {
+    return;
+  }
+  const auto tg = task_guard();
   if (arg > 0) {
     ostream(rdbuf(stdout_)) 
       << "Simulation Time: " << logical_time_ << "\n"
@@ -335,6 +397,9 @@ void Runtime::finish(uint32_t arg) {
 }
 
 void Runtime::restart(const string& path) {
+  if (defer_task([this, path]{restart(path);})) {
+    return;
+  }
   schedule_interrupt([this, path]{
     // As with retarget(), invoking this method in a state where item_evals_ >
     // 0 can be problematic. This condition guarantees safety.
@@ -352,6 +417,9 @@ void Runtime::restart(const string& path) {
 }   
 
 void Runtime::retarget(const string& s) {
+  if (defer_task([this, s]{retarget(s);})) {
+    return;
+  }
   schedule_interrupt([this, s]{
     // An unfortunate corner case: Have some evals been processed by the
     // interrupt queue? Remember that Module::rebuild() can only be invoked in
@@ -424,6 +492,9 @@ void Runtime::retarget(const string& s) {
 }
 
 void Runtime::save(const string& path) {
+  if (defer_task([this, path]{save(path);})) {
+    return;
+  }
   schedule_interrupt([this, path]{
     // As with retarget(), invoking this method in a state where item_evals_ >
     // 0 can be problematic. This condition guarantees safety.
@@ -462,6 +533,7 @@ streambuf* Runtime::rdbuf(FId id) const {
 }
 
 FId Runtime::fopen(const std::string& path, uint8_t mode) {
+  const auto tg = task_guard();
   incstream is(fopen_dirs_);
   const auto full_path = is.find(path);
   const auto target = full_path == "" ? path : full_path;
@@ -482,10 +554,12 @@ FId Runtime::fopen(const std::string& path, uint8_t mode) {
 }
 
 int32_t Runtime::in_avail(FId id) {
+  const auto tg = task_guard();
   return rdbuf(id)->in_avail();
 }
 
 uint32_t Runtime::pubseekoff(FId id, int32_t off, uint8_t way, uint8_t which) {
+  const auto tg = task_guard();
   auto d = ios_base::cur;
   switch (way) {
     case 1: d = ios_base::beg; break;
@@ -503,6 +577,7 @@ uint32_t Runtime::pubseekoff(FId id, int32_t off, uint8_t way, uint8_t which) {
 }
 
 uint32_t Runtime::pubseekpos(FId id, int32_t pos, uint8_t which) {
+  const auto tg = task_guard();
   auto o = ios_base::openmode();
   switch (which) {
     case 1: o = ios_base::in; break;
@@ -514,27 +589,42 @@ uint32_t Runtime::pubseekpos(FId id, int32_t pos, uint8_t which) {
 }
 
 int32_t Runtime::pubsync(FId id) {
+  if (defer_task([this, id]{pubsync(id);})) {
+    return 0;
+  }
+  const auto tg = task_guard();
   return rdbuf(id)->pubsync();
 }
 
 int32_t Runtime::sbumpc(FId id) {
+  const auto tg = task_guard();
   return rdbuf(id)->sbumpc();
 }
 
 int32_t Runtime::sgetc(FId id) {
+  const auto tg = task_guard();
   return rdbuf(id)->sgetc();
 }
 
 uint32_t Runtime::sgetn(FId id, char* c, uint32_t n) {
+  const auto tg = task_guard();
   return rdbuf(id)->sgetn(c, n);
 }
 
 int32_t Runtime::sputc(FId id, char c) {
+  if (defer_task([this, id, c]{sputc(id, c);})) {
+    return c;
+  }
+  const auto tg = task_guard();
   // Squelch puts which take place after a call to finish
   return !finished_ ? rdbuf(id)->sputc(c) : c;
 }
 
 uint32_t Runtime::sputn(FId id, const char* c, uint32_t n) {
+  if (defer_task([this, id, s = string(c, n)]{sputn(id, s.c_str(), s.length());})) {
+    return n;
+  }
+  const auto tg = task_guard();
   // Squelch puts which take place after a call to finish
   return !finished_ ? rdbuf(id)->sputn(c, n) : n;
 }
@@ -556,10 +646,13 @@ void Runtime::run_logic() {
   while (!stop_requested() && !finished_) {
     if (enable_open_loop_ && !schedule_all_) {
       open_loop_scheduler();
+    } else if (enable_batching_ && !schedule_all_) {
+      batch_scheduler();
     } else {
       reference_scheduler();
     }
     log_freq();
+    tier_tick();
   }
   if (finished_) {
     done_simulation();
@@ -661,6 +754,9 @@ void Runtime::resync() {
   } 
 
   // Clear scheduling state
+  for (auto* m : logic_) {
+    m->engine()->set_schedule(nullptr, 0);
+  }
   logic_.clear();
   done_logic_.clear();
   clock_ = nullptr;
@@ -682,27 +778,47 @@ void Runtime::resync() {
     }
   }
   schedule_all_ = true;
+  attach_schedule(logic_, sched_);
 
   // Determine whether we can reenter open loop in this state. 
   enable_open_loop_ = (logic_.size() == 2) && (clock_ != nullptr) && (inlined_logic_ != nullptr);
+  // If not, we can still run time steps back to back, so long as there's a
+  // clock to drive them.
+  enable_batching_ = !enable_open_loop_ && (clock_ != nullptr);
+  // Determine whether there's anything to schedule in parallel
+  partition();
 }
 
-void Runtime::drain_active() {
-  for (auto done = false; !done; ) {
-    done = true;
-    for (auto* m : logic_) {
-      if (schedule_all_ || m->engine()->there_are_reads()) {
-        m->engine()->evaluate();
-        done = false;
+void Runtime::drain_active(const vector<Module*>& ms, vector<uint64_t>& sched, bool schedule_all) {
+  if (schedule_all) {
+    for (auto* m : ms) {
+      m->engine()->evaluate();
+    }
+  }
+  while (drain_reads(ms, sched));
+}
+
+bool Runtime::drain_reads(const vector<Module*>& ms, vector<uint64_t>& sched) {
+  // Engines which are marked behind the cursor are picked up on the next
+  // call. This visits engines in the same order as a scan of ms would, but
+  // skips over the ones without reads a word at a time.
+  auto res = false;
+  for (size_t w = 0, we = sched.size(); w < we; ++w) {
+    for (uint64_t mask = ~static_cast<uint64_t>(0); (sched[w] & mask) != 0; ) {
+      const auto b = static_cast<size_t>(__builtin_ctzll(sched[w] & mask));
+      sched[w] &= ~(static_cast<uint64_t>(1) << b);
+      mask = (b == 63) ? 0 : (~static_cast<uint64_t>(0) << (b+1));
+      if (ms[(w << 6) + b]->engine()->conditional_evaluate()) {
+        res = true;
       }
     }
-    schedule_all_ = false;
   }
+  return res;
 }
 
-bool Runtime::drain_updates() {
+bool Runtime::drain_updates(const vector<Module*>& ms, vector<uint64_t>& sched) {
   auto performed_update = false;
-  for (auto* m : logic_) {
+  for (auto* m : ms) {
     if (m->engine()->conditional_update()) {
       performed_update = true;
     }
@@ -710,13 +826,14 @@ bool Runtime::drain_updates() {
   if (!performed_update) {
     return false;
   }
-  auto performed_evaluate = false;
-  for (auto* m : logic_) {
-    if (m->engine()->conditional_evaluate()) {
-      performed_evaluate = true;
-    }
+  return drain_reads(ms, sched);
+}
+
+void Runtime::attach_schedule(const vector<Module*>& ms, vector<uint64_t>& sched) {
+  sched.assign((ms.size() + 63) >> 6, 0);
+  for (size_t i = 0, ie = ms.size(); i < ie; ++i) {
+    ms[i]->engine()->set_schedule(&sched, i);
   }
-  return performed_evaluate;
 }
 
 void Runtime::done_step() {
@@ -749,17 +866,18 @@ void Runtime::drain_interrupts() {
     ints_[i]();
   }
   ints_.clear();
+  ints_pending_.store(false, memory_order_relaxed);
   block_cv_.notify_all();
 }
 
 void Runtime::open_loop_scheduler() {
   // Record the current time, go open loop, and then record how long we were
   // gone for.  
-  const size_t then = ::time(nullptr);
+  const auto then = chrono::steady_clock::now();
   const auto id = clock_->engine()->get_clock_id();
   const auto val = clock_->engine()->get_clock_val();
   const auto itrs = inlined_logic_->engine()->open_loop(id, val, open_loop_itrs_);
-  const size_t now = ::time(nullptr);
+  const auto now = chrono::steady_clock::now();
 
   // If we ran for an odd number of iterations, flip the clock
   if (itrs % 2) {
@@ -768,27 +886,215 @@ void Runtime::open_loop_scheduler() {
   // Drain the interrupt queue and fix up the logical time
   drain_interrupts();
   logical_time_ += itrs;
+  tune_open_loop(itrs, chrono::duration_cast<chrono::nanoseconds>(now - then).count());
+}
+
+void Runtime::batch_scheduler() {
+  // Run time steps back to back, without stopping to service interrupts,
+  // until we either hit our target or something needs our attention. Every
+  // system task which needs attention at the end of a time step either
+  // schedules an interrupt or sets finished_, so there's no need to ask
+  // each engine whether it ran one. Logical time advances with each step, so
+  // anything which observes it mid-batch sees the same value that it would
+  // under the reference scheduler.
+  const auto then = chrono::steady_clock::now();
+  size_t itrs = 0;
+  while (true) {
+    step();
+    ++itrs;
+    if ((itrs >= open_loop_itrs_) || finished_ || ints_pending_.load(memory_order_relaxed)) {
+      break;
+    }
+    ++logical_time_;
+  }
+  const auto now = chrono::steady_clock::now();
 
-  // Update open loop iterations based on our target
-  const auto delta = now - then;
-  auto next = open_loop_itrs_;
-  if ((delta < open_loop_target_) && (open_loop_itrs_ == itrs)) {
-    next <<= 1;
-  } else if (delta > open_loop_target_) {
-    next >>= 1;
+  // As with the reference scheduler, the final step's interrupts are drained
+  // before time advances past it.
+  drain_interrupts();
+  ++logical_time_;
+  tune_open_loop(itrs, chrono::duration_cast<chrono::nanoseconds>(now - then).count());
+}
+
+void Runtime::tune_open_loop(size_t itrs, uint64_t ns) {
+  // Runs which were cut short by a system task don't say anything about how
+  // long a full run takes, so there's nothing to learn from them.
+  if (itrs < open_loop_itrs_) {
+    return;
   }
-  open_loop_itrs_ = (next > 0) ? next : open_loop_itrs_;
+  // Otherwise, fold the rate that we just observed into a running estimate and
+  // aim for however many iterations we expect to take open_loop_target_
+  // nanoseconds. Smoothing keeps a single noisy run from causing the count to
+  // oscillate, and capping growth keeps us from overshooting on the basis of
+  // a run which was too short to time accurately. 
+  const auto delta = std::max<uint64_t>(ns, 1);
+  const auto rate = static_cast<double>(itrs) / delta;
+  open_loop_rate_ = (open_loop_rate_ == 0) ? rate : (0.5 * open_loop_rate_ + 0.5 * rate);
+  const auto next = static_cast<size_t>(open_loop_rate_ * open_loop_target_);
+  open_loop_itrs_ = std::max<size_t>(std::min(next, open_loop_itrs_ << 1), 1);
 }
 
 void Runtime::reference_scheduler() {
-  while (schedule_all_ || drain_updates()) {
-    drain_active();
-  }
-  done_step();
+  step();
   drain_interrupts();
   ++logical_time_;
 }
 
+void Runtime::step() {
+  if (!partitions_.empty()) {
+    parallel_scheduler();
+  } else {
+    while (schedule_all_ || drain_updates(logic_, sched_)) {
+      drain_active(logic_, sched_, schedule_all_);
+      schedule_all_ = false;
+    }
+  }
+  done_step();
+}
+
+void Runtime::parallel_scheduler() {
+  // Each round settles every partition independently. Reads which cross
+  // partitions are held back until the end of the round and then delivered
+  // in a fixed order, so the result doesn't depend on which partition
+  // finishes first. We're done when a round produces no such reads.
+  for (auto schedule_all = schedule_all_; ; schedule_all = false) {
+    workers_.run(partitions_.size(), [this, schedule_all](size_t i) {
+      const auto& ms = partitions_[i];
+      auto& sched = partition_scheds_[i];
+      partition_id_ = i;
+      drain_active(ms, sched, schedule_all);
+      while (drain_updates(ms, sched)) {
+        drain_active(ms, sched, false);
+      }
+      partition_id_ = numeric_limits<size_t>::max();
+    });
+    replay_tasks();
+    if (!dp_->flush()) {
+      break;
+    }
+  }
+  schedule_all_ = false;
+}
+
+void Runtime::partition() {
+  partitions_.clear();
+  dp_->clear_deferred();
+  if ((parallel_threads_ <= 1) || enable_open_loop_ || (logic_.size() <= 2)) {
+    return;
+  }
+
+  // Union-find over the indices of logic_
+  vector<size_t> parent(logic_.size());
+  for (size_t i = 0, ie = parent.size(); i < ie; ++i) {
+    parent[i] = i;
+  }
+  const auto find = [&parent](size_t i) {
+    while (parent[i] != i) {
+      i = parent[i] = parent[parent[i]];
+    }
+    return i;
+  };
+  const auto unite = [&parent, &find](size_t i, size_t j) {
+    i = find(i);
+    j = find(j);
+    parent[max(i, j)] = min(i, j);
+  };
+
+  unordered_map<const Engine*, size_t> index;
+  for (size_t i = 0, ie = logic_.size(); i < ie; ++i) {
+    index[logic_[i]->engine()] = i;
+  }
+  const auto npos = numeric_limits<size_t>::max();
+  const auto lookup = [&index, npos](const Engine* e) {
+    const auto itr = index.find(e);
+    return (itr == index.end()) ? npos : itr->second;
+  };
+
+  // Cores which can't be scheduled concurrently all share a partition. Other
+  // than that, engines which share an id share a partition, unless the id is
+  // written by the clock. The clock only writes between rounds.
+  auto serial = npos;
+  for (size_t i = 0, ie = logic_.size(); i < ie; ++i) {
+    if (!logic_[i]->engine()->supports_concurrency()) {
+      if (serial == npos) {
+        serial = i;
+      } else {
+        unite(serial, i);
+      }
+    }
+  }
+  vector<VId> crossing;
+  for (VId id = 0, ide = dp_->size(); id < ide; ++id) {
+    auto clocked = false;
+    auto first = npos;
+    for (auto w = dp_->writer_begin(id), we = dp_->writer_end(id); w != we; ++w) {
+      clocked = clocked || (*w)->is_clock();
+      const auto i = lookup(*w);
+      if (i != npos) {
+        first = (first == npos) ? i : first;
+        unite(first, i);
+      }
+    }
+    if (clocked) {
+      crossing.push_back(id);
+      continue;
+    }
+    for (auto r = dp_->reader_begin(id), re = dp_->reader_end(id); r != re; ++r) {
+      const auto i = lookup(*r);
+      if (i != npos) {
+        first = (first == npos) ? i : first;
+        unite(first, i);
+      }
+    }
+  }
+
+  // Collect partitions in logic_ order. Don't bother if there's only one.
+  vector<size_t> slot(logic_.size(), npos);
+  for (size_t i = 0, ie = logic_.size(); i < ie; ++i) {
+    const auto root = find(i);
+    if (slot[root] == npos) {
+      slot[root] = partitions_.size();
+      partitions_.emplace_back();
+    }
+    partitions_[slot[root]].push_back(logic_[i]);
+  }
+  if (partitions_.size() <= 1) {
+    partitions_.clear();
+    return;
+  }
+  for (auto id : crossing) {
+    dp_->defer(id);
+  }
+  partition_scheds_.resize(partitions_.size());
+  for (size_t i = 0, ie = partitions_.size(); i < ie; ++i) {
+    attach_schedule(partitions_[i], partition_scheds_[i]);
+  }
+  partition_tasks_.resize(partitions_.size());
+}
+
+unique_lock<mutex> Runtime::task_guard() {
+  return partitions_.empty() ? unique_lock<mutex>() : unique_lock<mutex>(task_lock_);
+}
+
+bool Runtime::defer_task(Interrupt task) {
+  // Each partition only ever touches its own buffer, so there's no need to
+  // lock here. Tasks invoked from anywhere else run immediately.
+  if (partition_id_ >= partition_tasks_.size()) {
+    return false;
+  }
+  partition_tasks_[partition_id_].push_back(task);
+  return true;
+}
+
+void Runtime::replay_tasks() {
+  for (auto& ts : partition_tasks_) {
+    for (auto& t : ts) {
+      t();
+    }
+    ts.clear();
+  }
+}
+
 void Runtime::log_parse_errors() {
   ostream os(rdbuf(stderr_));
   os << "Parse Error:";
@@ -878,11 +1184,38 @@ void Runtime::log_freq() {
   }
   auto event = [this]{
     last_check_ = ::time(nullptr);
-    ostream(rdbuf(stdinfo_)) << "Logical Time: " << logical_time_ << "\nVirtual Freq: " << current_frequency() << endl;
+    const auto s = pool_.get_stats();
+    ostream(rdbuf(stdinfo_)) 
+      << "Logical Time: " << logical_time_ << "\nVirtual Freq: " << current_frequency() << "\n"
+      << "Async Queue:  " << s.depth << " waiting (" << s.max_depth << " max), " << s.executed << " run, " << s.cancelled << " cancelled, "
+      << (s.executed > 0 ? (s.total_wait / s.executed / 1000) : 0) << "ms average wait" << endl;
   };
   schedule_interrupt(event, event);
 }
 
+void Runtime::tier_tick() {
+  if (!tier_policy_->is_enabled()) {
+    return;
+  }
+  if (::time(nullptr) == last_tier_check_) {
+    return;
+  }
+  last_tier_check_ = ::time(nullptr);
+  // Sampling and promotion are safe between any two time steps, so there's
+  // no reason to force the next drain_interrupts() down its slow path.
+  // Demotions recompile modules, which is only safe once the hierarchy is in
+  // sync with the user's program (see retarget()), so those still go through
+  // the interrupt queue, and only when there's something to demote. Modules
+  // which can't be demoted yet are retried on the next tick.
+  if (tier_policy_->tick()) {
+    schedule_interrupt([this]{
+      if (item_evals_ == 0) {
+        tier_policy_->demote();
+      }
+    }, []{});
+  }
+}
+
 const Node* Runtime::resolve(const string& arg) {
   // Create a new navigation object and point it at the root
   Navigate nav(program_->root_elab()->second);
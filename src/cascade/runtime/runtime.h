@@ -31,7 +31,9 @@
 #ifndef CASCADE_SRC_RUNTIME_RUNTIME_H
 #define CASCADE_SRC_RUNTIME_RUNTIME_H
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <ctime>
 #include <functional>
 #include <iosfwd>
@@ -42,6 +44,7 @@
 #include "common/log.h"
 #include "common/thread.h"
 #include "common/thread_pool.h"
+#include "common/work_group.h"
 #include "runtime/ids.h"
 #include "target/engine.h"
 #include "verilog/ast/ast_fwd.h"
@@ -55,6 +58,7 @@ class Log;
 class Module;
 class Parser;
 class Program;
+class TierPolicy;
 
 class Runtime : public Thread {
   public:
@@ -80,9 +84,13 @@ class Runtime : public Thread {
     // thread. Invoking these methods afterwards is undefined.
     Runtime& set_fopen_dirs(const std::string& s);
     Runtime& set_include_dirs(const std::string& s);
-    Runtime& set_open_loop_target(size_t olt);
+    Runtime& set_open_loop_target(double olt);
     Runtime& set_disable_inlining(bool di);
+    Runtime& set_enable_fusion(bool ef);
     Runtime& set_profile_interval(size_t n);
+    Runtime& set_parallel_threads(size_t n);
+    Runtime& set_enable_tiering(bool et);
+    Runtime& set_promotion_threshold(size_t percent);
 
     // Major Component Accessors and Helpers:
     //
@@ -92,6 +100,8 @@ class Runtime : public Thread {
     Compiler* get_compiler();
     DataPlane* get_data_plane();
     Isolate* get_isolate();
+    TierPolicy* get_tier_policy();
+    bool get_enable_fusion() const;
     Engine::Id get_next_id();
 
     // Eval Interface:
@@ -130,6 +140,10 @@ class Runtime : public Thread {
     // asynchronous task invokes any of the schedule_xxx_interrupt methods, it
     // must use the two-argument form.
     void schedule_asynchronous(Asynchronous async);
+    // Identical to the single argument form, but async is scheduled with
+    // priority p, and alt is run in its place if t is cancelled before async
+    // begins execution.
+    void schedule_asynchronous(Asynchronous async, Asynchronous alt, ThreadPool::Priority p, const ThreadPool::Token& t);
     // Returns true if the runtime has executed a finish statement.
     bool is_finished() const;
     // Resets the open loop iteration counter
@@ -174,13 +188,18 @@ class Runtime : public Thread {
     std::string include_dirs_;
     std::string fopen_dirs_;
     bool disable_inlining_;
+    bool enable_fusion_;
     bool enable_open_loop_;
+    bool enable_batching_;
     size_t open_loop_itrs_;
-    size_t open_loop_target_;
+    uint64_t open_loop_target_;
+    double open_loop_rate_;
     size_t profile_interval_;
+    size_t parallel_threads_;
 
     // Thread Pool:
     ThreadPool pool_;
+    WorkGroup workers_;
 
     // Major Components:
     Log* log_;
@@ -188,6 +207,7 @@ class Runtime : public Thread {
     Compiler* compiler_;
     DataPlane* dp_;
     Isolate* isolate_;
+    TierPolicy* tier_policy_;
 
     // Program State:
     Program* program_;
@@ -198,6 +218,7 @@ class Runtime : public Thread {
     bool finished_;
     size_t item_evals_;
     std::vector<Interrupt> ints_;
+    std::atomic<bool> ints_pending_;
     std::recursive_mutex int_lock_;
     std::mutex block_lock_;
     std::condition_variable block_cv_;
@@ -206,15 +227,33 @@ class Runtime : public Thread {
     std::vector<Module*> logic_;
     std::vector<Module*> done_logic_;
     bool schedule_all_;
+    // One bit per element of logic_, set when its engine has reads
+    std::vector<uint64_t> sched_;
 
     // Optimized Scheduling State:
     Module* clock_;
     Module* inlined_logic_;
 
+    // Parallel Scheduling State:
+    //
+    // When parallel scheduling is enabled, logic_ is split into partitions
+    // which don't communicate other than through ids written by the clock.
+    // Partitions are scheduled concurrently, and writes to the ids which cross
+    // partitions are deferred until every partition has settled. System tasks
+    // and stream operations invoked from a partition are serialized by
+    // task_lock_. Those which only produce side effects are buffered in
+    // partition_tasks_ and replayed in partition order at the end of each
+    // round, so that their output doesn't depend on which partition ran first.
+    std::vector<std::vector<Module*>> partitions_;
+    std::vector<std::vector<uint64_t>> partition_scheds_;
+    std::vector<std::vector<Interrupt>> partition_tasks_;
+    std::mutex task_lock_;
+
     // Time Keeping:
     time_t begin_time_;
     time_t last_time_;
     time_t last_check_;
+    time_t last_tier_check_;
     uint64_t last_logical_time_;
     uint64_t logical_time_;
 
@@ -250,11 +289,17 @@ class Runtime : public Thread {
 
     // Verilog Simulation Loop Scheduling Helpers:
     //
-    // Drains the active queue
-    void drain_active();
-    // Drains update events for all modules with updates. Return true if doing
-    // so resulted in new active events.
-    bool drain_updates();
+    // Drains the active queue for a set of modules. sched holds a bit for
+    // each module whose engine might have reads.
+    void drain_active(const std::vector<Module*>& ms, std::vector<uint64_t>& sched, bool schedule_all);
+    // Evaluates the modules in sched which have reads, in order. Returns true
+    // if there were any.
+    bool drain_reads(const std::vector<Module*>& ms, std::vector<uint64_t>& sched);
+    // Drains update events for a set of modules with updates. Return true if
+    // doing so resulted in new active events.
+    bool drain_updates(const std::vector<Module*>& ms, std::vector<uint64_t>& sched);
+    // Attaches the engines in ms to sched
+    void attach_schedule(const std::vector<Module*>& ms, std::vector<uint64_t>& sched);
     // Invokes done_step on every module, completing the logical simulation step
     void done_step();
     // Invokes done_simulation on every module, completing the simulation
@@ -264,9 +309,31 @@ class Runtime : public Thread {
 
     // Runs in open loop until timeout or a system task is triggered
     void open_loop_scheduler();
+    // Runs iterations of the reference scheduling algorithm back to back
+    // until timeout or an interrupt is scheduled
+    void batch_scheduler();
+    // Adjusts the number of iterations to run in open loop for based on how
+    // long it took to run itrs iterations
+    void tune_open_loop(size_t itrs, uint64_t ns);
     // Runs a single iteration of the reference scheduling algoirthm
     void reference_scheduler();
-
+    // Runs a single iteration of the reference scheduling algorithm, without
+    // servicing interrupts or advancing the logical time
+    void step();
+    // Runs a single iteration of the reference scheduling algorithm with each
+    // partition scheduled concurrently
+    void parallel_scheduler();
+
+    // Parallel Scheduling Helpers:
+    //
+    // Splits logic_ into partitions and defers the ids which cross them
+    void partition();
+    // Returns a lock on task_lock_ if parallel scheduling is active
+    std::unique_lock<std::mutex> task_guard();
+    // Buffers task and returns true if it was invoked from a partition
+    bool defer_task(Interrupt task);
+    // Runs the tasks buffered by every partition, in partition order
+    void replay_tasks();
     // Logging Helpers
     //
     // Dumps parse errors to stderr
@@ -282,6 +349,12 @@ class Runtime : public Thread {
     // Dumps the current virtual clock frequency to stdlog
     void log_freq();
 
+    // Tiering Helpers:
+    //
+    // Periodically lets the tier policy act on the profiles that it's
+    // collected, scheduling an interrupt only if there's a demotion to run.
+    void tier_tick();
+
     // Debug Helpers:
     //
     // Resolves an id in the program. Returns nullptr on failure.
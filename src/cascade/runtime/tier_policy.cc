@@ -0,0 +1,230 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "runtime/tier_policy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "runtime/module.h"
+#include "runtime/runtime.h"
+
+using namespace std;
+
+namespace cascade {
+
+TierPolicy::TierPolicy(Runtime* rt) {
+  rt_ = rt;
+  set_enabled(false);
+  set_promotion_threshold(5);
+  set_max_inflight(2);
+  inflight_ = 0;
+  last_tick_ = now();
+}
+
+TierPolicy::~TierPolicy() {
+  clear();
+}
+
+TierPolicy& TierPolicy::set_enabled(bool enabled) {
+  enabled_ = enabled;
+  return *this;
+}
+
+TierPolicy& TierPolicy::set_promotion_threshold(size_t percent) {
+  threshold_ = percent;
+  return *this;
+}
+
+TierPolicy& TierPolicy::set_max_inflight(size_t n) {
+  max_inflight_ = std::max(n, static_cast<size_t>(1));
+  return *this;
+}
+
+bool TierPolicy::is_enabled() const {
+  return enabled_;
+}
+
+void TierPolicy::request(Module* m, size_t n, Promotion p, Job alt, const ThreadPool::Token& t) {
+  lock_guard<mutex> lg(lock_);
+  auto& e = entries_.emplace(m, Entry()).first->second;
+  if (e.pending) {
+    e.alt();
+  }
+  e.pending = true;
+  e.tiers = n;
+  e.promote = p;
+  e.alt = alt;
+  e.token = t;
+}
+
+void TierPolicy::promoted(Module* m) {
+  lock_guard<mutex> lg(lock_);
+  entries_.emplace(m, Entry()).first->second.promoted = true;
+}
+
+bool TierPolicy::tick() {
+  if (!enabled_) {
+    return false;
+  }
+  const auto t = now();
+  const auto wall = std::max(t - last_tick_, static_cast<uint64_t>(1));
+  last_tick_ = t;
+
+  vector<pair<double, Module*>> hot;
+  auto cold = false;
+  { lock_guard<mutex> lg(lock_);
+    for (auto& me : entries_) {
+      auto* m = me.first;
+      auto& e = me.second;
+
+      // Throw away requests which were cancelled out from under us. This
+      // happens when a module is recompiled and the runtime stops everything
+      // that was associated with its old version.
+      if (e.pending && e.token.is_cancelled()) {
+        e.alt();
+        e.pending = false;
+      }
+
+      // We need two samples to say anything about a module
+      const auto& p = m->engine()->get_profile();
+      if (!e.sampled) {
+        e.sampled = true;
+        e.last = p;
+        continue;
+      }
+      const auto share = 100.0 * (p.time_ns - e.last.time_ns) / wall;
+      const auto loops = p.open_loops - e.last.open_loops;
+      const auto yields = p.open_loop_yields - e.last.open_loop_yields;
+      const auto itrs = p.open_loop_itrs - e.last.open_loop_itrs;
+      e.last = p;
+
+      if (e.cooldown > 0) {
+        --e.cooldown;
+        continue;
+      }
+      if (e.pending && !e.inflight && (share >= threshold_)) {
+        hot.push_back(make_pair(share, m));
+      }
+      // A promoted engine which spends most of its time bouncing back to the
+      // runtime to service tasks is paying for a round trip every few
+      // iterations. It'll run faster in software until things calm down.
+      if (e.promoted && !e.demoting && (loops >= 64) && (2*yields >= loops) && (itrs < 16*loops)) {
+        e.demoting = true;
+      }
+      cold = cold || e.demoting;
+    }
+
+    // Release the hottest modules first, and only as many as we're allowed to
+    // have in flight at once. The rest will still be here next time.
+    sort(hot.begin(), hot.end(), [](const auto& a, const auto& b) {
+      return a.first > b.first;
+    });
+    for (size_t i = 0, ie = hot.size(); (i < ie) && (inflight_ < max_inflight_); ++i) {
+      release(hot[i].second, entries_[hot[i].second], i == 0, hot[i].first >= 50.0);
+    }
+  }
+  return cold;
+}
+
+void TierPolicy::demote() {
+  vector<Module*> cold;
+  { lock_guard<mutex> lg(lock_);
+    for (auto& me : entries_) {
+      auto& e = me.second;
+      if (!e.demoting) {
+        continue;
+      }
+      e.demoting = false;
+      e.promoted = false;
+      e.cooldown = size_t(1) << std::min(e.demotions, static_cast<size_t>(6));
+      ++e.demotions;
+      cold.push_back(me.first);
+    }
+  }
+
+  // Demotion recompiles modules, which will call back into request(), so this
+  // has to happen without holding the lock.
+  for (auto* m : cold) {
+    m->demote();
+  }
+}
+
+void TierPolicy::clear() {
+  lock_guard<mutex> lg(lock_);
+  for (auto& me : entries_) {
+    if (me.second.pending) {
+      me.second.alt();
+    }
+  }
+  entries_.clear();
+  inflight_ = 0;
+}
+
+void TierPolicy::release(Module* m, Entry& e, bool first, bool skip) {
+  e.pending = false;
+  e.inflight = true;
+  ++inflight_;
+
+  // Modules which dominate simulation time go straight to their last target.
+  // The intermediate targets would only delay the one that matters.
+  const auto n = (skip && (e.tiers > 1)) ? (e.tiers - 1) : 0;
+  auto p = e.promote;
+  auto alt = e.alt;
+  rt_->schedule_asynchronous(
+    Job([this, m, p, n]{
+      p(n);
+      retire(m);
+    }),
+    Job([this, m, alt]{
+      alt();
+      retire(m);
+    }),
+    first ? ThreadPool::Priority::HIGH : ThreadPool::Priority::NORMAL,
+    e.token
+  );
+}
+
+void TierPolicy::retire(Module* m) {
+  lock_guard<mutex> lg(lock_);
+  // The entry for m may have been cleared, and possibly recreated by a new
+  // request, since it was released. Either way, it's no longer counted.
+  const auto itr = entries_.find(m);
+  if ((itr != entries_.end()) && itr->second.inflight) {
+    itr->second.inflight = false;
+    --inflight_;
+  }
+}
+
+uint64_t TierPolicy::now() {
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace cascade
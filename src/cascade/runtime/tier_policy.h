@@ -0,0 +1,143 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_RUNTIME_TIER_POLICY_H
+#define CASCADE_SRC_RUNTIME_TIER_POLICY_H
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include "common/thread_pool.h"
+#include "target/engine.h"
+
+namespace cascade {
+
+class Module;
+class Runtime;
+
+// A tier policy decides when modules which are annotated with more than one
+// compilation target (ie: __target="sw;verilator64") are promoted from one
+// target to the next. Without a policy, every module starts its next
+// compilation as soon as the previous one finishes. With a policy, requests
+// are held until a module accounts for at least a threshold share of
+// simulation time, and are released hottest first, a few at a time, so
+// trivially cheap modules don't compete for build resources with the module
+// that actually matters. Modules which dominate simulation time skip straight
+// to their last target.
+//
+// Promoted modules whose open loop keeps being cut short by system tasks are
+// demoted back to software, where tasks are cheap, and held there for a
+// cooldown period that doubles with each demotion.
+
+class TierPolicy {
+  public:
+    // Typedefs:
+    typedef std::function<void(size_t)> Promotion;
+    typedef ThreadPool::Job Job;
+
+    // Constructors:
+    explicit TierPolicy(Runtime* rt);
+    ~TierPolicy();
+
+    // Configuration Interface:
+    //
+    // These methods should all be invoked prior to starting the runtime
+    // thread. Invoking these methods afterwards is undefined.
+    TierPolicy& set_enabled(bool enabled);
+    TierPolicy& set_promotion_threshold(size_t percent);
+    TierPolicy& set_max_inflight(size_t n);
+    bool is_enabled() const;
+
+    // Module Interface:
+    //
+    // These methods are thread-safe. Requests that m be promoted to the next
+    // of its n remaining targets. When the policy decides to do so, p is
+    // scheduled asynchronously with token t and invoked with the number of
+    // targets to skip. If m is never promoted, alt is run instead. Replaces
+    // any previous request for m.
+    void request(Module* m, size_t n, Promotion p, Job alt, const ThreadPool::Token& t);
+    // Notifies the policy that m is now running in a promoted engine.
+    void promoted(Module* m);
+
+    // Runtime Interface:
+    //
+    // These methods must be invoked by the runtime between time steps.
+    // Samples the profiles of every module with an outstanding request or a
+    // promoted engine and releases promotions. Returns true if any module is
+    // waiting to be demoted.
+    bool tick();
+    // Demotes every module which tick() marked for demotion. This must only
+    // be invoked once the hierarchy is in sync with the user's program.
+    void demote();
+    // Runs the alternate for every outstanding request and forgets about
+    // every module.
+    void clear();
+
+  private:
+    // Per-module State:
+    struct Entry {
+      // Outstanding request, if any
+      bool pending;
+      size_t tiers;
+      Promotion promote;
+      Job alt;
+      ThreadPool::Token token;
+      // Lifecycle state
+      bool inflight;
+      bool promoted;
+      bool demoting;
+      // Profile at the previous tick
+      bool sampled;
+      Engine::Profile last;
+      // Demotion history
+      size_t cooldown;
+      size_t demotions;
+    };
+
+    Runtime* rt_;
+    bool enabled_;
+    size_t threshold_;
+    size_t max_inflight_;
+
+    std::mutex lock_;
+    std::unordered_map<Module*, Entry> entries_;
+    size_t inflight_;
+    uint64_t last_tick_;
+
+    // Helper Methods:
+    void release(Module* m, Entry& e, bool first, bool skip);
+    void retire(Module* m);
+    static uint64_t now();
+};
+
+} // namespace cascade
+
+#endif
@@ -65,6 +65,10 @@ CoreCompiler* Compiler::get(const std::string& id) {
   return (itr == ccs_.end()) ? nullptr : itr->second;
 }
 
+ArtifactCache& Compiler::get_cache() {
+  return cache_;
+}
+
 Engine* Compiler::compile_stub(Engine::Id id, const ModuleDeclaration* md) {
   const auto loc = md->get_attrs()->get<String>("__loc")->get_readable_val();
   auto* i = get_interface(loc);
@@ -105,6 +109,13 @@ Engine* Compiler::compile(Engine::Id id, ModuleDeclaration* md) {
 }
 
 void Compiler::stop_compile(Engine::Id id) {
+  { lock_guard<mutex> lg(lock_);
+    const auto itr = tokens_.find(id);
+    if (itr != tokens_.end()) {
+      itr->second.cancel();
+      tokens_.erase(itr);
+    }
+  }
   for (auto& cc : ccs_) {
     cc.second->stop_compile(id);
   }
@@ -116,7 +127,18 @@ void Compiler::stop_async() {
   }
 }
 
+ThreadPool::Token Compiler::get_token(Engine::Id id) {
+  lock_guard<mutex> lg(lock_);
+  return tokens_[id];
+}
+
 void Compiler::stop_compile() {
+  { lock_guard<mutex> lg(lock_);
+    for (auto& t : tokens_) {
+      t.second.cancel();
+    }
+    tokens_.clear();
+  }
   for (auto& cc : ccs_) {
     for (auto id : ids_) {
       cc.second->stop_compile(id);
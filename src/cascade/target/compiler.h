@@ -36,6 +36,8 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include "common/artifact_cache.h"
+#include "common/thread_pool.h"
 #include "runtime/runtime.h"
 #include "verilog/ast/ast_fwd.h"
 #include "verilog/ast/visitors/visitor.h"
@@ -58,6 +60,10 @@ class Compiler {
     // registered compiler are undefined.
     Compiler& set(const std::string& id, CoreCompiler* c);
     CoreCompiler* get(const std::string& id);
+    // Returns the persistent cache that core compilers may use to store the
+    // results of expensive builds between runs. The cache itself is
+    // thread-safe.
+    ArtifactCache& get_cache();
 
     // Compilation Interface:
     // 
@@ -80,6 +86,10 @@ class Compiler {
     void stop_compile(); 
     // Invokes stop_async() on all registered compilers.
     void stop_async();
+    // Returns a token which is cancelled by the next invocation of either form
+    // of stop_compile() that applies to id. Asynchronous jobs which are
+    // scheduled with this token and haven't started by then are discarded.
+    ThreadPool::Token get_token(Engine::Id id);
 
     // Error Reporting Interface:
     //
@@ -124,9 +134,11 @@ class Compiler {
 
     // Compilers:
     std::unordered_map<std::string, CoreCompiler*> ccs_;
+    ArtifactCache cache_;
 
     // Compilation State:
     std::unordered_set<Engine::Id> ids_;
+    std::unordered_map<Engine::Id, ThreadPool::Token> tokens_;
 
     // Error State:
     std::mutex lock_;
@@ -33,6 +33,7 @@
 #include <cassert>
 #include <unordered_map>
 #include "common/log.h"
+#include "common/poller.h"
 #include "common/sockserver.h"
 #include "common/sockstream.h"
 #include "target/compiler/remote_interface.h"
@@ -43,13 +44,20 @@
 
 using namespace std;
 
+namespace {
+
+// The synchronous socket for the connection which requested the compilation
+// running on this thread. Engines use it to send writes and tasks back.
+thread_local cascade::sockstream* interface_sock_ = nullptr;
+
+} // namespace
+
 namespace cascade {
 
 RemoteCompiler::RemoteCompiler() : Compiler(), Thread() { 
   set_path("/tmp/fpga_socket");
   set_port(8800);
-
-  sock_ = nullptr;
+  set_num_threads(4);
 }
 
 RemoteCompiler::~RemoteCompiler() {
@@ -61,11 +69,11 @@ void RemoteCompiler::schedule_state_safe_interrupt(Runtime::Interrupt int_) {
   
   // Send a state safe begin request to every registered compiler and wait 
   // for them to reply with a state safe okay
-  for (const auto& si : sock_index_) {
-    if (si.first == -1) {
+  for (const auto& c : conns_) {
+    if (c.first == nullptr) {
       continue;
     }
-    auto* asock = socks_[si.first];
+    auto* asock = c.first;
     Rpc(Rpc::Type::STATE_SAFE_BEGIN).serialize(*asock);
     asock->flush();
     Rpc res;
@@ -78,11 +86,11 @@ void RemoteCompiler::schedule_state_safe_interrupt(Runtime::Interrupt int_) {
   int_();
 
   // Send a state safe finish response to every known instance of cascade
-  for (const auto& si : sock_index_) {
-    if (si.first == -1) {
+  for (const auto& c : conns_) {
+    if (c.first == nullptr) {
       continue;
     }
-    auto* asock = socks_[si.first];
+    auto* asock = c.first;
     Rpc(Rpc::Type::STATE_SAFE_FINISH).serialize(*asock);
     asock->flush();
   }
@@ -92,10 +100,10 @@ Interface* RemoteCompiler::get_interface(const std::string& loc) {
   if (loc != "remote") {
     return nullptr;        
   }
-  if (sock_ == nullptr) {
+  if (interface_sock_ == nullptr) {
     return nullptr;
   }
-  return new RemoteInterface(sock_);
+  return new RemoteInterface(interface_sock_);
 }
 
 RemoteCompiler& RemoteCompiler::set_path(const string& p) {
@@ -108,171 +116,99 @@ RemoteCompiler& RemoteCompiler::set_port(uint32_t p) {
   return *this;
 }
 
+RemoteCompiler& RemoteCompiler::set_num_threads(size_t n) {
+  num_threads_ = n;
+  return *this;
+}
+
 void RemoteCompiler::run_logic() {
-  sockserver tl(port_, 8);
-  sockserver ul(path_.c_str(), 8);
+  sockserver tl(port_, 128);
+  sockserver ul(path_.c_str(), 128);
   if (tl.error() || ul.error()) {
     return;
   }
 
-  fd_set master_set;
-  FD_ZERO(&master_set);
-  FD_SET(tl.descriptor(), &master_set);
-  FD_SET(ul.descriptor(), &master_set);
-
-  fd_set read_set;
-  FD_ZERO(&read_set);
-
-  struct timeval timeout = {1, 0};
-  auto max_fd = max(tl.descriptor(), ul.descriptor());
+  Poller poller;
+  if (!poller.insert(tl.descriptor()) || !poller.insert(ul.descriptor())) {
+    return;
+  }
+  // Connections which have been accepted but haven't sent a request yet
+  unordered_map<int, sockstream*> fresh;
 
-  pool_.set_num_threads(4);
+  pool_.set_num_threads(num_threads_);
   pool_.run();
 
   while (!stop_requested()) {
-    read_set = master_set;
-    select(max_fd+1, &read_set, nullptr, nullptr, &timeout);
-    for (auto i = 0; i <= max_fd; ++i) {
-      
-      // Not ready; nothing to do
-      if (!FD_ISSET(i, &read_set)) {
-        continue;
-      }
-
-      // Listener logic: New connections are added to the read set Note that
-      // this is a write critical section for sockets so it is guarded against
-      // race conditions with the state safe interrupt handler.
-      if ((i == tl.descriptor()) || (i == ul.descriptor())) {
-        lock_guard<mutex> lg(slock_);
-        auto* sock = (i == tl.descriptor()) ? tl.accept() : ul.accept();
-        const auto fd = sock->descriptor();
-        FD_SET(fd, &master_set);
-        if (fd > max_fd) {
-          max_fd = fd;
-          socks_.resize(max_fd+1, nullptr);
+    for (auto fd : poller.wait(1000)) {
+      // Listener logic: New connections are watched until their first request
+      // arrives.
+      if ((fd == tl.descriptor()) || (fd == ul.descriptor())) {
+        auto* sock = (fd == tl.descriptor()) ? tl.accept() : ul.accept();
+        if (sock->error()) {
+          delete sock;
+          continue;
         }
-        socks_[fd] = sock;
+        if (!poller.insert(sock->descriptor())) {
+          delete sock;
+          continue;
+        }
+        fresh[sock->descriptor()] = sock;
         continue;
       }
 
-      // Client: Grab the socket associated with this fd and handle the request
-      // Note that this is a read, which can't interfere with the state safe
-      // interrupt handler and thus doesn't need to be guarded.
-      auto* sock = socks_[i];
-      do {
-        Rpc rpc;
-        rpc.deserialize(*sock);
-        switch (rpc.type_) {
-
-          // Compiler ABI: Note that these methods remove elements from the
-          // sock index which aren't used anywhere else and thus don't need to
-          // be guarded.
-          case Rpc::Type::COMPILE: {
-            compile(sock, rpc);
-            sock = nullptr;
-            socks_[i] = nullptr;
-            FD_CLR(i, &master_set);
-            break;
-          }
-          case Rpc::Type::STOP_COMPILE: {
-            stop_compile(sock, rpc);
-            sock = nullptr;
-            socks_[i] = nullptr;
-            FD_CLR(i, &master_set);
-            break;
-          }
-
-          // Core ABI:
-          case Rpc::Type::GET_STATE:
-            get_state(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::SET_STATE:
-            set_state(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::GET_INPUT:
-            get_input(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::SET_INPUT:
-            set_input(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::FINALIZE:
-            finalize(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::OVERRIDES_DONE_STEP:
-            overrides_done_step(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::DONE_STEP:
-            done_step(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::OVERRIDES_DONE_SIMULATION:
-            overrides_done_simulation(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::DONE_SIMULATION:
-            done_simulation(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::READ:
-            read(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::EVALUATE:
-            evaluate(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::THERE_ARE_UPDATES:
-            there_are_updates(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::UPDATE:
-            update(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::THERE_WERE_TASKS:
-            there_were_tasks(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::CONDITIONAL_UPDATE:
-            conditional_update(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::OPEN_LOOP:
-            open_loop(sock, get_engine(rpc));
-            break;
-
-          // Proxy Compiler Codes:
-          case Rpc::Type::OPEN_CONN_1: {
-            lock_guard<mutex> lg(slock_);
-            open_conn_1(sock, rpc);
-            FD_CLR(sock->descriptor(), &master_set);                                              
-            break;
-          }
-          case Rpc::Type::OPEN_CONN_2: {
-            lock_guard<mutex> lg(slock_);
-            open_conn_2(sock, rpc);
-            break;
-          }
-          case Rpc::Type::CLOSE_CONN: {
-            lock_guard<mutex> lg(slock_);
-            sock = nullptr;
-            delete socks_[sock_index_[rpc.pid_].first];
-            delete socks_[sock_index_[rpc.pid_].second];
-            socks_[sock_index_[rpc.pid_].first] = nullptr;
-            socks_[sock_index_[rpc.pid_].second] = nullptr;
-            FD_CLR(sock_index_[rpc.pid_].second, &master_set);
-            sock_index_[rpc.pid_] = make_pair(-1,-1);
-            break;
-          }
-
-          // Proxy Core Codes:
-          case Rpc::Type::TEARDOWN_ENGINE:
-            teardown_engine(sock, rpc);
-            break;
-
-          // Control reaches here innocuosly when fds are closed remotely
-          default:
-            break;
-        }
-      } while ((sock != nullptr) && (sock->rdbuf()->in_avail() > 0));
+      // Client: The first request on a connection determines what it's for.
+      // Compilation requests are handed off to the thread pool, asynchronous
+      // sockets are only ever written to, and synchronous sockets are handed
+      // off to a thread of their own. Either way, we're done watching it.
+      const auto itr = fresh.find(fd);
+      assert(itr != fresh.end());
+      auto* sock = itr->second;
+      fresh.erase(itr);
+      poller.erase(fd);
+
+      Rpc rpc;
+      rpc.deserialize(*sock);
+      switch (rpc.type_) {
+        case Rpc::Type::COMPILE:
+          compile(sock, rpc);
+          break;
+        case Rpc::Type::STOP_COMPILE:
+          stop_compile(sock, rpc);
+          break;
+        case Rpc::Type::OPEN_CONN_1:
+          open_conn_1(sock, rpc);
+          break;
+        case Rpc::Type::OPEN_CONN_2:
+          open_conn_2(sock, rpc);
+          break;
+
+        // Control reaches here innocuosly when fds are closed remotely
+        default:
+          delete sock;
+          break;
+      }
     }
+    reap();
   }
 
   // Stop all asynchronous compilation threads. 
   Compiler::stop_compile();
   pool_.stop_now();
 
+  // Unblock every connection handler and wait for them to finish. 
+  { lock_guard<mutex> lg(slock_);
+    for (auto& c : conns_) {
+      if (c.second != nullptr) {
+        ::shutdown(c.second->descriptor(), SHUT_RDWR);
+      }
+    }
+  }
+  for (auto& h : handlers_) {
+    h.second.join();
+  }
+  handlers_.clear();
+  finished_.clear();
+
   // We have exclusive access to the indices. Delete their contents.
   for (auto& es : engines_) {
     for (auto* e : es) {
@@ -282,12 +218,98 @@ void RemoteCompiler::run_logic() {
     }
   }
   engines_.clear();
-  for (auto* s : socks_) {
-    if (s != nullptr) {
-      delete s;
+  for (auto& c : conns_) {
+    if (c.first != nullptr) {
+      delete c.first;
+    }
+    if (c.second != nullptr) {
+      delete c.second;
+    }
+  }
+  conns_.clear();
+  for (auto& f : fresh) {
+    delete f.second;
+  }
+}
+
+void RemoteCompiler::serve(size_t pid, sockstream* sock) {
+  while (true) {
+    Rpc rpc;
+    rpc.deserialize(*sock);
+    if (sock->eof() || sock->fail()) {
+      close_conn(pid);
+      return;
+    }
+    switch (rpc.type_) {
+      // Core ABI:
+      case Rpc::Type::GET_STATE:
+        get_state(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::SET_STATE:
+        set_state(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::GET_INPUT:
+        get_input(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::SET_INPUT:
+        set_input(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::FINALIZE:
+        finalize(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::OVERRIDES_DONE_STEP:
+        overrides_done_step(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::DONE_STEP:
+        done_step(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::OVERRIDES_DONE_SIMULATION:
+        overrides_done_simulation(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::DONE_SIMULATION:
+        done_simulation(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::READ:
+        read(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::EVALUATE:
+        evaluate(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::THERE_ARE_UPDATES:
+        there_are_updates(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::UPDATE:
+        update(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::THERE_WERE_TASKS:
+        there_were_tasks(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::CONDITIONAL_UPDATE:
+        conditional_update(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::OPEN_LOOP:
+        open_loop(sock, get_engine(rpc));
+        break;
+      case Rpc::Type::BATCH:
+        batch(sock, get_engine(rpc));
+        break;
+
+      // Proxy Core Codes:
+      case Rpc::Type::TEARDOWN_ENGINE:
+        teardown_engine(sock, rpc);
+        break;
+
+      // Proxy Compiler Codes: This deletes the socket, so there's nothing
+      // left for us to do.
+      case Rpc::Type::CLOSE_CONN:
+        close_conn(pid);
+        return;
+
+      default:
+        close_conn(pid);
+        return;
     }
   }
-  socks_.clear();
 }
 
 void RemoteCompiler::compile(sockstream* sock, const Rpc& rpc) {
@@ -314,25 +336,50 @@ void RemoteCompiler::compile(sockstream* sock, const Rpc& rpc) {
   }
 
   // Now create a new thread to compile the code, enter it into the
-  // engine table, and close the socket when it's done.
+  // engine table, and close the socket when it's done. If a stop_compile
+  // request for this engine arrives first, don't bother.
   pool_.insert([this, sock, rpc, md, eid]{
-    // TODO(eschkufz) Race condition here between when we set sock_ and when
-    // it's read.  Also, note the unguarded access to sock_index_
-    sock_ = socks_[sock_index_[rpc.pid_].second];
-    assert(sock_ != nullptr);
-    auto* e = Compiler::compile(eid, md);
+    // If this connection was closed before we got here, there's no interface
+    // to attach the engine to.
+    sockstream* isock = nullptr;
+    { lock_guard<mutex> lg(slock_);
+      isock = conns_[rpc.pid_].second;
+      interface_sock_ = isock;
+    }
+    auto* e = (isock != nullptr) ? Compiler::compile(eid, md) : nullptr;
+    interface_sock_ = nullptr;
+    if (isock == nullptr) {
+      delete md;
+    }
 
+    // The connection may also have been closed while we were compiling. In
+    // that case its index entries are gone and this engine has no owner.
+    auto owned = false;
     if (e != nullptr) {
-      { lock_guard<mutex> lg(elock_);
+      lock_guard<mutex> lg(elock_);
+      owned = engine_index_[rpc.pid_][rpc.eid_] == eid;
+      if (owned) {
         engines_[eid].push_back(e);
         Rpc(Rpc::Type::OKAY, rpc.pid_, rpc.eid_, engines_[eid].size()-1).serialize(*sock);
       }
+    }
+
+    if (owned) {
       sock->flush();
     } else {
+      delete e;
       Rpc(Rpc::Type::FAIL).serialize(*sock);
       sock->flush();
     }
     delete sock;
+  },
+  ThreadPool::Priority::NORMAL,
+  Compiler::get_token(eid),
+  [sock, md]{
+    delete md;
+    Rpc(Rpc::Type::FAIL).serialize(*sock);
+    sock->flush();
+    delete sock;
   });
 }
 
@@ -427,6 +474,7 @@ void RemoteCompiler::evaluate(sockstream* sock, Engine* e) {
 
 void RemoteCompiler::there_are_updates(sockstream* sock, Engine* e) {
   sock->put(e->there_are_updates() ? 1 : 0);
+  sock->flush();
 }
 
 void RemoteCompiler::update(sockstream* sock, Engine* e) {
@@ -439,6 +487,7 @@ void RemoteCompiler::update(sockstream* sock, Engine* e) {
 
 void RemoteCompiler::there_were_tasks(sockstream* sock, Engine* e) {
   sock->put(e->there_were_tasks() ? 1 : 0);
+  sock->flush();
 }
 
 void RemoteCompiler::conditional_update(sockstream* sock, Engine* e) {
@@ -465,18 +514,107 @@ void RemoteCompiler::open_loop(sockstream* sock, Engine* e) {
   sock->flush();
 }
 
+void RemoteCompiler::batch(sockstream* sock, Engine* e) {
+  const auto op = static_cast<uint8_t>(sock->get());
+  auto updated = false;
+  switch (op) {
+    case Rpc::BATCH_EVALUATE:
+      e->evaluate();
+      break;
+    case Rpc::BATCH_UPDATE:
+      e->update();
+      break;
+    case Rpc::BATCH_CONDITIONAL_UPDATE:
+      updated = e->conditional_update();
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  // These calls will have primed the socket with tasks and writes. Appending
+  // an OKAY rpc indicates that everything has been sent. The flags which
+  // follow save the caller from having to ask for them separately.
+  uint8_t flags = 0;
+  flags |= updated ? Rpc::FLAG_UPDATED : 0;
+  flags |= e->there_are_updates() ? Rpc::FLAG_THERE_ARE_UPDATES : 0;
+  flags |= e->there_were_tasks() ? Rpc::FLAG_THERE_WERE_TASKS : 0;
+  Rpc(Rpc::Type::OKAY).serialize(*sock);
+  sock->put(flags);
+  sock->flush();
+}
+
 void RemoteCompiler::open_conn_1(sockstream* sock, const Rpc& rpc) {
   (void) rpc;
-  const auto pid = sock_index_.size();
-  sock_index_.push_back(make_pair(sock->descriptor(), 0));
+  lock_guard<mutex> lg(slock_);
+  const auto pid = conns_.size();
+  conns_.push_back(make_pair(sock, nullptr));
   Rpc(Rpc::Type::OKAY, pid, 0, 0).serialize(*sock);
   sock->flush();
 }
 
 void RemoteCompiler::open_conn_2(sockstream* sock, const Rpc& rpc) {
-  sock_index_[rpc.pid_].second = sock->descriptor();
+  lock_guard<mutex> lg(slock_);
+  conns_[rpc.pid_].second = sock;
   Rpc(Rpc::Type::OKAY).serialize(*sock);
   sock->flush();
+  const auto pid = rpc.pid_;
+  handlers_[pid] = thread([this, pid, sock]{serve(pid, sock);});
+}
+
+void RemoteCompiler::close_conn(size_t pid) {
+  // Connections are indexed by position, so rather than erasing this entry we
+  // leave it empty. Either way, this connection's handler is about to return
+  // and can be reaped.
+  { lock_guard<mutex> lg(slock_);
+    delete conns_[pid].first;
+    delete conns_[pid].second;
+    conns_[pid] = make_pair(nullptr, nullptr);
+    finished_.push_back(pid);
+  }
+
+  // The engines which belonged to this connection hold interfaces that point
+  // at the sockets we just deleted. Unlink them from the index, so that
+  // compilations which are still running discard their results, and then
+  // tear them down. Neither of these steps can run while holding slock_:
+  // compilers may need it to schedule state safe interrupts.
+  vector<int> eids;
+  vector<Engine*> dead;
+  { lock_guard<mutex> lg(elock_);
+    if (pid < engine_index_.size()) {
+      for (auto& eid : engine_index_[pid]) {
+        if (eid == -1) {
+          continue;
+        }
+        eids.push_back(eid);
+        for (auto* e : engines_[eid]) {
+          if (e != nullptr) {
+            dead.push_back(e);
+          }
+        }
+        engines_[eid].clear();
+        eid = -1;
+      }
+    }
+  }
+  for (auto eid : eids) {
+    Compiler::stop_compile(eid);
+  }
+  for (auto* e : dead) {
+    delete e;
+  }
+}
+
+void RemoteCompiler::reap() {
+  vector<size_t> finished;
+  { lock_guard<mutex> lg(slock_);
+    finished.swap(finished_);
+  }
+  for (auto pid : finished) {
+    const auto itr = handlers_.find(pid);
+    assert(itr != handlers_.end());
+    itr->second.join();
+    handlers_.erase(itr);
+  }
 }
 
 void RemoteCompiler::teardown_engine(sockstream* sock, const Rpc& rpc) {
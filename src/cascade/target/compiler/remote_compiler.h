@@ -33,6 +33,9 @@
 
 #include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include "common/thread.h"
 #include "common/thread_pool.h"
@@ -51,27 +54,38 @@ class RemoteCompiler : public Compiler, public Thread {
 
     RemoteCompiler& set_path(const std::string& p);
     RemoteCompiler& set_port(uint32_t p);
+    RemoteCompiler& set_num_threads(size_t n);
 
   private:
     // Configuration Options:
     std::string path_;
     uint32_t port_;
+    size_t num_threads_;
 
     // Compiler Interface State:
-    sockstream* sock_;
     ThreadPool pool_;
 
-    // Socket and Engine Indices:
+    // Connection Index:
+    //
+    // Protects concurrent access to the connection index. This is only
+    // required when connections are opened or closed and for state safe
+    // interrupts, never for the requests which run engines.
+    std::mutex slock_;
+    // Maps a proxy compiler id to its asynchronous and synchronous sockets
+    std::vector<std::pair<sockstream*, sockstream*>> conns_;
+    // Every synchronous socket is served by its own thread, indexed by proxy
+    // compiler id. Only the listener thread touches this map.
+    std::unordered_map<size_t, std::thread> handlers_;
+    // Ids of handlers which have returned but haven't been joined yet. Access
+    // to this vector is protected by slock_.
+    std::vector<size_t> finished_;
+
+    // Engine Index:
     //
     // Protects concurrent access to indices
     std::mutex elock_;
-    std::mutex slock_;
-    // The ith element of this vector contains a socket for fd=i
-    std::vector<sockstream*> socks_; 
     // The ith element of this vector contains the engines with local engine id i
     std::vector<std::vector<Engine*>> engines_;
-    // Maps a proxy core id to its asynchronous and synchronous socket ids
-    std::vector<std::pair<int, int>> sock_index_;
     // Maps a proxy core / engine id to a local engine id
     std::vector<std::vector<int>> engine_index_;
 
@@ -82,6 +96,14 @@ class RemoteCompiler : public Compiler, public Thread {
     // Thread Interface:
     void run_logic() override;
 
+    // Connection Handler: 
+    //
+    // Serves requests from a synchronous socket until it's closed, and then
+    // closes the connection that it belongs to.
+    void serve(size_t pid, sockstream* sock);
+    // Joins any handlers which have finished.
+    void reap();
+
     // Compiler Interface:
     void compile(sockstream* sock, const Rpc& rpc);
     void stop_compile(sockstream* sock, const Rpc& rpc);
@@ -106,9 +128,11 @@ class RemoteCompiler : public Compiler, public Thread {
 
     void conditional_update(sockstream* sock, Engine* e);
     void open_loop(sockstream* sock, Engine* e);
+    void batch(sockstream* sock, Engine* e);
 
     void open_conn_1(sockstream* sock, const Rpc& rpc);
     void open_conn_2(sockstream* sock, const Rpc& rpc);
+    void close_conn(size_t pid);
 
     void teardown_engine(sockstream* sock, const Rpc& rpc);
 
@@ -97,9 +97,22 @@ struct Rpc : Serializable {
     STATE_SAFE_FINISH,
 
     // Proxy Core Codes:
-    TEARDOWN_ENGINE
+    TEARDOWN_ENGINE,
+
+    // Batched Core API:
+    BATCH
   };
 
+  // The operation which is requested by a BATCH rpc. Exactly one is sent per
+  // request; it is performed after any reads which precede it.
+  static constexpr uint8_t BATCH_EVALUATE = 0;
+  static constexpr uint8_t BATCH_UPDATE = 1;
+  static constexpr uint8_t BATCH_CONDITIONAL_UPDATE = 2;
+  // Flags which are returned in response to a BATCH rpc
+  static constexpr uint8_t FLAG_UPDATED = 0x1;
+  static constexpr uint8_t FLAG_THERE_ARE_UPDATES = 0x2;
+  static constexpr uint8_t FLAG_THERE_WERE_TASKS = 0x4;
+
   Rpc();
   Rpc(Type type);
   Rpc(Type type, uint32_t pid, uint32_t eid, uint32_t n);
@@ -81,6 +81,11 @@ class Core {
     // arbitrary logic at the end of the simulation. The default implementation
     // does nothing.
     virtual void done_simulation();
+    // Overriding this method to return true tells the runtime that this core
+    // shares no state with other cores except through its interface, and may
+    // be scheduled concurrently with cores that it doesn't communicate with.
+    // The default implementation returns false.
+    virtual bool supports_concurrency() const;
 
     // This method is invoked whenever new values are presented on this
     // module's input ports. It is required to perform whatever internal logic
@@ -206,6 +211,10 @@ inline void Core::done_simulation() {
   // Does nothing.
 }
 
+inline bool Core::supports_concurrency() const {
+  return false;
+}
+
 inline bool Core::conditional_update() {
   if (there_are_updates()) {
     update();
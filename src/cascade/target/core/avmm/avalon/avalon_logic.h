@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_TARGET_CORE_AVMM_AVALON_AVALON_LOGIC_H
 #define CASCADE_SRC_TARGET_CORE_AVMM_AVALON_AVALON_LOGIC_H
 
+#include <vector>
 #include "target/core/avmm/avalon/avalon_logic.h"
 #include "target/core/avmm/avalon/syncbuf.h"
 #include "target/core/avmm/avmm_logic.h"
@@ -79,6 +80,29 @@ inline AvalonLogic<V,A,T>::AvalonLogic(Interface* interface, ModuleDeclaration*
       reqs->sputn(reinterpret_cast<const char*>(bytes), 13);
     });
   }
+
+  // Bursts are packed into a single buffer so that the wrapper can process
+  // the entire sequence of requests without waiting on a handoff per word.
+  AvmmLogic<V,A,T>::get_table()->set_read_burst([reqs, resps](A index, T* vals, size_t n) {
+    constexpr auto stride = 1 + sizeof(A);
+    std::vector<uint8_t> bytes(n * stride);
+    for (size_t i = 0; i < n; ++i) {
+      bytes[i*stride] = 2;
+      *reinterpret_cast<A*>(&bytes[i*stride+1]) = index + i;
+    }
+    reqs->sputn(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    resps->waitforn(reinterpret_cast<char*>(vals), n * sizeof(T));
+  });
+  AvmmLogic<V,A,T>::get_table()->set_write_burst([reqs](A index, const T* vals, size_t n) {
+    constexpr auto stride = 1 + sizeof(A) + sizeof(T);
+    std::vector<uint8_t> bytes(n * stride);
+    for (size_t i = 0; i < n; ++i) {
+      bytes[i*stride] = 1;
+      *reinterpret_cast<A*>(&bytes[i*stride+1]) = index + i;
+      *reinterpret_cast<T*>(&bytes[i*stride+1+sizeof(A)]) = vals[i];
+    }
+    reqs->sputn(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  });
 }
 
 } // namespace cascade::avmm
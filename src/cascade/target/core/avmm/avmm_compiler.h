@@ -77,6 +77,16 @@ class AvmmCompiler : public CoreCompiler {
     // This method should perform whatever target-specific logic is necessary
     // to stop the execution of any invocations of compile().
     virtual void stop_compile() = 0;
+    // Backends which can host the module in each slot as an independently
+    // compiled program should override this method to return true. In this
+    // case, compile() is invoked with text which contains only the module in
+    // the slot returned by get_lead(), and success leaves the contents of
+    // every other slot undisturbed.
+    virtual bool independent_slots() const;
+
+    // Returns the slot which is leading the current compilation. This method
+    // may only be called from compile() before it releases the lock.
+    size_t get_lead() const;
 
   private:
     // Compilation States:
@@ -105,10 +115,11 @@ class AvmmCompiler : public CoreCompiler {
     // Slot Management Helpers:
     int get_free() const;
     void release(size_t slot);
-    void update();
+    void update(size_t slot);
 
     // Codegen Helpers:
-    std::string get_text();
+    std::string get_text(size_t slot);
+    std::string get_text(const std::map<MId, std::string>& text);
 };
 
 template <size_t M, size_t V, typename A, typename T>
@@ -152,13 +163,34 @@ inline void AvmmCompiler<M,V,A,T>::stop_compile(Engine::Id id) {
       }
     }
   }
-  // Target-specific implementation of stop logic
-  stop_compile();
+  // Target-specific implementation of stop logic. If slots are independent,
+  // the only compilation in flight belongs to the lead, so there's nothing to
+  // stop unless we just stopped the lead.
+  if (!independent_slots() || need_new_lead) {
+    stop_compile();
+  }
 
   // Notify any waiting threads that the slot table has changed.
   cv_.notify_all();
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline bool AvmmCompiler<M,V,A,T>::independent_slots() const {
+  return false;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline size_t AvmmCompiler<M,V,A,T>::get_lead() const {
+  for (size_t i = 0, ie = slots_.size(); i < ie; ++i) {
+    if (slots_[i].state == State::COMPILING) {
+      return i;
+    }
+  }
+  // Control should never reach here
+  assert(false);
+  return 0;
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline AvmmLogic<V,A,T>* AvmmCompiler<M,V,A,T>::compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) {
   std::unique_lock<std::mutex> lg(lock_);
@@ -192,7 +224,9 @@ inline AvmmLogic<V,A,T>* AvmmCompiler<M,V,A,T>::compile_logic(Engine::Id id, Mod
   // Register inputs, state, and outputs. Invoke these methods
   // lexicographically to ensure a deterministic variable table ordering. The
   // final invocation of index_tasks is lexicographic by construction, as it's
-  // based on a recursive descent of the AST.
+  // based on a recursive descent of the AST. Registering each group in turn
+  // also places inputs and state in contiguous ranges of the table, which
+  // lets them be streamed in and out in a single transfer.
   auto* al = build(interface, md, slot);
   std::map<VId, const Identifier*> is;
   for (auto* i : info.inputs()) {
@@ -229,8 +263,14 @@ inline AvmmLogic<V,A,T>* AvmmCompiler<M,V,A,T>::compile_logic(Engine::Id id, Mod
   }
 
   // Downgrade any compilation slots to waiting slots, and stop any slots that
-  // are working on this id.
+  // are working on this id. If slots are independent, there's no reason to
+  // preempt a compilation for a different id. We'll wait our turn instead.
+  auto lead = true;
   for (auto& s : slots_) {
+    if (independent_slots() && (s.state == State::COMPILING) && (s.id != id)) {
+      lead = false;
+      continue;
+    }
     if (s.state == State::COMPILING) {
       s.state = State::WAITING;
     }
@@ -238,17 +278,17 @@ inline AvmmLogic<V,A,T>* AvmmCompiler<M,V,A,T>::compile_logic(Engine::Id id, Mod
       s.state = State::STOPPED;
     }
   }
-  // This slot is now the compile lead
+  // This slot is now either the compile lead or next in line
   slots_[slot].id = id;
-  slots_[slot].state = State::COMPILING;
+  slots_[slot].state = lead ? State::COMPILING : State::WAITING;
   slots_[slot].text = Rewrite<M,V,A,T>().run(md, slot, al->get_table(), al->open_loop_clock());
   // Enter into compilation state machine. Control will exit from this loop
   // either when compilation succeeds or is aborted.
   while (true) {
     switch (slots_[slot].state) {
       case State::COMPILING:
-        if (compile(get_text(), lock_)) {
-          update();
+        if (compile(get_text(slot), lock_)) {
+          update(slot);
         }
         break;
       case State::WAITING:
@@ -291,7 +331,22 @@ inline void AvmmCompiler<M,V,A,T>::release(size_t slot) {
 }
 
 template <size_t M, size_t V, typename A, typename T>
-inline void AvmmCompiler<M,V,A,T>::update() {
+inline void AvmmCompiler<M,V,A,T>::update(size_t slot) {
+  // If slots are independent, only this slot was compiled. Promote it (unless
+  // it was stopped in the meantime) and hand the lead to the next in line.
+  if (independent_slots()) {
+    if (slots_[slot].state == State::COMPILING) {
+      slots_[slot].state = State::CURRENT;
+      for (auto& s : slots_) {
+        if (s.state == State::WAITING) {
+          s.state = State::COMPILING;
+          break;
+        }
+      }
+    }
+    cv_.notify_all();
+    return;
+  }
   for (auto& s : slots_) {
     if ((s.state == State::COMPILING) || (s.state == State::WAITING)) {
       s.state = State::CURRENT;
@@ -301,17 +356,26 @@ inline void AvmmCompiler<M,V,A,T>::update() {
 }
 
 template <size_t M, size_t V, typename A, typename T>
-inline std::string AvmmCompiler<M,V,A,T>::get_text() {
-  std::stringstream ss;
-  indstream os(ss);
-
-  // Generate code for modules
+inline std::string AvmmCompiler<M,V,A,T>::get_text(size_t slot) {
+  // Generate code for modules. If slots are independent, this is just the
+  // module in this slot, otherwise it's every module on the device.
   std::map<MId, std::string> text;
-  for (size_t i = 0, ie = slots_.size(); i < ie; ++i) {
-    if (slots_[i].state != State::FREE) {
-      text.insert(std::make_pair(i, slots_[i].text));
+  if (independent_slots()) {
+    text.insert(std::make_pair(slot, slots_[slot].text));
+  } else {
+    for (size_t i = 0, ie = slots_.size(); i < ie; ++i) {
+      if (slots_[i].state != State::FREE) {
+        text.insert(std::make_pair(i, slots_[i].text));
+      }
     }
   }
+  return get_text(text);
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline std::string AvmmCompiler<M,V,A,T>::get_text(const std::map<MId, std::string>& text) {
+  std::stringstream ss;
+  indstream os(ss);
 
   // Module Declarations
   for (const auto& s : text) {
@@ -103,6 +103,8 @@ class AvmmLogic : public Logic {
 
     // Control State:
     bool there_were_tasks_;
+    bool refresh_;
+    std::vector<T> dirty_;
     VarTable<V,A,T> table_;
     std::unordered_map<FId, interfacestream*> streams_;
     std::vector<std::pair<FId, interfacestream*>> stream_cache_;
@@ -160,6 +162,7 @@ inline AvmmLogic<V,A,T>::AvmmLogic(Interface* interface, ModuleDeclaration* src,
   cb_ = nullptr;
   slot_ = slot;
   tasks_.push_back(nullptr);
+  refresh_ = true;
 }
 
 template <size_t V, typename A, typename T>
@@ -199,6 +202,7 @@ inline AvmmLogic<V,A,T>& AvmmLogic<V,A,T>::set_output(const Identifier* id, VId
   if (table_.find(id) == table_.end()) { 
     table_.insert(id);
   }
+  table_.track(id);
   outputs_.push_back(std::make_pair(id, vid));
   return *this;
 }
@@ -228,9 +232,16 @@ inline const VarTable<V,A,T>* AvmmLogic<V,A,T>::get_table() const {
 
 template <size_t V, typename A, typename T>
 inline State* AvmmLogic<V,A,T>::get_state() {
+  // State variables are inserted into the table consecutively, so this is
+  // streamed out in a single transfer.
+  std::vector<const Identifier*> ids;
+  for (const auto& sv : state_) {
+    ids.push_back(sv.second);
+  }
+  table_.read_vars(slot_, ids);
+
   auto* s = new State();
   for (const auto& sv : state_) {
-    table_.read_var(slot_, sv.second);
     s->insert(sv.first, eval_.get_array_value(sv.second));
   }
   return s;
@@ -238,34 +249,44 @@ inline State* AvmmLogic<V,A,T>::get_state() {
 
 template <size_t V, typename A, typename T>
 inline void AvmmLogic<V,A,T>::set_state(const State* s) {
-  table_.write_control_var(table_.reset_index(), 1);
+  std::vector<std::pair<const Identifier*, const Vector<Bits>*>> vals;
   for (const auto& sv : state_) {
     const auto itr = s->find(sv.first);
     if (itr != s->end()) {
-      table_.write_var(slot_, sv.second, itr->second);
+      vals.push_back(std::make_pair(sv.second, &itr->second));
     }
   }
-  table_.write_control_var(table_.reset_index(), 1);
-  table_.write_control_var(table_.resume_index(), 1);
+
+  table_.write_control_var(slot_, table_.reset_index(), 1);
+  table_.write_vars(slot_, vals);
+  table_.write_control_var(slot_, table_.reset_index(), 1);
+  table_.write_control_var(slot_, table_.resume_index(), 1);
+  refresh_ = true;
 }
 
 template <size_t V, typename A, typename T>
 inline Input* AvmmLogic<V,A,T>::get_input() {
+  std::vector<const Identifier*> ids;
+  for (const auto* id : inputs_) {
+    if (id != nullptr) {
+      ids.push_back(id);
+    }
+  }
+  table_.read_vars(slot_, ids);
+
   auto* i = new Input();
   for (size_t v = 0, ve = inputs_.size(); v < ve; ++v) {
     const auto* id = inputs_[v];
-    if (id == nullptr) {
-      continue;
+    if (id != nullptr) {
+      i->insert(v, eval_.get_value(id));
     }
-    table_.read_var(slot_, id);
-    i->insert(v, eval_.get_value(id));
   }
   return i;
 }
 
 template <size_t V, typename A, typename T>
 inline void AvmmLogic<V,A,T>::set_input(const Input* i) {
-  table_.write_control_var(table_.reset_index(), 1);
+  std::vector<std::pair<const Identifier*, const Bits*>> vals;
   for (size_t v = 0, ve = inputs_.size(); v < ve; ++v) {
     const auto* id = inputs_[v];
     if (id == nullptr) {
@@ -273,11 +294,15 @@ inline void AvmmLogic<V,A,T>::set_input(const Input* i) {
     }
     const auto itr = i->find(v);
     if (itr != i->end()) {
-      table_.write_var(slot_, id, itr->second);
+      vals.push_back(std::make_pair(id, &itr->second));
     }
   }
-  table_.write_control_var(table_.reset_index(), 1);
-  table_.write_control_var(table_.resume_index(), 1);
+
+  table_.write_control_var(slot_, table_.reset_index(), 1);
+  table_.write_vars(slot_, vals);
+  table_.write_control_var(slot_, table_.reset_index(), 1);
+  table_.write_control_var(slot_, table_.resume_index(), 1);
+  refresh_ = true;
 }
 
 template <size_t V, typename A, typename T>
@@ -322,22 +347,36 @@ template <size_t V, typename A, typename T>
 inline void AvmmLogic<V,A,T>::evaluate() {
   there_were_tasks_ = false;
   while (handle_tasks()) {
-    table_.write_control_var(table_.resume_index(), 1);
+    table_.write_control_var(slot_, table_.resume_index(), 1);
+  }
+
+  // Read the dirty bitmap, which also clears it, and only fetch the outputs
+  // which have changed since the last time we looked. The first evaluation
+  // after a change of state fetches everything.
+  dirty_.resize(table_.dirty_words());
+  for (size_t i = 0, ie = dirty_.size(); i < ie; ++i) {
+    dirty_[i] = table_.read_control_var(slot_, table_.dirty_index() + i);
   }
   for (const auto& o : outputs_) {
+    const auto b = table_.dirty_bit(o.first);
+    const auto d = (dirty_[b / std::numeric_limits<T>::digits] >> (b % std::numeric_limits<T>::digits)) & 1;
+    if (!refresh_ && !d) {
+      continue;
+    }
     table_.read_var(slot_, o.first);
     interface()->write(o.second, &eval_.get_value(o.first));
   }
+  refresh_ = false;
 }
 
 template <size_t V, typename A, typename T>
 inline bool AvmmLogic<V,A,T>::there_are_updates() const {
-  return table_.read_control_var(table_.there_are_updates_index()) != 0;
+  return table_.read_control_var(slot_, table_.there_are_updates_index()) != 0;
 }
 
 template <size_t V, typename A, typename T>
 inline void AvmmLogic<V,A,T>::update() {
-  table_.write_control_var(table_.apply_update_index(), 1);
+  table_.write_control_var(slot_, table_.apply_update_index(), 1);
   evaluate();
 }
 
@@ -358,19 +397,19 @@ inline size_t AvmmLogic<V,A,T>::open_loop(VId clk, bool val, size_t itr) {
   // ticks.  Loop here either until control returns without having hit a task
   // (indicating that we've finished) or it trips a task that requires
   // immediate attention.
-  table_.write_control_var(table_.open_loop_index(), itr);
+  table_.write_control_var(slot_, table_.open_loop_index(), itr);
   while (handle_tasks() && !there_were_tasks_) {
-    table_.write_control_var(table_.resume_index(), 1);
+    table_.write_control_var(slot_, table_.resume_index(), 1);
   }
 
   // If we hit a task that requires immediate attention, clear the open loop
   // counter, finish out this clock, and return the number of iterations that
   // we ran for. Otherwise, we finished our quota.
   if (there_were_tasks_) {
-    const auto res = table_.read_control_var(table_.open_loop_index());
-    table_.write_control_var(table_.open_loop_index(), 0);
+    const auto res = table_.read_control_var(slot_, table_.open_loop_index());
+    table_.write_control_var(slot_, table_.open_loop_index(), 0);
     while (handle_tasks()) {
-      table_.write_control_var(table_.resume_index(), 1);
+      table_.write_control_var(slot_, table_.resume_index(), 1);
     }
     return res;
   } else {
@@ -463,7 +502,7 @@ inline interfacestream* AvmmLogic<V,A,T>::get_stream(FId fd) {
 
 template <size_t V, typename A, typename T>
 inline bool AvmmLogic<V,A,T>::handle_tasks() {
-  volatile auto task_id = table_.read_control_var(table_.there_were_tasks_index());
+  volatile auto task_id = table_.read_control_var(slot_, table_.there_were_tasks_index());
   if (task_id == 0) {
     return false;
   }
@@ -495,7 +534,7 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
       }
       is.second->clear();
       is.second->flush();
-      table_.write_control_var(table_.feof_index(), (is.first << 1) | is.second->eof());
+      table_.write_control_var(slot_, table_.feof_index(), (is.first << 1) | is.second->eof());
 
       break;
     }
@@ -515,7 +554,7 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
       is.second->clear();
       is.second->seekg(offset, way); 
       is.second->seekp(offset, way); 
-      table_.write_control_var(table_.feof_index(), (is.first << 1) | is.second->eof());
+      table_.write_control_var(slot_, table_.feof_index(), (is.first << 1) | is.second->eof());
 
       break;
     }
@@ -535,7 +574,7 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
         table_.write_var(slot_, r, scanf_.get());
       }
       if (is.second->eof()) {
-        table_.write_control_var(table_.feof_index(), (is.first << 1) | 1);
+        table_.write_control_var(slot_, table_.feof_index(), (is.first << 1) | 1);
       }
 
       break;
@@ -552,7 +591,7 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
       ps->accept_expr(&sync_);
       printf_.write(*is.second, &eval_, ps);
       if (is.second->eof()) {
-        table_.write_control_var(table_.feof_index(), (is.first << 1) | 1);
+        table_.write_control_var(slot_, table_.feof_index(), (is.first << 1) | 1);
       }
 
       break;
@@ -74,6 +74,7 @@ class Rewrite {
     void emit_state_vars(ModuleDeclaration* res);
     void emit_trigger_vars(ModuleDeclaration* res, const TriggerIndex* ti);
     void emit_open_loop_vars(ModuleDeclaration* res);
+    void emit_dirty_vars(ModuleDeclaration* res, const VarTable<V,A,T>* vt);
 
     void emit_avalon_logic(ModuleDeclaration* res);
     void emit_update_logic(ModuleDeclaration* res, const VarTable<V,A,T>* vt);
@@ -81,8 +82,10 @@ class Rewrite {
     void emit_trigger_logic(ModuleDeclaration* res, const TriggerIndex* ti);
     void emit_open_loop_logic(ModuleDeclaration* res, const VarTable<V,A,T>* vt);
     void emit_var_logic(ModuleDeclaration* res, const ModuleDeclaration* md, const VarTable<V,A,T>* vt, const Machinify<T>* mfy, const Identifier* open_loop_clock);
+    void emit_dirty_logic(ModuleDeclaration* res, const ModuleDeclaration* md, const VarTable<V,A,T>* vt);
     void emit_output_logic(ModuleDeclaration* res, const ModuleDeclaration* md, const VarTable<V,A,T>* vt);
           
+    void emit_output_word(ItemBuilder& ib, ModuleInfo& info, const VarTable<V,A,T>* vt, const Identifier* id, size_t i) const;
     void emit_subscript(Identifier* id, size_t idx, size_t n, const std::vector<size_t>& arity) const;
     void emit_slice(Identifier* id, size_t w, size_t i) const;
 };
@@ -117,6 +120,7 @@ inline std::string Rewrite<M,V,A,T>::run(const ModuleDeclaration* md, size_t slo
   emit_state_vars(res);
   emit_trigger_vars(res, &ti);
   emit_open_loop_vars(res);
+  emit_dirty_vars(res, vt);
 
   // Emit original program logic
   TextMangle<V,A,T> tm(md, vt);
@@ -131,6 +135,7 @@ inline std::string Rewrite<M,V,A,T>::run(const ModuleDeclaration* md, size_t slo
   emit_trigger_logic(res, &ti);
   emit_open_loop_logic(res, vt);
   emit_var_logic(res, md, vt, &mfy, clock);
+  emit_dirty_logic(res, md, vt);
   emit_output_logic(res, md, vt);
 
   // Final cleanup passes
@@ -182,6 +187,7 @@ inline void Rewrite<M,V,A,T>::emit_avalon_vars(ModuleDeclaration* res) {
   ib << "wire __read_request;" << std::endl; 
   ib << "reg __write_prev = 0;" << std::endl;
   ib << "wire __write_request;" << std::endl; 
+  ib << "reg[" << (M+V-1) << ":0] __vid_prev = 0;" << std::endl;
   res->push_back_items(ib.begin(), ib.end()); 
 }
 
@@ -360,13 +366,35 @@ inline void Rewrite<M,V,A,T>::emit_open_loop_vars(ModuleDeclaration* res) {
   res->push_back_items(ib.begin(), ib.end());
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline void Rewrite<M,V,A,T>::emit_dirty_vars(ModuleDeclaration* res, const VarTable<V,A,T>* vt) {
+  if (vt->get_tracked().empty()) {
+    return;
+  }
+
+  size_t words = 0;
+  for (const auto* id : vt->get_tracked()) {
+    words += vt->find(id)->second.words_per_element;
+  }
+
+  ItemBuilder ib;
+  ib << "reg[" << (std::numeric_limits<T>::digits-1) << ":0] __prev_out[" << (words-1) << ":0];" << std::endl;
+  ib << "wire[" << (vt->dirty_words()*std::numeric_limits<T>::digits-1) << ":0] __dirty;" << std::endl;
+
+  res->push_back_items(ib.begin(), ib.end());
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline void Rewrite<M,V,A,T>::emit_avalon_logic(ModuleDeclaration* res) {
   ItemBuilder ib;
+  // A request is either the rising edge of read or write, or a change of
+  // address while either is held high. The latter allows a master to burst
+  // through a contiguous range of addresses without releasing the bus.
   ib << "always @(posedge __clk) __read_prev <= __read;" << std::endl;
-  ib << "assign __read_request = (!__read_prev && __read);" << std::endl;
   ib << "always @(posedge __clk) __write_prev <= __write;" << std::endl;
-  ib << "assign __write_request = (!__write_prev && __write);" << std::endl;
+  ib << "always @(posedge __clk) __vid_prev <= __vid;" << std::endl;
+  ib << "assign __read_request = __read && (!__read_prev || (__vid != __vid_prev));" << std::endl;
+  ib << "assign __write_request = __write && (!__write_prev || (__vid != __vid_prev));" << std::endl;
   res->push_back_items(ib.begin(), ib.end()); 
 }
 
@@ -541,6 +569,69 @@ inline void Rewrite<M,V,A,T>::emit_var_logic(ModuleDeclaration* res, const Modul
   res->push_back_items(ib.begin(), ib.end());
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline void Rewrite<M,V,A,T>::emit_dirty_logic(ModuleDeclaration* res, const ModuleDeclaration* md, const VarTable<V,A,T>* vt) {
+  const auto& tracked = vt->get_tracked();
+  if (tracked.empty()) {
+    return;
+  }
+  ModuleInfo info(md);
+
+  // Index the words in __prev_out which belong to each tracked variable
+  std::vector<size_t> offsets;
+  size_t words = 0;
+  for (const auto* id : tracked) {
+    offsets.push_back(words);
+    words += vt->find(id)->second.words_per_element;
+  }
+
+  // A variable is dirty if any of its words differ from the values which
+  // were last visible to the host, with bitmap bits in tracking order.
+  ItemBuilder ib;
+  ib << "assign __dirty = {";
+  const auto pad = vt->dirty_words()*std::numeric_limits<T>::digits - tracked.size();
+  if (pad > 0) {
+    ib << pad << "'d0,";
+  }
+  for (size_t k = tracked.size(); k-- > 0; ) {
+    const auto n = vt->find(tracked[k])->second.words_per_element;
+    ib << "|{";
+    for (size_t i = 0; i < n; ++i) {
+      emit_output_word(ib, info, vt, tracked[k], i);
+      ib << " != __prev_out[" << (offsets[k]+i) << "]";
+      if ((i+1) != n) {
+        ib << ",";
+      }
+    }
+    ib << "}";
+    if (k != 0) {
+      ib << ",";
+    }
+  }
+  ib << "};" << std::endl;
+
+  // Reading a word of the bitmap clears the bits that it contains. The host
+  // only reads the bitmap when the module is quiescent, so it's safe to
+  // assume that every dirty variable is fetched immediately afterwards.
+  ib << "always @(posedge __clk) begin" << std::endl;
+  for (size_t w = 0, we = vt->dirty_words(); w < we; ++w) {
+    ib << "if (__write_request && (__vid == " << (vt->dirty_index()+w) << ")) begin" << std::endl;
+    const auto begin = w * std::numeric_limits<T>::digits;
+    const auto end = std::min(begin + std::numeric_limits<T>::digits, tracked.size());
+    for (auto k = begin; k < end; ++k) {
+      for (size_t i = 0, ie = vt->find(tracked[k])->second.words_per_element; i < ie; ++i) {
+        ib << "__prev_out[" << (offsets[k]+i) << "] <= ";
+        emit_output_word(ib, info, vt, tracked[k], i);
+        ib << ";" << std::endl;
+      }
+    }
+    ib << "end" << std::endl;
+  }
+  ib << "end" << std::endl;
+
+  res->push_back_items(ib.begin(), ib.end());
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline void Rewrite<M,V,A,T>::emit_output_logic(ModuleDeclaration* res, const ModuleDeclaration* md, const VarTable<V,A,T>* vt) {
   ModuleInfo info(md);      
@@ -577,6 +668,9 @@ inline void Rewrite<M,V,A,T>::emit_output_logic(ModuleDeclaration* res, const Mo
   ib << vt->there_were_tasks_index() << ": __out = __task_id[0];" << std::endl;
   ib << vt->open_loop_index() << ": __out = __open_loop;" << std::endl;
   ib << vt->debug_index() << ": __out = __state[0];" << std::endl;
+  for (size_t w = 0, we = vt->dirty_words(); w < we; ++w) {
+    ib << (vt->dirty_index()+w) << ": __out = __dirty[" << ((w+1)*std::numeric_limits<T>::digits-1) << ":" << (w*std::numeric_limits<T>::digits) << "];" << std::endl;
+  }
   ib << "default: __out = __var[__vid];" << std::endl;
   ib << "endcase" << std::endl;
   ib << "assign __wait = __read_request || __write_request || __open_loop_tick || __any_triggers || __continue;" << std::endl;
@@ -584,6 +678,24 @@ inline void Rewrite<M,V,A,T>::emit_output_logic(ModuleDeclaration* res, const Mo
   res->push_back_items(ib.begin(), ib.end());
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline void Rewrite<M,V,A,T>::emit_output_word(ItemBuilder& ib, ModuleInfo& info, const VarTable<V,A,T>* vt, const Identifier* id, size_t i) const {
+  // This mirrors the value that the host sees when it reads this word:
+  // stateful variables are read out of the var table, everything else is
+  // sliced directly out of the original variable.
+  const auto itr = vt->find(id);
+  assert(itr != vt->end());
+  if (info.is_input(id) || info.is_stateful(id)) {
+    ib << "__var[" << (itr->second.begin+i) << "]";
+    return;
+  }
+  auto* c = id->clone();
+  c->purge_dim();
+  emit_slice(c, itr->second.bits_per_element, i);
+  ib << c;
+  delete c;
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline void Rewrite<M,V,A,T>::emit_subscript(Identifier* id, size_t idx, size_t n, const std::vector<size_t>& arity) const {
   for (auto a : arity) {
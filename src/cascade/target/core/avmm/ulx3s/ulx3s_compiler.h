@@ -35,10 +35,8 @@
 #include <fcntl.h>
 #include <fstream>
 #include <termios.h>
-#include <sstream>
 #include <string>
 #include <type_traits>
-#include <unordered_map>
 #include <unordered_set>
 #include "common/system.h"
 #include "target/core/avmm/avmm_compiler.h"
@@ -59,25 +57,16 @@ class Ulx3sCompiler : public AvmmCompiler<M,V,A,T> {
     // Logic Core Handles:
     std::unordered_set<Ulx3sLogic<V,A,T>*> logic_;
 
-    // Compilation Cache:
-    std::unordered_map<std::string, std::string> cache_;
-
     // Avmm Compiler Interface:
     Ulx3sLogic<V,A,T>* build(Interface* interface, ModuleDeclaration* md, size_t slot) override;
     bool compile(const std::string& text, std::mutex& lock) override;
     void stop_compile() override;
-
-    // Helper Methods:
-    void init_tmp();
-    void init_cache();
 };
 
 using Ulx3s32Compiler = Ulx3sCompiler<10,21,uint32_t,uint32_t>;
 
 template <size_t M, size_t V, typename A, typename T>
 inline Ulx3sCompiler<M,V,A,T>::Ulx3sCompiler() : AvmmCompiler<M,V,A,T>() {
-  init_tmp();
-  init_cache();
   fd_ = -1;
 }
 
@@ -104,14 +93,19 @@ inline bool Ulx3sCompiler<M,V,A,T>::compile(const std::string& text, std::mutex&
   // Stop any previous compilations
   stop_compile();
 
-  // Compile a cache entry if none previously existed
-  if (cache_.find(text) == cache_.end()) {
-    char path[] = "/tmp/ulx3s/program_logic_XXXXXX.v";
-    const auto fd = mkstemps(path, 2);
-    const auto dir = std::string(path).substr(0,31);
-    close(fd);
+  // Create a fresh working directory
+  System::execute("mkdir -p /tmp/ulx3s/");
+  char path[] = "/tmp/ulx3s/program_logic_XXXXXX.v";
+  const auto fd = mkstemps(path, 2);
+  const auto dir = std::string(path).substr(0,31);
+  close(fd);
+  System::execute("mkdir -p " + dir);
 
-    System::execute("mkdir -p " + dir);
+  // Compile a cache entry if none previously existed
+  auto& cache = AvmmCompiler<M,V,A,T>::get_compiler()->get_cache();
+  const auto key = "ulx3s" + std::to_string(8*sizeof(T)) + "\n" + text;
+  const auto bit = dir + "/root" + std::to_string(8*sizeof(T)) + ".bit";
+  if (!cache.get(key, bit)) {
     std::ofstream ofs(path);
     ofs << text << std::endl;
     ofs.close();
@@ -136,23 +130,13 @@ inline bool Ulx3sCompiler<M,V,A,T>::compile(const std::string& text, std::mutex&
     if (res != 0) {
       return false;
     }
-
-    std::stringstream ss;
-    ss << "bitstream_" << cache_.size() << ".bit";
-
-    std::ofstream ofs2;
-    if constexpr (std::is_same<T, uint32_t>::value) {
-      System::execute("cp " + dir + "/root32.bit /tmp/ulx3s/cache32/" + ss.str());
-      ofs2.open("/tmp/ulx3s/cache32/index.txt", std::ios::app);
-      ofs2 << text << '\0' << "/tmp/ulx3s/cache32/" << ss.str() << '\0';
-      cache_[text] = "/tmp/ulx3s/cache32/" + ss.str();
-    }
+    cache.put(key, bit);
   }
 
   // If control has reached here, we have a lock on the device and a bitstream
-  // in the cache.  Schedule a state-safe interrupt to reprogram the device.
-  const auto path = cache_[text];
-  AvmmCompiler<M,V,A,T>::get_compiler()->schedule_state_safe_interrupt([this, path]{
+  // in the working directory.  Schedule a state-safe interrupt to reprogram
+  // the device.
+  AvmmCompiler<M,V,A,T>::get_compiler()->schedule_state_safe_interrupt([this, bit]{
     // Close the device if necessary
     if (fd_ >= 0) {
       close(fd_);
@@ -160,7 +144,7 @@ inline bool Ulx3sCompiler<M,V,A,T>::compile(const std::string& text, std::mutex&
 
     // Reprogram the device
     if constexpr (std::is_same<T, uint32_t>::value) {
-      System::no_block_execute("ujprog -b 3000000 " + path, false);
+      System::no_block_execute("ujprog -b 3000000 " + bit, false);
     }
   
     // Reopen the device
@@ -216,31 +200,6 @@ inline void Ulx3sCompiler<M,V,A,T>::stop_compile() {
   } 
 }
 
-template <size_t M, size_t V, typename A, typename T>
-inline void Ulx3sCompiler<M,V,A,T>::init_tmp() {
-  System::execute("mkdir -p /tmp/ulx3s");
-  System::execute("mkdir -p /tmp/ulx3s/cache32");
-  System::execute("touch /tmp/ulx3s/cache32/index.txt");
-}
-
-template <size_t M, size_t V, typename A, typename T>
-inline void Ulx3sCompiler<M,V,A,T>::init_cache() {
-  std::ifstream ifs;
-  if constexpr (std::is_same<T, uint32_t>::value) {
-    ifs.open("/tmp/ulx3s/cache32/index.txt");
-  }
-  while (true) {
-    std::string text;
-    getline(ifs, text, '\0');
-    if (ifs.eof()) {
-      break;
-    } 
-    std::string path;
-    getline(ifs, path, '\0');
-    cache_.insert(make_pair(text, path));
-  } 
-}
-
 } // namespace cascade::avmm
 
 #endif
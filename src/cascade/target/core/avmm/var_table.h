@@ -31,9 +31,13 @@
 #ifndef CASCADE_SRC_TARGET_CORE_AVMM_VAR_TABLE_H
 #define CASCADE_SRC_TARGET_CORE_AVMM_VAR_TABLE_H
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
+#include <limits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include "common/bits.h"
 #include "common/vector.h"
 #include "verilog/analyze/evaluate.h"
@@ -56,6 +60,8 @@ class VarTable {
     // IO Typedefs:
     typedef std::function<T(A)> Read;
     typedef std::function<void(A, T)> Write;
+    typedef std::function<void(A, T*, size_t)> ReadBurst;
+    typedef std::function<void(A, const T*, size_t)> WriteBurst;
 
     // Iterator Typedefs:
     typedef typename std::unordered_map<const Identifier*, const Row>::const_iterator const_iterator;
@@ -66,9 +72,16 @@ class VarTable {
     // Configuration Interface:
     VarTable& set_read(Read read);
     VarTable& set_write(Write write);
+    // Optional bulk transfer handlers. When these are provided, variables
+    // which span more than one word are moved in a single call over their
+    // contiguous address range rather than a word at a time.
+    VarTable& set_read_burst(ReadBurst read_burst);
+    VarTable& set_write_burst(WriteBurst write_burst);
 
     // Inserts an element into the table.
     void insert(const Identifier* id);
+    // Assigns a bit in the dirty bitmap to an element in the table.
+    void track(const Identifier* id);
     // Returns the number of words in the var table.
     size_t size() const;
 
@@ -97,11 +110,19 @@ class VarTable {
     size_t feof_index() const;
     // Reserved for debugging
     size_t debug_index() const;
+    // Returns the address of the first word of the dirty bitmap.
+    size_t dirty_index() const;
+    // Returns the number of words in the dirty bitmap.
+    size_t dirty_words() const;
+    // Returns the position of this identifier in the dirty bitmap.
+    size_t dirty_bit(const Identifier* id) const;
+    // Returns the identifiers in the dirty bitmap, in bitmap order.
+    const std::vector<const Identifier*>& get_tracked() const;
 
     // Reads the value of a control variable
-    T read_control_var(size_t index) const;
+    T read_control_var(size_t slot, size_t index) const;
     // Writes the value of a control variable
-    void write_control_var(size_t index, T val);
+    void write_control_var(size_t slot, size_t index, T val);
 
     // Reads the value of a variable
     void read_var(size_t slot, const Identifier* id) const; 
@@ -110,12 +131,37 @@ class VarTable {
     // Writes the value of an array variable
     void write_var(size_t slot, const Identifier* id, const Vector<Bits>& val);
 
+    // Reads the values of a set of variables. Variables which occupy adjacent
+    // addresses are streamed in a single transfer, so the cost of reading a
+    // set of variables which were inserted consecutively is proportional to
+    // the number of words rather than the number of variables.
+    void read_vars(size_t slot, std::vector<const Identifier*> ids) const;
+    // Writes the values of a set of variables, with the same semantics as
+    // read_vars. B may be either Bits or Vector<Bits>.
+    template <typename B>
+    void write_vars(size_t slot, std::vector<std::pair<const Identifier*, const B*>> vals);
+
   private:
     Read read_;
     Write write_;
+    ReadBurst read_burst_;
+    WriteBurst write_burst_;
 
     size_t next_index_;
     std::unordered_map<const Identifier*, const Row> vtable_;
+    std::unordered_map<const Identifier*, size_t> dirty_;
+    std::vector<const Identifier*> tracked_;
+
+    // Scratch space for bulk transfers:
+    mutable std::vector<T> buffer_;
+
+    // Serializes a value into the buffer, beginning at word idx
+    void encode(const Row& row, const Bits& val, size_t idx);
+    void encode(const Row& row, const Vector<Bits>& val, size_t idx);
+
+    // Moves n words beginning at addr, using the burst handlers if possible
+    void read_words(A addr, T* words, size_t n) const;
+    void write_words(A addr, const T* words, size_t n);
 };
 
 template <size_t V, typename A, typename T>
@@ -135,6 +181,18 @@ inline VarTable<V,A,T>& VarTable<V,A,T>::set_write(Write write) {
   return *this;
 }
 
+template <size_t V, typename A, typename T>
+inline VarTable<V,A,T>& VarTable<V,A,T>::set_read_burst(ReadBurst read_burst) {
+  read_burst_ = read_burst;
+  return *this;
+}
+
+template <size_t V, typename A, typename T>
+inline VarTable<V,A,T>& VarTable<V,A,T>::set_write_burst(WriteBurst write_burst) {
+  write_burst_ = write_burst;
+  return *this;
+}
+
 template <size_t V, typename A, typename T>
 inline void VarTable<V,A,T>::insert(const Identifier* id) {
   assert(find(id) == end());
@@ -154,9 +212,18 @@ inline void VarTable<V,A,T>::insert(const Identifier* id) {
   next_index_ += (row.elements * row.words_per_element);
 }
 
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::track(const Identifier* id) {
+  assert(find(id) != end());
+  if (dirty_.find(id) == dirty_.end()) {
+    dirty_.insert(std::make_pair(id, tracked_.size()));
+    tracked_.push_back(id);
+  }
+}
+
 template <size_t V, typename A, typename T>
 inline size_t VarTable<V,A,T>::size() const {
-  return debug_index() + 1;
+  return dirty_index() + dirty_words();
 }
 
 template <size_t V, typename A, typename T>
@@ -178,7 +245,7 @@ template <size_t V, typename A, typename T>
 inline size_t VarTable<V,A,T>::index(const Identifier* id) const {
   const auto itr = vtable_.find(id);
   assert(itr != vtable_.end());
-  return itr->second.index_;
+  return itr->second.begin;
 }
 
 template <size_t V, typename A, typename T>
@@ -222,17 +289,39 @@ inline size_t VarTable<V,A,T>::debug_index() const {
 }
 
 template <size_t V, typename A, typename T>
-inline T VarTable<V,A,T>::read_control_var(size_t index) const {
+inline size_t VarTable<V,A,T>::dirty_index() const {
+  return next_index_ + 8;
+}
+
+template <size_t V, typename A, typename T>
+inline size_t VarTable<V,A,T>::dirty_words() const {
+  return (tracked_.size() + std::numeric_limits<T>::digits - 1) / std::numeric_limits<T>::digits;
+}
+
+template <size_t V, typename A, typename T>
+inline size_t VarTable<V,A,T>::dirty_bit(const Identifier* id) const {
+  const auto itr = dirty_.find(id);
+  assert(itr != dirty_.end());
+  return itr->second;
+}
+
+template <size_t V, typename A, typename T>
+inline const std::vector<const Identifier*>& VarTable<V,A,T>::get_tracked() const {
+  return tracked_;
+}
+
+template <size_t V, typename A, typename T>
+inline T VarTable<V,A,T>::read_control_var(size_t slot, size_t index) const {
   assert(index >= there_are_updates_index());
-  assert(index <= debug_index());
-  return read_(index);
+  assert(index < size());
+  return read_((slot << V) | index);
 }
 
 template <size_t V, typename A, typename T>
-inline void VarTable<V,A,T>::write_control_var(size_t index, T val) {
+inline void VarTable<V,A,T>::write_control_var(size_t slot, size_t index, T val) {
   assert(index >= there_are_updates_index());
   assert(index <= debug_index());
-  write_(index, val);
+  write_((slot << V) | index, val);
 }
 
 template <size_t V, typename A, typename T>
@@ -240,14 +329,10 @@ inline void VarTable<V,A,T>::read_var(size_t slot, const Identifier* id) const {
   const auto itr = vtable_.find(id);
   assert(itr != vtable_.end());
 
-  auto idx = itr->second.begin;
-  for (size_t i = 0; i < itr->second.elements; ++i) {
-    for (size_t j = 0; j < itr->second.words_per_element; ++j) {
-      const volatile auto word = read_((slot << V) | idx);
-      Evaluate().assign_word<T>(id, i, j, word);
-      ++idx;
-    } 
-  }
+  const auto n = itr->second.words_per_element;
+  buffer_.resize(itr->second.elements * n);
+  read_words((slot << V) | itr->second.begin, buffer_.data(), buffer_.size());
+  Evaluate().assign_words<T>(id, buffer_.data(), n);
 }
 
 template <size_t V, typename A, typename T>
@@ -256,12 +341,9 @@ inline void VarTable<V,A,T>::write_var(size_t slot, const Identifier* id, const
   assert(itr != vtable_.end());
   assert(itr->second.elements == 1);
 
-  auto idx = itr->second.begin;
-  for (size_t j = 0; j < itr->second.words_per_element; ++j) {
-    const volatile auto word = val.read_word<T>(j);
-    write_((slot << V) | idx, word);
-    ++idx;
-  }
+  buffer_.resize(itr->second.words_per_element);
+  encode(itr->second, val, 0);
+  write_words((slot << V) | itr->second.begin, buffer_.data(), buffer_.size());
 }
 
 template <size_t V, typename A, typename T>
@@ -270,16 +352,100 @@ inline void VarTable<V,A,T>::write_var(size_t slot, const Identifier* id, const
   assert(itr != vtable_.end());
   assert(val.size() == itr->second.elements);
 
-  auto idx = itr->second.begin;
-  for (size_t i = 0; i < itr->second.elements; ++i) {
-    for (size_t j = 0; j < itr->second.words_per_element; ++j) {
-      const volatile auto word = val[i].read_word<T>(j);
-      write_((slot << V) | idx, word);
-      ++idx;
+  buffer_.resize(itr->second.elements * itr->second.words_per_element);
+  encode(itr->second, val, 0);
+  write_words((slot << V) | itr->second.begin, buffer_.data(), buffer_.size());
+}
+
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::read_vars(size_t slot, std::vector<const Identifier*> ids) const {
+  std::sort(ids.begin(), ids.end(), [this](auto x, auto y) {
+    return index(x) < index(y);
+  });
+  for (size_t i = 0, ie = ids.size(); i < ie; ) {
+    // Find the longest run of adjacent variables starting from here
+    const auto begin = index(ids[i]);
+    auto end = begin;
+    auto j = i;
+    for (; (j < ie) && (index(ids[j]) == end); ++j) {
+      const auto& row = vtable_.find(ids[j])->second;
+      end += row.elements * row.words_per_element;
+    }
+    // Stream it in and then hand out the pieces
+    buffer_.resize(end - begin);
+    read_words((slot << V) | begin, buffer_.data(), buffer_.size());
+    for (; i < j; ++i) {
+      const auto& row = vtable_.find(ids[i])->second;
+      Evaluate().assign_words<T>(ids[i], buffer_.data() + (row.begin - begin), row.words_per_element);
+    }
+  }
+}
+
+template <size_t V, typename A, typename T>
+template <typename B>
+inline void VarTable<V,A,T>::write_vars(size_t slot, std::vector<std::pair<const Identifier*, const B*>> vals) {
+  std::sort(vals.begin(), vals.end(), [this](const auto& x, const auto& y) {
+    return index(x.first) < index(y.first);
+  });
+  for (size_t i = 0, ie = vals.size(); i < ie; ) {
+    // Find the longest run of adjacent variables starting from here
+    const auto begin = index(vals[i].first);
+    auto end = begin;
+    auto j = i;
+    for (; (j < ie) && (index(vals[j].first) == end); ++j) {
+      const auto& row = vtable_.find(vals[j].first)->second;
+      end += row.elements * row.words_per_element;
+    }
+    // Pack the pieces and then stream them out
+    buffer_.resize(end - begin);
+    for (; i < j; ++i) {
+      const auto& row = vtable_.find(vals[i].first)->second;
+      encode(row, *vals[i].second, row.begin - begin);
+    }
+    write_words((slot << V) | begin, buffer_.data(), buffer_.size());
+  }
+}
+
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::encode(const Row& row, const Bits& val, size_t idx) {
+  assert(row.elements == 1);
+  for (size_t j = 0; j < row.words_per_element; ++j) {
+    buffer_[idx++] = val.read_word<T>(j);
+  }
+}
+
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::encode(const Row& row, const Vector<Bits>& val, size_t idx) {
+  assert(val.size() == row.elements);
+  for (size_t i = 0; i < row.elements; ++i) {
+    for (size_t j = 0; j < row.words_per_element; ++j) {
+      buffer_[idx++] = val[i].read_word<T>(j);
     }
   }
 }
 
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::read_words(A addr, T* words, size_t n) const {
+  if ((n > 1) && (read_burst_ != nullptr)) {
+    read_burst_(addr, words, n);
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    words[i] = read_(addr+i);
+  }
+}
+
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::write_words(A addr, const T* words, size_t n) {
+  if ((n > 1) && (write_burst_ != nullptr)) {
+    write_burst_(addr, words, n);
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    write_(addr+i, words[i]);
+  }
+}
+
 } // namespace cascade::avmm
 
 #endif
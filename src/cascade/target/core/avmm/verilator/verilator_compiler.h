@@ -31,11 +31,17 @@
 #ifndef CASCADE_SRC_TARGET_CORE_AVMM_VERILATOR_VERILATOR_COMPILER_H
 #define CASCADE_SRC_TARGET_CORE_AVMM_VERILATOR_VERILATOR_COMPILER_H
 
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <dlfcn.h>
 #include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
 #include <thread>
 #include <type_traits>
+#include <vector>
 #include "common/system.h"
 #include "target/core/avmm/avmm_compiler.h"
 #include "target/core/avmm/verilator/verilator_logic.h"
@@ -48,21 +54,42 @@ class VerilatorCompiler : public AvmmCompiler<M,V,A,T> {
     VerilatorCompiler();
     ~VerilatorCompiler() override;
 
+    // Configuration Interface:
+    //
+    // Sets the optimization level and whether link-time optimization is used
+    // when building verilated models. Lower levels trade simulation speed for
+    // compilation latency.
+    VerilatorCompiler& set_opt_level(size_t level);
+    VerilatorCompiler& set_lto(bool lto);
+    // Sets the number of compiler processes to run in parallel. Setting n to
+    // zero uses one process per hardware thread.
+    VerilatorCompiler& set_num_jobs(size_t n);
+
   private:
     // Avmm Compiler Interface:
     VerilatorLogic<V,A,T>* build(Interface* interface, ModuleDeclaration* md, size_t slot) override;
     bool compile(const std::string& text, std::mutex& lock) override;
     void stop_compile() override;
-
-    // Verilator Control Thread:
-    std::thread verilator_;
-
-    // Shared Library Handles:
-    void* handle_;
-    void (*stop_)();
-
-    // Logic Core Handle:
-    VerilatorLogic<V,A,T>* logic_;
+    bool independent_slots() const override;
+
+    // Build Options:
+    size_t opt_level_;
+    bool lto_;
+    size_t num_jobs_;
+
+    // A description of everything other than the program text which goes
+    // into a build. Computed on first use.
+    std::string toolchain_;
+    const std::string& toolchain();
+
+    // Each slot is hosted by its own verilated model, loaded side by side
+    // from a separate shared library.
+    struct Model {
+      void* handle;
+      void (*stop)();
+      VerilatorLogic<V,A,T>* logic;
+    };
+    std::vector<Model> models_;
 };
 
 using Verilator32Compiler = VerilatorCompiler<2,12,uint16_t,uint32_t>;
@@ -70,27 +97,50 @@ using Verilator64Compiler = VerilatorCompiler<8,20,uint32_t,uint64_t>;
 
 template <size_t M, size_t V, typename A, typename T>
 inline VerilatorCompiler<M,V,A,T>::VerilatorCompiler() : AvmmCompiler<M,V,A,T>() {
-  handle_ = nullptr;
+  set_opt_level(3);
+  set_lto(true);
+  set_num_jobs(0);
+  models_.resize(T(1) << M, {nullptr, nullptr, nullptr});
 }
 
 template <size_t M, size_t V, typename A, typename T>
 inline VerilatorCompiler<M,V,A,T>::~VerilatorCompiler() {
-  if (handle_ != nullptr) {
-    stop_();
-    verilator_.join();
-    dlclose(handle_);
+  for (auto& m : models_) {
+    if (m.handle != nullptr) {
+      m.stop();
+      dlclose(m.handle);
+    }
   }
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline VerilatorCompiler<M,V,A,T>& VerilatorCompiler<M,V,A,T>::set_opt_level(size_t level) {
+  opt_level_ = level;
+  return *this;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline VerilatorCompiler<M,V,A,T>& VerilatorCompiler<M,V,A,T>::set_lto(bool lto) {
+  lto_ = lto;
+  return *this;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline VerilatorCompiler<M,V,A,T>& VerilatorCompiler<M,V,A,T>::set_num_jobs(size_t n) {
+  num_jobs_ = (n == 0) ? std::max(1u, std::thread::hardware_concurrency()) : n;
+  return *this;
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline VerilatorLogic<V,A,T>* VerilatorCompiler<M,V,A,T>::build(Interface* interface, ModuleDeclaration* md, size_t slot) {
-  logic_ = new VerilatorLogic<V,A,T>(interface, md, slot);
-  return logic_;
+  models_[slot].logic = new VerilatorLogic<V,A,T>(interface, md, slot);
+  return models_[slot].logic;
 }
 
 template <size_t M, size_t V, typename A, typename T>
 inline bool VerilatorCompiler<M,V,A,T>::compile(const std::string& text, std::mutex& lock) {
   stop_compile();
+  const auto slot = AvmmCompiler<M,V,A,T>::get_lead();
 
   System::execute("mkdir -p /tmp/verilator/");
   char path[] = "/tmp/verilator/program_logic_XXXXXX.v";
@@ -103,44 +153,94 @@ inline bool VerilatorCompiler<M,V,A,T>::compile(const std::string& text, std::mu
   ofs << text << std::endl;
   ofs.close();
 
-  pid_t pid = 0;
-  if constexpr (std::is_same<T, uint32_t>::value) {
-    pid = System::no_block_begin_execute("cd " + System::src_root() + "/share/cascade/verilator/ && ./build_verilator_32.sh " + dir + " " + System::cxx_compiler(), false);
-  } else if constexpr (std::is_same<T, uint64_t>::value) {
-    pid = System::no_block_begin_execute("cd " + System::src_root() + "/share/cascade/verilator/ && ./build_verilator_64.sh " + dir + " " + System::cxx_compiler(), false);
-  } 
-
-  lock.unlock();
-  const auto res = System::no_block_wait_finish(pid);
-  lock.lock();
-
-  if (res != 0) {
-    return false;
+  // The shared object is a function of the program text, the toolchain, and
+  // its flags. If we've built it before, there's no need to do so again.
+  auto& cache = AvmmCompiler<M,V,A,T>::get_compiler()->get_cache();
+  const auto args = std::to_string(opt_level_) + " " + (lto_ ? "1" : "0");
+  const auto key = toolchain() + args + "\n" + text;
+  const auto so = dir + "/libverilator.so";
+  if (!cache.get(key, so)) {
+    pid_t pid = 0;
+    if constexpr (std::is_same<T, uint32_t>::value) {
+      pid = System::no_block_begin_execute("cd " + System::src_root() + "/share/cascade/verilator/ && ./build_verilator_32.sh " + dir + " " + System::cxx_compiler() + " " + args + " " + std::to_string(num_jobs_), false);
+    } else if constexpr (std::is_same<T, uint64_t>::value) {
+      pid = System::no_block_begin_execute("cd " + System::src_root() + "/share/cascade/verilator/ && ./build_verilator_64.sh " + dir + " " + System::cxx_compiler() + " " + args + " " + std::to_string(num_jobs_), false);
+    } 
+
+    lock.unlock();
+    const auto res = System::no_block_wait_finish(pid);
+    lock.lock();
+
+    if (res != 0) {
+      return false;
+    }
+    cache.put(key, so);
   }
     
-  AvmmCompiler<M,V,A,T>::get_compiler()->schedule_state_safe_interrupt([this, dir]{
-    if (handle_ != nullptr) {
-      stop_();
-      verilator_.join();
-      dlclose(handle_);
+  // Only the model in this slot is replaced. Models are loaded locally so
+  // that the symbols in one library can't bind to those of another.
+  AvmmCompiler<M,V,A,T>::get_compiler()->schedule_state_safe_interrupt([this, slot, so]{
+    auto& m = models_[slot];
+    if (m.handle != nullptr) {
+      m.stop();
+      dlclose(m.handle);
     }
     
-    handle_ = dlopen((dir + "/libverilator.so").c_str(), RTLD_LAZY);
-    stop_ = (void (*)()) dlsym(handle_, "verilator_stop");
+    m.handle = dlopen(so.c_str(), RTLD_LAZY | RTLD_LOCAL);
+    m.stop = (void (*)()) dlsym(m.handle, "verilator_stop");
     
-    auto read = (T (*)(A)) dlsym(handle_, "verilator_read");
-    auto write = (void (*)(A, T)) dlsym(handle_, "verilator_write");
-    logic_->set_io(read, write);
+    auto read = (T (*)(A)) dlsym(m.handle, "verilator_read");
+    auto write = (void (*)(A, T)) dlsym(m.handle, "verilator_write");
+    m.logic->set_io(read, write);
+    auto read_burst = (void (*)(A, T*, uint32_t)) dlsym(m.handle, "verilator_read_burst");
+    auto write_burst = (void (*)(A, const T*, uint32_t)) dlsym(m.handle, "verilator_write_burst");
+    if ((read_burst != nullptr) && (write_burst != nullptr)) {
+      m.logic->set_burst_io(read_burst, write_burst);
+    }
     
-    auto init = (void (*)()) dlsym(handle_, "verilator_init");
+    // Bus transactions run to completion in the calling thread, so there's
+    // no need to start a thread to drive the clock.
+    auto init = (void (*)()) dlsym(m.handle, "verilator_init");
     init();
-    auto start = (void (*)()) dlsym(handle_, "verilator_start");
-    verilator_ = std::thread(start);
   });
 
   return true;
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline bool VerilatorCompiler<M,V,A,T>::independent_slots() const {
+  return true;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline const std::string& VerilatorCompiler<M,V,A,T>::toolchain() {
+  if (!toolchain_.empty()) {
+    return toolchain_;
+  }
+
+  // Verilator's output changes between releases, and the harness and build
+  // script are compiled into every library, so a change to any of them
+  // invalidates what we've cached.
+  const auto w = std::to_string(8*sizeof(T));
+  std::stringstream ss;
+  ss << "verilator" << w << "\n" << System::cxx_compiler() << "\n";
+  if (auto* p = popen("verilator --version 2>&1", "r")) {
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), p) != nullptr) {
+      ss << buffer;
+    }
+    pclose(p);
+  }
+  const auto dir = System::src_root() + "/share/cascade/verilator/";
+  for (const auto& f : {"harness_" + w + ".cpp", "build_verilator_" + w + ".sh", std::string("fake_main.cpp")}) {
+    std::ifstream ifs(dir + f, std::ios::binary);
+    const std::string contents((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ss << f << " " << ArtifactCache::hash(contents.data(), contents.size()) << "\n";
+  }
+  toolchain_ = ss.str();
+  return toolchain_;
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline void VerilatorCompiler<M,V,A,T>::stop_compile() {
   if constexpr (std::is_same<T, uint32_t>::value) {
@@ -44,6 +44,7 @@ class VerilatorLogic : public AvmmLogic<V,A,T> {
     virtual ~VerilatorLogic() override = default;
 
     void set_io(T(*read)(A), void(*write)(A,T)); 
+    void set_burst_io(void(*read_burst)(A,T*,uint32_t), void(*write_burst)(A,const T*,uint32_t));
 };
 
 template <size_t V, typename A, typename T>
@@ -59,6 +60,16 @@ inline void VerilatorLogic<V,A,T>::set_io(T(*read)(A), void(write)(A,T)) {
   });
 }
 
+template <size_t V, typename A, typename T>
+inline void VerilatorLogic<V,A,T>::set_burst_io(void(*read_burst)(A,T*,uint32_t), void(*write_burst)(A,const T*,uint32_t)) {
+  AvmmLogic<V,A,T>::get_table()->set_read_burst([read_burst](A index, T* vals, size_t n) {
+    read_burst(index, vals, n);
+  });
+  AvmmLogic<V,A,T>::get_table()->set_write_burst([write_burst](A index, const T* vals, size_t n) {
+    write_burst(index, vals, n);
+  });
+}
+
 } // namespace cascade::avmm
 
 #endif
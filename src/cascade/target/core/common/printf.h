@@ -31,64 +31,80 @@
 #ifndef CASCADE_SRC_TARGET_CORE_COMMON_PRINTF_H
 #define CASCADE_SRC_TARGET_CORE_COMMON_PRINTF_H
 
+#include <cctype>
 #include <cstdio>
 #include <iostream>
+#include <string>
 #include "verilog/analyze/evaluate.h"
 #include "verilog/ast/ast.h"
 
 namespace cascade {
 
 struct Printf {
+  // A format string which has been parsed ahead of time. Op is zero for
+  // literal text, and the lower-case conversion character otherwise. Text
+  // holds the original string, which is what's printed for literals and
+  // what's handed to snprintf for conversions we don't handle natively.
+  struct Format {
+    char op;
+    std::string text;
+  };
+  static Format compile(const PutStatement* ps);
+
   void write(std::ostream& os, Evaluate* eval, const PutStatement* ps) const;
+  void write(std::ostream& os, Evaluate* eval, const PutStatement* ps, const Format& fmt) const;
 };
 
+inline Printf::Format Printf::compile(const PutStatement* ps) {
+  Format res;
+  res.text = ps->get_fmt()->get_readable_val();
+  res.op = (res.text[0] == '%') ? std::tolower(res.text[1]) : 0;
+  return res;
+}
+
 inline void Printf::write(std::ostream& os, Evaluate* eval, const PutStatement* ps) const {
-  const auto* fmt = ps->get_fmt()->get_readable_val().c_str();
-  if (fmt[0] != '%') {
-    os << fmt;
+  write(os, eval, ps, compile(ps));
+}
+
+inline void Printf::write(std::ostream& os, Evaluate* eval, const PutStatement* ps, const Format& fmt) const {
+  if (fmt.op == 0) {
+    os << fmt.text;
     return;
   }
 
   assert(ps->is_non_null_expr());
   const auto& val = eval->get_value(ps->get_expr());
 
-  switch (fmt[1]) {
+  switch (fmt.op) {
     case '_':
       val.write(os, 0);
       return;
     case 'b':
-    case 'B': 
       val.write(os, 2);
       return;
     case 'c':
-    case 'C':
       os << val.to_char();
       return;
     case 'd':
-    case 'D':
       val.write(os, 10);
       return;
     case 'h':
-    case 'H': 
       val.write(os, 16);
       return;
     case 'o':
-    case 'O': 
       val.write(os, 8);
       return;
     case 's':
-    case 'S': 
       os << val.to_string();
       return;
     case 'u':
-    case 'U':
       val.write(os, 16);
       return;
     default: 
       break;
   } 
   char buffer[1024]; 
-  std::snprintf(buffer, 1024, fmt, val.to_double());
+  std::snprintf(buffer, 1024, fmt.text.c_str(), val.to_double());
   os << buffer;
 }
 
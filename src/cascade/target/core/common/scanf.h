@@ -33,6 +33,7 @@
 
 #include <cctype>
 #include <iostream>
+#include <string>
 #include "common/bits.h"
 #include "verilog/analyze/evaluate.h"
 #include "verilog/ast/ast.h"
@@ -41,23 +42,48 @@ namespace cascade {
 
 class Scanf {
   public:
+    // A format string which has been parsed ahead of time. Op is zero for
+    // literal text, which is matched against the input, and the lower-case
+    // conversion character otherwise.
+    struct Format {
+      char op;
+      std::string text;
+    };
+    static Format compile(const GetStatement* gs);
+
     void read(std::istream& is, Evaluate* eval, const GetStatement* gs);
+    void read(std::istream& is, Evaluate* eval, const GetStatement* gs, const Format& fmt);
     bool read_without_update(std::istream& is, Evaluate* eval, const GetStatement* gs);
+    bool read_without_update(std::istream& is, Evaluate* eval, const GetStatement* gs, const Format& fmt);
     const Bits& get() const;
   private:
     Bits val_;
 };
 
+inline Scanf::Format Scanf::compile(const GetStatement* gs) {
+  Format res;
+  res.text = gs->get_fmt()->get_readable_val();
+  res.op = (res.text[0] == '%') ? std::tolower(res.text[1]) : 0;
+  return res;
+}
+
 inline void Scanf::read(std::istream& is, Evaluate* eval, const GetStatement* gs) {
-  if (read_without_update(is, eval, gs)) {
+  read(is, eval, gs, compile(gs));
+}
+
+inline void Scanf::read(std::istream& is, Evaluate* eval, const GetStatement* gs, const Format& fmt) {
+  if (read_without_update(is, eval, gs, fmt)) {
     eval->assign_value(gs->get_var(), val_);
   }
 }
 
 inline bool Scanf::read_without_update(std::istream& is, Evaluate* eval, const GetStatement* gs) {
-  const auto format = gs->get_fmt()->get_readable_val();
-  if (format[0] != '%') {
-    for (auto c : format) {
+  return read_without_update(is, eval, gs, compile(gs));
+}
+
+inline bool Scanf::read_without_update(std::istream& is, Evaluate* eval, const GetStatement* gs, const Format& fmt) {
+  if (fmt.op == 0) {
+    for (auto c : fmt.text) {
       if (isspace(c)) {
         while (isspace(is.peek())) {
           is.get();
@@ -70,7 +96,7 @@ inline bool Scanf::read_without_update(std::istream& is, Evaluate* eval, const G
   }
 
   assert(gs->is_non_null_var());
-  switch (format[1]) {
+  switch (fmt.op) {
     case '_': 
       if (eval->get_type(gs->get_var()) == Bits::Type::REAL) {
         val_.read(is, 1);
@@ -79,42 +105,32 @@ inline bool Scanf::read_without_update(std::istream& is, Evaluate* eval, const G
       }
       break;
     case 'b':
-    case 'B':
       val_.read(is, 2);
       break;
     case 'c':
-    case 'C': 
       val_.read(is.get());
       break;
     case 'd':
-    case 'D': 
       val_.read(is, 10);
       break;
     case 'e':
-    case 'E':
     case 'f':
-    case 'F':
     case 'g':
-    case 'G': 
       val_.read(is, 1);
       break;
     case 'h':
-    case 'H': 
       val_.read(is, 16);
       break;
     case 'o':
-    case 'O': 
       val_.read(is, 8);
       break;
-    case 's':
-    case 'S': {
+    case 's': {
       std::string s;
       is >> s;
       val_ = Bits(s);
       break;
     }
     case 'u':
-    case 'U': 
       val_.read(is, 16);
       break;
     default: 
@@ -0,0 +1,76 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_NATIVE_ABI_H
+#define CASCADE_SRC_TARGET_CORE_NATIVE_ABI_H
+
+#include <cstdint>
+
+// This file defines the interface between a native logic core and the shared
+// object that it loads. The definition is written once as a macro so that it
+// can be expanded in the host and stringized into generated code.
+//
+// State is stored in a flat array of 64-bit words, one per variable or array
+// element. Non-blocking assignments are appended to the updates array as
+// masked writes to a single word. When that array fills up, generated code
+// invokes grow() and the host provides more space. System tasks trap back into
+// the host through task(); the host sets tasks to a non-zero value if a task
+// requires the attention of the runtime.
+
+#define CASCADE_NATIVE_ABI \
+  struct Update { \
+    uint32_t word; \
+    uint32_t shift; \
+    uint64_t mask; \
+    uint64_t val; \
+  }; \
+  struct Context { \
+    uint64_t* vars; \
+    Update* updates; \
+    uint32_t n_updates; \
+    uint32_t cap_updates; \
+    uint32_t changed; \
+    uint32_t silent; \
+    uint32_t tasks; \
+    void* host; \
+    void (*grow)(Context* c); \
+    void (*task)(Context* c, uint32_t id); \
+  };
+
+#define CASCADE_NATIVE_STR_(x) #x
+#define CASCADE_NATIVE_STR(x) CASCADE_NATIVE_STR_(x)
+
+namespace cascade::native {
+
+CASCADE_NATIVE_ABI
+
+} // namespace cascade::native
+
+#endif
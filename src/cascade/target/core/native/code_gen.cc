@@ -0,0 +1,801 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/native/code_gen.h"
+
+#include "target/core/native/abi.h"
+#include "verilog/analyze/read_set.h"
+#include "verilog/analyze/resolve.h"
+
+using namespace std;
+
+namespace cascade::native {
+
+CodeGen::CodeGen() {
+  words_ = 0;
+  temps_ = 0;
+}
+
+bool CodeGen::run(const ModuleDeclaration* md) {
+  // Assign storage to every variable in this module
+  for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+    if ((*i)->is(Node::Tag::port_declaration)) {
+      if (!declare(static_cast<const PortDeclaration*>(*i)->get_decl())) {
+        return false;
+      }
+    } else if ((*i)->is_subclass_of(Node::Tag::declaration)) {
+      if (!declare(static_cast<const Declaration*>(*i))) {
+        return false;
+      }
+    } 
+  }
+  // Translate continuous assigns, followed by always blocks
+  for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+    if ((*i)->is(Node::Tag::continuous_assign)) {
+      const auto* ca = static_cast<const ContinuousAssign*>(*i);
+      if (!write(body_, ca->get_lhs(), ca->get_rhs(), false)) {
+        return false;
+      }
+    } 
+  }
+  for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+    if ((*i)->is(Node::Tag::always_construct)) {
+      if (!always(static_cast<const AlwaysConstruct*>(*i))) {
+        return false;
+      }
+    } else if ((*i)->is(Node::Tag::initial_construct)) {
+      return fail("initial constructs are not supported");
+    }
+  }
+
+  stringstream ss;
+  ss << "#include <cstdint>" << endl;
+  ss << CASCADE_NATIVE_STR(CASCADE_NATIVE_ABI) << endl;
+  ss << R"(
+namespace {
+
+inline uint64_t mk(uint64_t w) { 
+  return (w >= 64) ? ~UINT64_C(0) : ((UINT64_C(1) << w) - 1); 
+}
+inline uint64_t sx(uint64_t x, uint64_t w) { 
+  return ((w < 64) && ((x >> (w-1)) & 1)) ? (x | ~mk(w)) : x; 
+}
+inline uint64_t cv(uint64_t x, uint64_t fw, bool s, uint64_t tw) { 
+  return (s ? sx(x, fw) : x) & mk(tw); 
+}
+inline uint64_t shl(uint64_t x, uint64_t n) { 
+  return (n >= 64) ? 0 : (x << n); 
+}
+inline uint64_t shr(uint64_t x, uint64_t n) { 
+  return (n >= 64) ? 0 : (x >> n); 
+}
+inline uint64_t sar(uint64_t x, uint64_t n, uint64_t w) {
+  const auto y = static_cast<int64_t>(sx(x, w));
+  return static_cast<uint64_t>((n >= w) ? (y >> 63) : (y >> n)) & mk(w);
+}
+inline uint64_t udiv(uint64_t a, uint64_t b) { 
+  return (b == 0) ? 0 : (a / b); 
+}
+inline uint64_t umod(uint64_t a, uint64_t b) { 
+  return (b == 0) ? 0 : (a % b); 
+}
+inline uint64_t sdiv(uint64_t a, uint64_t b) { 
+  const auto x = static_cast<int64_t>(a);
+  const auto y = static_cast<int64_t>(b);
+  return (y == 0) ? 0 : (y == -1) ? (~a + 1) : static_cast<uint64_t>(x / y);
+}
+inline uint64_t smod(uint64_t a, uint64_t b) { 
+  const auto x = static_cast<int64_t>(a);
+  const auto y = static_cast<int64_t>(b);
+  return ((y == 0) || (y == -1)) ? 0 : static_cast<uint64_t>(x % y);
+}
+inline uint64_t pw(uint64_t a, uint64_t b) { 
+  uint64_t res = 1;
+  for (; b != 0; b >>= 1) {
+    if (b & 1) {
+      res *= a;
+    }
+    a *= a;
+  }
+  return res;
+}
+inline uint64_t spw(uint64_t a, int64_t b, bool neg_one) { 
+  if (b >= 0) {
+    return pw(a, static_cast<uint64_t>(b));
+  }
+  return (a == 1) ? 1 : !neg_one ? 0 : (b & 1) ? ~static_cast<uint64_t>(0) : 1;
+}
+inline uint64_t rd(const uint64_t* v, uint64_t base, uint64_t n, uint64_t i) { 
+  return (i < n) ? v[base+i] : 0; 
+}
+inline uint64_t sel(uint64_t x, uint64_t msb, uint64_t lsb, uint64_t w) {
+  const auto m = (msb < w) ? msb : (w-1);
+  const auto l = (lsb < w) ? lsb : (w-1);
+  return (x >> l) & mk(m-l+1);
+}
+inline uint64_t rep(uint64_t x, uint64_t xw, uint64_t n, uint64_t w) {
+  auto res = x & mk(w);
+  for (uint64_t i = 1; i < n; ++i) {
+    res = (shl(res, xw) | x) & mk(w);
+  }
+  return res;
+}
+inline void wr(Context* c, uint64_t word, uint64_t shift, uint64_t mask, uint64_t val) {
+  auto& x = c->vars[word];
+  const auto y = (x & ~(mask << shift)) | ((val & mask) << shift);
+  if (x != y) {
+    x = y;
+    c->changed = 1;
+  }
+}
+inline void enq(Context* c, uint64_t word, uint64_t shift, uint64_t mask, uint64_t val) {
+  if (c->silent) {
+    return;
+  }
+  if (c->n_updates == c->cap_updates) {
+    c->grow(c);
+  }
+  c->updates[c->n_updates++] = {static_cast<uint32_t>(word), static_cast<uint32_t>(shift), mask, val};
+}
+inline void wrs(Context* c, bool nba, uint64_t word, uint64_t msb, uint64_t lsb, uint64_t w, uint64_t val, uint64_t vw, bool vs) {
+  if (lsb >= w) {
+    return;
+  }
+  const auto m = (msb < w) ? msb : (w-1);
+  const auto sw = m-lsb+1;
+  if (nba) {
+    enq(c, word, lsb, mk(sw), cv(val, vw, vs, sw));
+  } else {
+    wr(c, word, lsb, mk(sw), cv(val, vw, vs, sw));
+  }
+}
+
+void settle(Context* c) {
+  auto* v = c->vars;
+  do {
+    c->changed = 0;
+)";
+  ss << body_.str();
+  ss << R"(  } while (c->changed);
+}
+
+} // namespace
+
+extern "C" void native_init(Context* c) {
+  auto* v = c->vars;
+  (void) v;
+)";
+  ss << init_.str();
+  ss << R"(}
+
+extern "C" void native_evaluate(Context* c) {
+  settle(c);
+}
+
+extern "C" void native_update(Context* c) {
+  for (uint32_t i = 0; i < c->n_updates; ++i) {
+    const auto& u = c->updates[i];
+    wr(c, u.word, u.shift, u.mask, u.val);
+  }
+  c->n_updates = 0;
+  settle(c);
+}
+
+extern "C" uint32_t native_open_loop(Context* c, uint32_t clk, uint32_t val, uint32_t itr) {
+  uint32_t res = 0;
+  c->tasks = 0;
+  c->vars[clk] = val;
+  for (; (res < itr) && (c->tasks == 0); ++res) {
+    c->vars[clk] ^= 1;
+    settle(c);
+    while (c->n_updates > 0) {
+      native_update(c);
+    }
+  }
+  return res;
+}
+)";
+  text_ = ss.str();
+  return true;
+}
+
+const string& CodeGen::text() const {
+  return text_;
+}
+
+const string& CodeGen::error() const {
+  return error_;
+}
+
+size_t CodeGen::words() const {
+  return words_;
+}
+
+const CodeGen::Var* CodeGen::get_var(const Identifier* id) const {
+  const auto itr = vars_.find(id);
+  return (itr == vars_.end()) ? nullptr : &itr->second;
+}
+
+const unordered_map<const Identifier*, CodeGen::Var>& CodeGen::vars() const {
+  return vars_;
+}
+
+const vector<const Statement*>& CodeGen::tasks() const {
+  return tasks_;
+}
+
+bool CodeGen::declare(const Declaration* d) {
+  if (d->is(Node::Tag::reg_declaration)) {
+    const auto* rd = static_cast<const RegDeclaration*>(d);
+    if (rd->is_non_null_val() && rd->get_val()->is(Node::Tag::fopen_expression)) {
+      return fail("$fopen is not supported");
+    }
+  }
+  const auto* id = d->get_id();
+  if (eval_.get_type(id) == Bits::Type::REAL) {
+    return fail("real-valued variables are not supported");
+  }
+  const auto w = eval_.get_width(id);
+  if (w > 64) {
+    return fail("variables wider than 64 bits are not supported");
+  }
+  Var var;
+  var.base = words_;
+  var.elements = eval_.get_array_value(id).size();
+  var.width = w;
+  var.is_signed = eval_.get_type(id) == Bits::Type::SIGNED;
+  vars_[id] = var;
+  words_ += var.elements;
+  return true;
+}
+
+bool CodeGen::always(const AlwaysConstruct* ac) {
+  if (!ac->get_stmt()->is(Node::Tag::timing_control_statement)) {
+    return fail("always constructs without timing control are not supported");
+  }
+  const auto* tcs = static_cast<const TimingControlStatement*>(ac->get_stmt());
+  if (!tcs->get_ctrl()->is(Node::Tag::event_control)) {
+    return fail("always constructs without event control are not supported");
+  }
+  const auto* ec = static_cast<const EventControl*>(tcs->get_ctrl());
+
+  // Events are triggered by a change in value since the last time that we
+  // looked. Each event gets a word of its own to remember that value in.
+  const auto t = temp();
+  body_ << "    bool " << t << " = false;" << endl;
+  for (auto i = ec->begin_events(), ie = ec->end_events(); i != ie; ++i) {
+    if (!(*i)->get_expr()->is(Node::Tag::identifier)) {
+      return fail("events on complex expressions are not supported");
+    }
+    const auto* r = Resolve().get_resolution(static_cast<const Identifier*>((*i)->get_expr()));
+    const auto* var = get_var(r);
+    if (var == nullptr) {
+      return fail("events on undeclared variables are not supported");
+    }
+    const auto last = words_++;
+    init_ << "  v[" << last << "] = v[" << var->base << "];" << endl;
+    body_ << "    if (v[" << var->base << "] != v[" << last << "]) {" << endl;
+    body_ << "      v[" << last << "] = v[" << var->base << "];" << endl;
+    switch ((*i)->get_type()) {
+      case Event::Type::EDGE:
+        body_ << "      " << t << " = true;" << endl;
+        break;
+      case Event::Type::POSEDGE:
+        body_ << "      " << t << " = " << t << " || (v[" << var->base << "] != 0);" << endl;
+        break;
+      case Event::Type::NEGEDGE:
+        body_ << "      " << t << " = " << t << " || (v[" << var->base << "] == 0);" << endl;
+        break;
+      default:
+        assert(false);
+        break;
+    }
+    body_ << "    }" << endl;
+  }
+  body_ << "    if (" << t << ") {" << endl;
+  if (!stmt(body_, tcs->get_stmt())) {
+    return false;
+  }
+  body_ << "    }" << endl;
+  return true;
+}
+
+bool CodeGen::stmt(ostream& os, const Statement* s) {
+  switch (s->get_tag()) {
+    case Node::Tag::seq_block: {
+      const auto* sb = static_cast<const SeqBlock*>(s);
+      for (auto i = sb->begin_stmts(), ie = sb->end_stmts(); i != ie; ++i) {
+        if (!stmt(os, *i)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case Node::Tag::conditional_statement: {
+      const auto* cs = static_cast<const ConditionalStatement*>(s);
+      const auto c = expr(cs->get_if());
+      if (c.empty()) {
+        return false;
+      }
+      os << "if (" << c << ") {" << endl;
+      if (!stmt(os, cs->get_then())) {
+        return false;
+      }
+      os << "} else {" << endl;
+      if (!stmt(os, cs->get_else())) {
+        return false;
+      }
+      os << "}" << endl;
+      return true;
+    }
+    case Node::Tag::case_statement: {
+      // Case items are tested in order, and the first default item which we
+      // encounter terminates the search. This mirrors SwLogic.
+      const auto* cs = static_cast<const CaseStatement*>(s);
+      const auto c = expr(cs->get_cond());
+      if (c.empty()) {
+        return false;
+      }
+      const auto t = temp();
+      os << "{" << endl;
+      os << "const uint64_t " << t << " = " << c << ";" << endl;
+      auto first = true;
+      for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) {
+        if ((*i)->empty_exprs()) {
+          os << (first ? "{" : "else {") << endl;
+          if (!stmt(os, (*i)->get_stmt())) {
+            return false;
+          }
+          os << "}" << endl;
+          break;
+        }
+        os << (first ? "if (" : "else if (");
+        for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) {
+          const auto e = expr(*j);
+          if (e.empty()) {
+            return false;
+          }
+          os << ((j == (*i)->begin_exprs()) ? "" : " || ") << "(" << t << " == " << e << ")";
+        }
+        os << ") {" << endl;
+        if (!stmt(os, (*i)->get_stmt())) {
+          return false;
+        }
+        os << "}" << endl;
+        first = false;
+      }
+      os << "}" << endl;
+      return true;
+    }
+    case Node::Tag::blocking_assign: {
+      const auto* ba = static_cast<const BlockingAssign*>(s);
+      if (!ba->is_null_ctrl()) {
+        return fail("timing control is not supported");
+      }
+      return write(os, ba->get_lhs(), ba->get_rhs(), false);
+    }
+    case Node::Tag::nonblocking_assign: {
+      const auto* na = static_cast<const NonblockingAssign*>(s);
+      if (!na->is_null_ctrl()) {
+        return fail("timing control is not supported");
+      }
+      return write(os, na->get_lhs(), na->get_rhs(), true);
+    }
+    case Node::Tag::finish_statement:
+    case Node::Tag::put_statement:
+    case Node::Tag::restart_statement:
+    case Node::Tag::retarget_statement:
+    case Node::Tag::save_statement:
+      return task(os, s);
+    default:
+      return fail("unsupported statement");
+  }
+}
+
+bool CodeGen::write(ostream& os, const Identifier* lhs, const Expression* rhs, bool nba) {
+  const auto* r = Resolve().get_resolution(lhs);
+  const auto* var = (r == nullptr) ? nullptr : get_var(r);
+  if (var == nullptr) {
+    return fail("assignments to undeclared variables are not supported");
+  }
+  const auto val = expr(rhs);
+  if (val.empty()) {
+    return false;
+  }
+  const auto vw = eval_.get_width(rhs);
+  const auto vs = eval_.get_type(rhs) == Bits::Type::SIGNED;
+
+  // Compute the target word. Writes to out of bounds array elements are ignored.
+  stringstream word;
+  os << "{" << endl;
+  if (!r->empty_dim()) {
+    const auto idx = index(r, lhs);
+    if (idx.empty()) {
+      return false;
+    }
+    const auto t = temp();
+    os << "const uint64_t " << t << " = " << idx << ";" << endl;
+    os << "if (" << t << " < " << var->elements << ")" << endl;
+    word << "(" << var->base << "+" << t << ")";
+  } else {
+    word << var->base;
+  }
+
+  // Full assignments mask the value to the width of the target, bit and part
+  // selects are clamped to the range of the variable.
+  if (lhs->size_dim() == r->size_dim()) {
+    os << (nba ? "enq(c, " : "wr(c, ") << word.str() << ", 0, mk(" << var->width << "), cv(" << val << ", " << vw << ", " << vs << ", " << var->width << "));" << endl;
+  } else {
+    auto itr = lhs->begin_dim();
+    for (size_t i = 0, ie = r->size_dim(); i < ie; ++i) {
+      ++itr;
+    }
+    const auto rng = range(*itr);
+    if (rng.first.empty() || rng.second.empty()) {
+      return false;
+    }
+    os << "wrs(c, " << nba << ", " << word.str() << ", " << rng.first << ", " << rng.second << ", " << var->width << ", " << val << ", " << vw << ", " << vs << ");" << endl;
+  }
+  os << "}" << endl;
+  return true;
+}
+
+bool CodeGen::task(ostream& os, const Statement* s) {
+  // Tasks may only read variables which the host can reconstruct.
+  for (auto* e : ReadSet(s)) {
+    if (e->is(Node::Tag::feof_expression)) {
+      return fail("$feof is not supported");
+    }
+  }
+  os << "if (!c->silent) {" << endl;
+  os << "c->task(c, " << tasks_.size() << ");" << endl;
+  os << "}" << endl;
+  tasks_.push_back(s);
+  return true;
+}
+
+string CodeGen::expr(const Expression* e) {
+  if (!check(e)) {
+    return "";
+  }
+  const auto w = eval_.get_width(e);
+  stringstream ss;
+
+  switch (e->get_tag()) {
+    case Node::Tag::binary_expression: {
+      const auto* be = static_cast<const BinaryExpression*>(e);
+      const auto l = expr(be->get_lhs());
+      const auto r = expr(be->get_rhs());
+      if (l.empty() || r.empty()) {
+        return "";
+      }
+      const auto lw = eval_.get_width(be->get_lhs());
+      const auto rw = eval_.get_width(be->get_rhs());
+      const auto s = 
+        (eval_.get_type(be->get_lhs()) == Bits::Type::SIGNED) && 
+        (eval_.get_type(be->get_rhs()) == Bits::Type::SIGNED);
+      const auto sl = "static_cast<int64_t>(sx(" + l + ", " + to_string(lw) + "))";
+      const auto sr = "static_cast<int64_t>(sx(" + r + ", " + to_string(rw) + "))";
+
+      switch (be->get_op()) {
+        case BinaryExpression::Op::PLUS:
+          ss << "((" << l << " + " << r << ") & mk(" << w << "))";
+          break;
+        case BinaryExpression::Op::MINUS:
+          ss << "((" << l << " - " << r << ") & mk(" << w << "))";
+          break;
+        case BinaryExpression::Op::TIMES:
+          ss << "((" << l << " * " << r << ") & mk(" << w << "))";
+          break;
+        case BinaryExpression::Op::DIV:
+          if (s) {
+            ss << "(sdiv(" << sl << ", " << sr << ") & mk(" << w << "))";
+          } else {
+            ss << "udiv(" << l << ", " << r << ")";
+          }
+          break;
+        case BinaryExpression::Op::MOD:
+          if (s) {
+            ss << "(smod(" << sl << ", " << sr << ") & mk(" << w << "))";
+          } else {
+            ss << "umod(" << l << ", " << r << ")";
+          }
+          break;
+        // NOTE: These are equivalent because we don't support x and z
+        case BinaryExpression::Op::EEEQ:
+        case BinaryExpression::Op::EEQ:
+          ss << "static_cast<uint64_t>(" << l << " == " << r << ")";
+          break;
+        // NOTE: These are equivalent because we don't support x and z
+        case BinaryExpression::Op::BEEQ:
+        case BinaryExpression::Op::BEQ:
+          ss << "static_cast<uint64_t>(" << l << " != " << r << ")";
+          break;
+        case BinaryExpression::Op::AAMP:
+          ss << "static_cast<uint64_t>((" << l << " != 0) && (" << r << " != 0))";
+          break;
+        case BinaryExpression::Op::PPIPE:
+          ss << "static_cast<uint64_t>((" << l << " != 0) || (" << r << " != 0))";
+          break;
+        // Negative exponents follow the same rules as Bits: 1 and -1 are
+        // the only bases with non-zero results.
+        case BinaryExpression::Op::TTIMES:
+          if (eval_.get_type(be->get_rhs()) == Bits::Type::SIGNED) {
+            const auto neg_one = (eval_.get_type(be->get_lhs()) == Bits::Type::SIGNED) ? ("(" + sl + " == -1)") : string("false");
+            ss << "(spw(" << l << ", " << sr << ", " << neg_one << ") & mk(" << w << "))";
+          } else {
+            ss << "(pw(" << l << ", " << r << ") & mk(" << w << "))";
+          }
+          break;
+        case BinaryExpression::Op::LT:
+          ss << "static_cast<uint64_t>(" << (s ? sl : l) << " < " << (s ? sr : r) << ")";
+          break;
+        case BinaryExpression::Op::LEQ:
+          ss << "static_cast<uint64_t>(" << (s ? sl : l) << " <= " << (s ? sr : r) << ")";
+          break;
+        case BinaryExpression::Op::GT:
+          ss << "static_cast<uint64_t>(" << (s ? sl : l) << " > " << (s ? sr : r) << ")";
+          break;
+        case BinaryExpression::Op::GEQ:
+          ss << "static_cast<uint64_t>(" << (s ? sl : l) << " >= " << (s ? sr : r) << ")";
+          break;
+        case BinaryExpression::Op::AMP:
+          ss << "(" << l << " & " << r << ")";
+          break;
+        case BinaryExpression::Op::PIPE:
+          ss << "(" << l << " | " << r << ")";
+          break;
+        case BinaryExpression::Op::CARAT:
+          ss << "(" << l << " ^ " << r << ")";
+          break;
+        case BinaryExpression::Op::TCARAT:
+          ss << "(~(" << l << " ^ " << r << ") & mk(" << w << "))";
+          break;
+        case BinaryExpression::Op::LLT:
+        case BinaryExpression::Op::LLLT:
+          ss << "(shl(" << l << ", " << r << ") & mk(" << w << "))";
+          break;
+        case BinaryExpression::Op::GGT:
+          ss << "shr(" << l << ", " << r << ")";
+          break;
+        case BinaryExpression::Op::GGGT:
+          ss << "sar(" << l << ", " << r << ", " << lw << ")";
+          break;
+        default:
+          fail("unsupported binary operator");
+          return "";
+      }
+      return ss.str();
+    }
+    case Node::Tag::conditional_expression: {
+      const auto* ce = static_cast<const ConditionalExpression*>(e);
+      const auto c = expr(ce->get_cond());
+      const auto l = conv(ce->get_lhs(), w);
+      const auto r = conv(ce->get_rhs(), w);
+      if (c.empty() || l.empty() || r.empty()) {
+        return "";
+      }
+      ss << "((" << c << " != 0) ? " << l << " : " << r << ")";
+      return ss.str();
+    }
+    case Node::Tag::concatenation: {
+      const auto* c = static_cast<const Concatenation*>(e);
+      auto i = c->begin_exprs();
+      auto res = conv(*i++, w);
+      for (auto ie = c->end_exprs(); i != ie; ++i) {
+        const auto x = expr(*i);
+        if (res.empty() || x.empty()) {
+          return "";
+        }
+        res = "((shl(" + res + ", " + to_string(eval_.get_width(*i)) + ") | " + x + ") & mk(" + to_string(w) + "))";
+      }
+      return res;
+    }
+    case Node::Tag::identifier: {
+      const auto* id = static_cast<const Identifier*>(e);
+      const auto* r = Resolve().get_resolution(id);
+      const auto* var = (r == nullptr) ? nullptr : get_var(r);
+      if (var == nullptr) {
+        fail("references to undeclared variables are not supported");
+        return "";
+      }
+      // Reads from out of bounds array elements return zero
+      if (!r->empty_dim()) {
+        const auto idx = index(r, id);
+        if (idx.empty()) {
+          return "";
+        }
+        ss << "rd(v, " << var->base << ", " << var->elements << ", " << idx << ")";
+      } else {
+        ss << "v[" << var->base << "]";
+      }
+      // Bit and part selects are clamped and zero extended, full reads are
+      // extended according to the sign of the variable.
+      if (id->size_dim() == r->size_dim()) {
+        return "cv(" + ss.str() + ", " + to_string(var->width) + ", " + to_string(var->is_signed) + ", " + to_string(w) + ")";
+      } 
+      auto itr = id->begin_dim();
+      for (size_t i = 0, ie = r->size_dim(); i < ie; ++i) {
+        ++itr;
+      }
+      const auto rng = range(*itr);
+      if (rng.first.empty() || rng.second.empty()) {
+        return "";
+      }
+      return "(sel(" + ss.str() + ", " + rng.first + ", " + rng.second + ", " + to_string(var->width) + ") & mk(" + to_string(w) + "))";
+    }
+    case Node::Tag::multiple_concatenation: {
+      const auto* mc = static_cast<const MultipleConcatenation*>(e);
+      if (!mc->get_expr()->is(Node::Tag::number)) {
+        fail("non-constant multiple concatenations are not supported");
+        return "";
+      }
+      const auto x = expr(mc->get_concat());
+      if (x.empty()) {
+        return "";
+      }
+      ss << "rep(" << x << ", " << eval_.get_width(mc->get_concat()) << ", " << eval_.get_value(mc->get_expr()).to_uint() << ", " << w << ")";
+      return ss.str();
+    }
+    case Node::Tag::number:
+      ss << "UINT64_C(" << eval_.get_value(e).to_uint() << ")";
+      return ss.str();
+    case Node::Tag::unary_expression: {
+      const auto* ue = static_cast<const UnaryExpression*>(e);
+      const auto l = expr(ue->get_lhs());
+      if (l.empty()) {
+        return "";
+      }
+      const auto lw = eval_.get_width(ue->get_lhs());
+      switch (ue->get_op()) {
+        case UnaryExpression::Op::PLUS:
+          ss << l;
+          break;
+        case UnaryExpression::Op::MINUS:
+          ss << "((~" << l << " + 1) & mk(" << w << "))";
+          break;
+        case UnaryExpression::Op::BANG:
+          ss << "static_cast<uint64_t>(" << l << " == 0)";
+          break;
+        case UnaryExpression::Op::TILDE:
+          ss << "(~" << l << " & mk(" << w << "))";
+          break;
+        case UnaryExpression::Op::AMP:
+          ss << "static_cast<uint64_t>(" << l << " == mk(" << lw << "))";
+          break;
+        case UnaryExpression::Op::TAMP:
+          ss << "static_cast<uint64_t>(" << l << " != mk(" << lw << "))";
+          break;
+        case UnaryExpression::Op::PIPE:
+          ss << "static_cast<uint64_t>(" << l << " != 0)";
+          break;
+        case UnaryExpression::Op::TPIPE:
+          ss << "static_cast<uint64_t>(" << l << " == 0)";
+          break;
+        case UnaryExpression::Op::CARAT:
+          ss << "static_cast<uint64_t>(__builtin_popcountll(" << l << ") & 1)";
+          break;
+        case UnaryExpression::Op::TCARAT:
+          ss << "static_cast<uint64_t>(~__builtin_popcountll(" << l << ") & 1)";
+          break;
+        default:
+          fail("unsupported unary operator");
+          return "";
+      }
+      return ss.str();
+    }
+    default:
+      fail("unsupported expression");
+      return "";
+  }
+}
+
+string CodeGen::conv(const Expression* e, size_t w) {
+  const auto x = expr(e);
+  if (x.empty()) {
+    return "";
+  }
+  const auto ew = eval_.get_width(e);
+  const auto es = eval_.get_type(e) == Bits::Type::SIGNED;
+  if ((ew == w) || (!es && (ew < w))) {
+    return x;
+  }
+  return "cv(" + x + ", " + to_string(ew) + ", " + to_string(es) + ", " + to_string(w) + ")";
+}
+
+string CodeGen::index(const Identifier* r, const Identifier* id) {
+  // This mirrors Evaluate::dereference() 
+  auto mul = eval_.get_array_value(r).size();
+  stringstream ss;
+  ss << "(UINT64_C(0)";
+  auto iitr = id->begin_dim();
+  for (auto ritr = r->begin_dim(), re = r->end_dim(); ritr != re; ++ritr, ++iitr) {
+    if (iitr == id->end_dim()) {
+      fail("array slices are not supported");
+      return "";
+    }
+    const auto rng = eval_.get_range(*ritr);
+    mul /= ((rng.first-rng.second)+1);
+    const auto x = expr(*iitr);
+    if (x.empty()) {
+      return "";
+    }
+    ss << " + (UINT64_C(" << mul << ") * " << x << ")";
+  }
+  ss << ")";
+  return ss.str();
+}
+
+pair<string, string> CodeGen::range(const Expression* e) {
+  if (!e->is(Node::Tag::range_expression)) {
+    const auto x = expr(e);
+    return make_pair(x, x);
+  }
+  const auto* re = static_cast<const RangeExpression*>(e);
+  const auto u = expr(re->get_upper());
+  const auto l = expr(re->get_lower());
+  if (u.empty() || l.empty()) {
+    return make_pair("", "");
+  }
+  switch (re->get_type()) {
+    case RangeExpression::Type::CONSTANT:
+      return make_pair(u, l);
+    case RangeExpression::Type::PLUS:
+      return make_pair("(" + u + " + " + l + " - 1)", u);
+    case RangeExpression::Type::MINUS:
+      return make_pair(u, "(" + u + " - " + l + " + 1)");
+    default:
+      assert(false);
+      return make_pair("", "");
+  }
+}
+
+bool CodeGen::check(const Expression* e) {
+  if (eval_.get_type(e) == Bits::Type::REAL) {
+    return fail("real-valued expressions are not supported");
+  }
+  if (eval_.get_width(e) > 64) {
+    return fail("expressions wider than 64 bits are not supported");
+  }
+  return true;
+}
+
+bool CodeGen::fail(const string& s) {
+  if (error_.empty()) {
+    error_ = s;
+  }
+  return false;
+}
+
+string CodeGen::temp() {
+  return "t" + to_string(temps_++);
+}
+
+} // namespace cascade::native
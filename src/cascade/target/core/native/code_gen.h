@@ -0,0 +1,124 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_NATIVE_CODE_GEN_H
+#define CASCADE_SRC_TARGET_CORE_NATIVE_CODE_GEN_H
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "verilog/analyze/evaluate.h"
+#include "verilog/ast/ast.h"
+
+namespace cascade::native {
+
+// This class translates a flattened module declaration into a single C++
+// translation unit which implements the native ABI (see abi.h). Every variable
+// is assigned a contiguous range of words in a flat state array, one word per
+// array element. The generated code re-evaluates continuous assigns and
+// always blocks until a fixed point is reached, in the same spirit as the
+// event-driven semantics implemented by SwLogic. System tasks are assigned an
+// id and trap back into the host.
+//
+// Code generation is conservative. Variables which are wider than 64 bits or
+// real-valued, and constructs which the host can't service (ie $feof and
+// $fscanf) cause run() to return false along with an explanation.
+
+class CodeGen {
+  public:
+    struct Var {
+      size_t base;
+      size_t elements;
+      size_t width;
+      bool is_signed;
+    };
+
+    CodeGen();
+    ~CodeGen() = default;
+
+    // Translates md. Returns false if md contains unsupported constructs.
+    bool run(const ModuleDeclaration* md);
+
+    // Returns the generated code on success, or an error message on failure.
+    const std::string& text() const;
+    const std::string& error() const;
+
+    // Returns the number of words in the state array. 
+    size_t words() const;
+    // Returns the layout of a variable given its declaration. Returns nullptr
+    // for identifiers which weren't declared in this module.
+    const Var* get_var(const Identifier* id) const;
+    // Returns the layout of every variable in this module.
+    const std::unordered_map<const Identifier*, Var>& vars() const;
+    // Returns the system tasks in this module, indexed by id.
+    const std::vector<const Statement*>& tasks() const;
+
+  private:
+    Evaluate eval_;
+    std::unordered_map<const Identifier*, Var> vars_;
+    std::vector<const Statement*> tasks_;
+    size_t words_;
+    size_t temps_;
+
+    std::stringstream init_;
+    std::stringstream body_;
+    std::string text_;
+    std::string error_;
+
+    // Layout Helpers:
+    bool declare(const Declaration* d);
+    // Code Generation Helpers:
+    bool always(const AlwaysConstruct* ac);
+    bool stmt(std::ostream& os, const Statement* s);
+    bool write(std::ostream& os, const Identifier* lhs, const Expression* rhs, bool nba);
+    bool task(std::ostream& os, const Statement* s);
+
+    // Returns a C++ expression which evaluates to the value of e, masked to
+    // its bit-width. Returns the empty string on failure.
+    std::string expr(const Expression* e);
+    // Returns the value of e, sign or zero extended or truncated to w bits,
+    // using the same semantics as Bits::assign().
+    std::string conv(const Expression* e, size_t w);
+    // Returns a C++ expression for the element index selected by id, or the
+    // empty string if r is a scalar.
+    std::string index(const Identifier* r, const Identifier* id);
+    // Returns C++ expressions for the msb and lsb of a bit-select.
+    std::pair<std::string, std::string> range(const Expression* e);
+
+    bool check(const Expression* e);
+    bool fail(const std::string& s);
+    std::string temp();
+};
+
+} // namespace cascade::native
+
+#endif
@@ -0,0 +1,144 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/native/native_compiler.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <fstream>
+#include <unistd.h>
+#include "common/system.h"
+#include "target/compiler.h"
+#include "verilog/analyze/module_info.h"
+#include "verilog/ast/ast.h"
+
+using namespace std;
+
+namespace cascade::native {
+
+NativeCompiler::NativeCompiler() : CoreCompiler() { }
+
+void NativeCompiler::stop_compile(Engine::Id id) {
+  lock_guard<mutex> lg(lock_);
+  ++stops_[id];
+  const auto itr = pids_.find(id);
+  if (itr != pids_.end()) {
+    System::execute("pkill -9 -P " + to_string(itr->second));
+    kill(itr->second, SIGKILL);
+  }
+}
+
+NativeLogic* NativeCompiler::compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) {
+  unique_lock<mutex> lg(lock_);
+  const auto stops = stops_[id];
+  lg.unlock();
+
+  // Translate the module into C++
+  auto* gen = new CodeGen();
+  if (!gen->run(md)) {
+    get_compiler()->error("Unable to compile module to native code: " + gen->error());
+    delete gen;
+    delete md;
+    return nullptr;
+  }
+
+  // Write the result to a temporary file and compile it into a shared object
+  System::execute("mkdir -p /tmp/cascade/native/");
+  char path[] = "/tmp/cascade/native/logic_XXXXXX.cc";
+  const auto fd = mkstemps(path, 3);
+  close(fd);
+  const auto src = string(path);
+  const auto so = src.substr(0, src.length()-3) + ".so";
+
+  ofstream ofs(src);
+  ofs << gen->text() << endl;
+  ofs.close();
+
+  // Skip the build entirely if we've compiled this exact code before
+  auto& cache = get_compiler()->get_cache();
+  const auto key = "native\n" + System::cxx_compiler() + "\n" + gen->text();
+  auto res = cache.get(key, so) ? 0 : -1;
+  auto stopped = false;
+  if (res != 0) {
+    // Don't start a build if we've been asked to stop. Otherwise, register
+    // the build while still holding the lock, so that any later request to
+    // stop can find it.
+    lg.lock();
+    stopped = stops_[id] != stops;
+    if (!stopped) {
+      const auto pid = System::no_block_begin_execute(System::cxx_compiler() + " -std=c++17 -O2 -shared -fPIC " + src + " -o " + so, false);
+      pids_[id] = pid;
+      lg.unlock();
+      res = System::no_block_wait_finish(pid);
+      lg.lock();
+      pids_.erase(id);
+      stopped = stops_[id] != stops;
+    }
+    lg.unlock();
+
+    if ((res == 0) && !stopped) {
+      cache.put(key, so);
+    }
+  }
+
+  System::execute("rm -f " + src);
+  auto* handle = ((res == 0) && !stopped) ? dlopen(so.c_str(), RTLD_NOW | RTLD_LOCAL) : nullptr;
+  System::execute("rm -f " + so);
+  // A build which was stopped isn't an error. It's been superseded by a newer
+  // version of this module.
+  if (stopped) {
+    delete gen;
+    delete md;
+    return nullptr;
+  }
+  if (handle == nullptr) {
+    get_compiler()->error("Unable to compile module to native code: C++ compilation failed");
+    delete gen;
+    delete md;
+    return nullptr;
+  }
+
+  // Create a new core
+  ModuleInfo info(md);
+  auto* c = new NativeLogic(interface, md, gen, handle);
+  for (auto* i : info.inputs()) {
+    c->set_input(i, to_vid(i));
+  }
+  for (auto* s : info.stateful()) { 
+    c->set_state(s, to_vid(s));
+  }
+  for (auto* o : info.outputs()) {
+    c->set_output(o, to_vid(o));
+  }
+  return c;
+}
+
+} // namespace cascade::native
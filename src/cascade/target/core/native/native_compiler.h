@@ -0,0 +1,71 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_COMPILER_H
+#define CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_COMPILER_H
+
+#include <mutex>
+#include <sys/types.h>
+#include <unordered_map>
+#include "target/core/native/native_logic.h"
+#include "target/core_compiler.h"
+
+namespace cascade::native {
+
+// A core compiler which translates logic into C++, compiles the result with
+// the host C++ compiler into a shared object, and loads it into the running
+// process. This compiler only produces logic cores. Modules which use
+// language features that CodeGen doesn't support fail to compile, and are
+// left to run in whichever engine they were already running in.
+
+class NativeCompiler : public CoreCompiler {
+  public:
+    NativeCompiler();
+    ~NativeCompiler() override = default;
+
+    void stop_compile(Engine::Id id) override;
+
+  private:
+    // Compilation State:
+    //
+    // pids_ holds the build which is running for each id. stops_ counts the
+    // calls to stop_compile() for each id, so that a compilation can tell
+    // whether it was stopped, even if that happened before its build began.
+    std::mutex lock_;
+    std::unordered_map<Engine::Id, pid_t> pids_;
+    std::unordered_map<Engine::Id, size_t> stops_;
+
+    // Core Compiler Interface:
+    NativeLogic* compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) override;
+};
+
+} // namespace cascade::native
+
+#endif
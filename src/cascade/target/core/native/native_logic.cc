@@ -0,0 +1,319 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/native/native_logic.h"
+
+#include <algorithm>
+#include <cassert>
+#include <dlfcn.h>
+#include <limits>
+#include "target/core/common/interfacestream.h"
+#include "target/core/common/printf.h"
+#include "target/input.h"
+#include "target/state.h"
+#include "verilog/analyze/read_set.h"
+#include "verilog/analyze/resolve.h"
+#include "verilog/ast/ast.h"
+
+using namespace std;
+
+namespace cascade::native {
+
+NativeLogic::NativeLogic(Interface* interface, ModuleDeclaration* md, CodeGen* gen, void* handle) : Logic(interface) {
+  src_ = md;
+  gen_ = gen;
+
+  // Bind entry points
+  handle_ = handle;
+  init_ = (void (*)(Context*)) dlsym(handle_, "native_init");
+  evaluate_ = (void (*)(Context*)) dlsym(handle_, "native_evaluate");
+  update_ = (void (*)(Context*)) dlsym(handle_, "native_update");
+  open_loop_ = (uint32_t (*)(Context*, uint32_t, uint32_t, uint32_t)) dlsym(handle_, "native_open_loop");
+
+  // Provision state and load initial values
+  vars_.resize(gen_->words(), 0);
+  for (const auto& v : gen_->vars()) {
+    const auto& vals = eval_.get_array_value(v.first);
+    for (size_t i = 0, ie = vals.size(); i < ie; ++i) {
+      vars_[v.second.base+i] = to_word(vals[i]) & mask(v.second.width);
+    }
+  }
+  updates_.resize(16);
+
+  ctx_.vars = vars_.data();
+  ctx_.updates = updates_.data();
+  ctx_.n_updates = 0;
+  ctx_.cap_updates = updates_.size();
+  ctx_.changed = 0;
+  ctx_.silent = 0;
+  ctx_.tasks = 0;
+  ctx_.host = this;
+  ctx_.grow = &NativeLogic::grow;
+  ctx_.task = &NativeLogic::task;
+
+  // Record the variables that each system task depends on
+  for (const auto* s : gen_->tasks()) {
+    task_reads_.emplace_back();
+    for (const auto* e : ReadSet(s)) {
+      if (e->is(Node::Tag::identifier)) {
+        const auto* r = Resolve().get_resolution(static_cast<const Identifier*>(e));
+        if ((r != nullptr) && (gen_->get_var(r) != nullptr)) {
+          task_reads_.back().push_back(r);
+        }
+      }
+    }
+  }
+
+  // Establish event history and settle continuous assigns
+  there_were_tasks_ = false;
+  init_(&ctx_);
+  silent_evaluate();
+}
+
+NativeLogic::~NativeLogic() {
+  delete gen_;
+  delete src_;
+  for (auto& s : streams_) {
+    delete s.second;
+  }
+  dlclose(handle_);
+}
+
+NativeLogic& NativeLogic::set_input(const Identifier* id, VId vid) {
+  if (vid >= inputs_.size()) {
+    inputs_.resize(vid+1, nullptr);
+    input_vars_.resize(vid+1, nullptr);
+  }
+  inputs_[vid] = id;
+  input_vars_[vid] = gen_->get_var(id);
+  return *this;
+}
+
+NativeLogic& NativeLogic::set_state(const Identifier* id, VId vid) {
+  state_.insert(make_pair(vid, id));
+  return *this;
+}
+
+NativeLogic& NativeLogic::set_output(const Identifier* id, VId vid) {
+  outputs_.push_back(make_pair(gen_->get_var(id), vid));
+  output_vals_.push_back(eval_.get_value(id));
+  return *this;
+}
+
+State* NativeLogic::get_state() {
+  auto* s = new State();
+  for (const auto& sv : state_) {
+    const auto* var = gen_->get_var(sv.second);
+    auto vals = eval_.get_array_value(sv.second);
+    for (size_t i = 0, ie = vals.size(); i < ie; ++i) {
+      from_word(vals[i], vars_[var->base+i]);
+    }
+    s->insert(sv.first, vals);
+  }
+  return s;
+}
+
+void NativeLogic::set_state(const State* s) {
+  for (const auto& sv : state_) {
+    const auto itr = s->find(sv.first);
+    if (itr != s->end()) {
+      const auto* var = gen_->get_var(sv.second);
+      for (size_t i = 0, ie = min(var->elements, itr->second.size()); i < ie; ++i) {
+        vars_[var->base+i] = to_word(itr->second[i]) & mask(var->width);
+      }
+    }
+  }
+  silent_evaluate();
+}
+
+Input* NativeLogic::get_input() {
+  auto* i = new Input();
+  for (size_t v = 0, ve = inputs_.size(); v < ve; ++v) {
+    const auto* id = inputs_[v];
+    if (id == nullptr) {
+      continue;
+    }
+    auto val = eval_.get_value(id);
+    from_word(val, vars_[input_vars_[v]->base]);
+    i->insert(v, val);
+  }
+  return i;
+}
+
+void NativeLogic::set_input(const Input* i) {
+  for (size_t v = 0, ve = inputs_.size(); v < ve; ++v) {
+    const auto* var = input_vars_[v];
+    if (var == nullptr) {
+      continue;
+    }
+    const auto itr = i->find(v);
+    if (itr != i->end()) {
+      vars_[var->base] = to_word(itr->second) & mask(var->width);
+    }
+  }
+  silent_evaluate();
+}
+
+void NativeLogic::read(VId vid, const Bits* b) {
+  const auto* var = input_vars_[vid];
+  vars_[var->base] = to_word(*b) & mask(var->width);
+}
+
+void NativeLogic::evaluate() {
+  there_were_tasks_ = false;
+  ctx_.tasks = 0;
+  evaluate_(&ctx_);
+  write_outputs();
+}
+
+bool NativeLogic::there_are_updates() const {
+  return ctx_.n_updates > 0;
+}
+
+void NativeLogic::update() {
+  there_were_tasks_ = false;
+  ctx_.tasks = 0;
+  update_(&ctx_);
+  write_outputs();
+}
+
+bool NativeLogic::there_were_tasks() const {
+  return there_were_tasks_;
+}
+
+bool NativeLogic::supports_concurrency() const {
+  return true;
+}
+
+size_t NativeLogic::open_loop(VId clk, bool val, size_t itr) {
+  // Generated code runs the same loop as Core::open_loop() but without
+  // crossing back into the host on every iteration. 
+  there_were_tasks_ = false;
+  const auto n = min(itr, static_cast<size_t>(numeric_limits<uint32_t>::max()));
+  return open_loop_(&ctx_, input_vars_[clk]->base, val, n);
+}
+
+void NativeLogic::grow(Context* c) {
+  auto* nl = static_cast<NativeLogic*>(c->host);
+  nl->updates_.resize(2*nl->updates_.size());
+  c->updates = nl->updates_.data();
+  c->cap_updates = nl->updates_.size();
+}
+
+void NativeLogic::task(Context* c, uint32_t id) {
+  static_cast<NativeLogic*>(c->host)->handle_task(id);
+}
+
+void NativeLogic::handle_task(uint32_t id) {
+  // Bring eval_ up to date with the variables that this task reads 
+  for (const auto* r : task_reads_[id]) {
+    const auto* var = gen_->get_var(r);
+    for (size_t i = 0; i < var->elements; ++i) {
+      const auto w = vars_[var->base+i];
+      eval_.assign_word<uint32_t>(r, i, 0, w);
+      if (var->width > 32) {
+        eval_.assign_word<uint32_t>(r, i, 1, w >> 32);
+      }
+    }
+  }
+
+  const auto* s = gen_->tasks()[id];
+  switch (s->get_tag()) {
+    case Node::Tag::finish_statement: {
+      const auto* fs = static_cast<const FinishStatement*>(s);
+      interface()->finish(eval_.get_value(fs->get_arg()).to_uint());
+      break;
+    }
+    case Node::Tag::put_statement: {
+      const auto* ps = static_cast<const PutStatement*>(s);
+      const auto fd = eval_.get_value(ps->get_fd()).to_uint();
+      Printf().write(*get_stream(fd), &eval_, ps);
+      return;
+    }
+    case Node::Tag::restart_statement:
+      interface()->restart(static_cast<const RestartStatement*>(s)->get_arg()->get_readable_val());
+      break;
+    case Node::Tag::retarget_statement:
+      interface()->retarget(static_cast<const RetargetStatement*>(s)->get_arg()->get_readable_val());
+      break;
+    case Node::Tag::save_statement:
+      interface()->save(static_cast<const SaveStatement*>(s)->get_arg()->get_readable_val());
+      break;
+    default:
+      assert(false);
+      return;
+  }
+  there_were_tasks_ = true;
+  ctx_.tasks = 1;
+}
+
+void NativeLogic::silent_evaluate() {
+  ctx_.silent = 1;
+  evaluate_(&ctx_);
+  ctx_.silent = 0;
+}
+
+void NativeLogic::write_outputs() {
+  for (size_t i = 0, ie = outputs_.size(); i < ie; ++i) {
+    from_word(output_vals_[i], vars_[outputs_[i].first->base]);
+    interface()->write(outputs_[i].second, &output_vals_[i]);
+  }
+}
+
+interfacestream* NativeLogic::get_stream(FId fd) {
+  const auto itr = streams_.find(fd);
+  if (itr != streams_.end()) {
+    return itr->second;
+  }
+  auto* is = new interfacestream(interface(), fd);
+  streams_[fd] = is;
+  return is;
+}
+
+uint64_t NativeLogic::mask(size_t w) {
+  return (w >= 64) ? numeric_limits<uint64_t>::max() : ((static_cast<uint64_t>(1) << w) - 1);
+}
+
+uint64_t NativeLogic::to_word(const Bits& b) {
+  uint64_t res = b.read_word<uint32_t>(0);
+  if (b.size() > 32) {
+    res |= static_cast<uint64_t>(b.read_word<uint32_t>(1)) << 32;
+  }
+  return res;
+}
+
+void NativeLogic::from_word(Bits& b, uint64_t w) {
+  b.write_word<uint32_t>(0, w);
+  if (b.size() > 32) {
+    b.write_word<uint32_t>(1, w >> 32);
+  }
+}
+
+} // namespace cascade::native
@@ -0,0 +1,129 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_LOGIC_H
+#define CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_LOGIC_H
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/bits.h"
+#include "target/core.h"
+#include "target/core/native/abi.h"
+#include "target/core/native/code_gen.h"
+#include "verilog/analyze/evaluate.h"
+
+namespace cascade {
+
+class interfacestream;
+
+namespace native {
+
+// A logic core which executes a shared object produced by compiling the
+// output of CodeGen. Variable values live in a flat array of words which is
+// shared with generated code, and the core interface reads and writes that
+// array directly. An instance of Evaluate is kept around for the sole purpose
+// of servicing system tasks: when generated code traps into the host, the
+// variables that a task reads are copied into eval_ before it is executed.
+
+class NativeLogic : public Logic {
+  public:
+    NativeLogic(Interface* interface, ModuleDeclaration* md, CodeGen* gen, void* handle);
+    ~NativeLogic() override;
+
+    // Configuration Logic:
+    NativeLogic& set_input(const Identifier* id, VId vid);
+    NativeLogic& set_state(const Identifier* id, VId vid);
+    NativeLogic& set_output(const Identifier* id, VId vid);
+
+    // Core Interface:
+    State* get_state() override;
+    void set_state(const State* s) override;
+    Input* get_input() override;
+    void set_input(const Input* i) override;
+
+    void read(VId vid, const Bits* b) override;
+    void evaluate() override;
+    bool there_are_updates() const override;
+    void update() override;
+    bool there_were_tasks() const override;
+    bool supports_concurrency() const override;
+
+    size_t open_loop(VId clk, bool val, size_t itr) override;
+
+  private:
+    // Source Management:
+    ModuleDeclaration* src_;
+    CodeGen* gen_;
+    Evaluate eval_;
+
+    // Shared Object State:
+    void* handle_;
+    void (*init_)(Context* c);
+    void (*evaluate_)(Context* c);
+    void (*update_)(Context* c);
+    uint32_t (*open_loop_)(Context* c, uint32_t clk, uint32_t val, uint32_t itr);
+    Context ctx_;
+    std::vector<uint64_t> vars_;
+    std::vector<Update> updates_;
+
+    // Variable Indexing:
+    std::vector<const Identifier*> inputs_;
+    std::vector<const CodeGen::Var*> input_vars_;
+    std::vector<std::pair<const CodeGen::Var*, VId>> outputs_;
+    std::unordered_map<VId, const Identifier*> state_;
+    std::vector<Bits> output_vals_;
+
+    // Control State:
+    bool there_were_tasks_;
+    std::unordered_map<FId, interfacestream*> streams_;
+    std::vector<std::vector<const Identifier*>> task_reads_;
+
+    // Trampolines:
+    static void grow(Context* c);
+    static void task(Context* c, uint32_t id);
+
+    // Control Helpers:
+    void handle_task(uint32_t id);
+    void silent_evaluate();
+    void write_outputs();
+    interfacestream* get_stream(FId fd);
+
+    // Conversion Helpers:
+    static uint64_t mask(size_t w);
+    static uint64_t to_word(const Bits& b);
+    static void from_word(Bits& b, uint64_t w);
+};
+
+} // namespace native
+
+} // namespace cascade
+
+#endif
@@ -74,6 +74,13 @@ class ProxyCore : public T {
     uint32_t n_;
     sockstream* sock_;
 
+    // The flags returned by the most recent batch. These remain valid until
+    // the next call which can change the state of the remote core without
+    // returning a new set.
+    mutable uint8_t flags_;
+    mutable bool flags_valid_;
+
+    uint8_t batch(uint8_t op);
     void recv();
 }; 
 
@@ -83,6 +90,9 @@ inline ProxyCore<T>::ProxyCore(Interface* interface, uint32_t pid, uint32_t eid,
   eid_ = eid;
   n_ = n;
   sock_ = sock;
+
+  flags_ = 0;
+  flags_valid_ = false;
 }
 
 template <typename T>
@@ -104,6 +114,7 @@ inline State* ProxyCore<T>::get_state() {
 
 template <typename T>
 inline void ProxyCore<T>::set_state(const State* s) {
+  flags_valid_ = false;
   Rpc(Rpc::Type::SET_STATE, pid_, eid_, n_).serialize(*sock_);
   s->serialize(*sock_);
   sock_->flush();
@@ -121,6 +132,7 @@ inline Input* ProxyCore<T>::get_input() {
 
 template <typename T>
 inline void ProxyCore<T>::set_input(const Input* i) {
+  flags_valid_ = false;
   Rpc(Rpc::Type::SET_INPUT, pid_, eid_, n_).serialize(*sock_);
   i->serialize(*sock_);
   sock_->flush();
@@ -128,6 +140,7 @@ inline void ProxyCore<T>::set_input(const Input* i) {
 
 template <typename T>
 inline void ProxyCore<T>::finalize() {
+  flags_valid_ = false;
   Rpc(Rpc::Type::FINALIZE, pid_, eid_, n_).serialize(*sock_);
   sock_->flush();
   recv();
@@ -142,6 +155,7 @@ inline bool ProxyCore<T>::overrides_done_step() const {
 
 template <typename T>
 inline void ProxyCore<T>::done_step() {
+  flags_valid_ = false;
   Rpc(Rpc::Type::DONE_STEP, pid_, eid_, n_).serialize(*sock_);
   sock_->flush();
 }
@@ -155,6 +169,7 @@ inline bool ProxyCore<T>::overrides_done_simulation() const {
 
 template <typename T>
 inline void ProxyCore<T>::done_simulation() {
+  flags_valid_ = false;
   Rpc(Rpc::Type::DONE_SIMULATION, pid_, eid_, n_).serialize(*sock_);
   sock_->flush();
 }
@@ -171,14 +186,14 @@ inline void ProxyCore<T>::read(VId id, const Bits* b) {
 
 template <typename T>
 inline void ProxyCore<T>::evaluate() {
-  Rpc(Rpc::Type::EVALUATE, pid_, eid_, n_).serialize(*sock_);
-  // This call to flush dumps any reads which have been enqueued
-  sock_->flush();
-  recv();
+  batch(Rpc::BATCH_EVALUATE);
 }
 
 template <typename T>
 inline bool ProxyCore<T>::there_are_updates() const {
+  if (flags_valid_) {
+    return (flags_ & Rpc::FLAG_THERE_ARE_UPDATES) != 0;
+  }
   Rpc(Rpc::Type::THERE_ARE_UPDATES, pid_, eid_, n_).serialize(*sock_);
   sock_->flush();
   return (sock_->get() == 1);
@@ -186,14 +201,14 @@ inline bool ProxyCore<T>::there_are_updates() const {
 
 template <typename T>
 inline void ProxyCore<T>::update() {
-  Rpc(Rpc::Type::UPDATE, pid_, eid_, n_).serialize(*sock_);
-  // This call to flush dumps any reads which have been enqueued
-  sock_->flush();
-  recv();
+  batch(Rpc::BATCH_UPDATE);
 }
 
 template <typename T>
 inline bool ProxyCore<T>::there_were_tasks() const {
+  if (flags_valid_) {
+    return (flags_ & Rpc::FLAG_THERE_WERE_TASKS) != 0;
+  }
   Rpc(Rpc::Type::THERE_WERE_TASKS, pid_, eid_, n_).serialize(*sock_);
   sock_->flush();
   return (sock_->get() == 1);
@@ -201,15 +216,17 @@ inline bool ProxyCore<T>::there_were_tasks() const {
 
 template <typename T>
 inline bool ProxyCore<T>::conditional_update() {
-  Rpc(Rpc::Type::CONDITIONAL_UPDATE, pid_, eid_, n_).serialize(*sock_);
-  // This call to flush dumps any reads which have been enqueued
-  sock_->flush();
-  recv();
-  return (sock_->get() == 1);
+  // Reads don't create updates, so if the last batch reported that there
+  // weren't any, there's no reason to ask again.
+  if (flags_valid_ && ((flags_ & Rpc::FLAG_THERE_ARE_UPDATES) == 0)) {
+    return false;
+  }
+  return (batch(Rpc::BATCH_CONDITIONAL_UPDATE) & Rpc::FLAG_UPDATED) != 0;
 }
 
 template <typename T>
 inline size_t ProxyCore<T>::open_loop(VId clk, bool val, size_t itr) {
+  flags_valid_ = false;
   Rpc(Rpc::Type::OPEN_LOOP, pid_, eid_, n_).serialize(*sock_);
   sock_->write(reinterpret_cast<const char*>(&clk), 4);
   sock_->put(val ? 1 : 0);
@@ -222,6 +239,20 @@ inline size_t ProxyCore<T>::open_loop(VId clk, bool val, size_t itr) {
   return res;
 }
 
+template <typename T>
+inline uint8_t ProxyCore<T>::batch(uint8_t op) {
+  Rpc(Rpc::Type::BATCH, pid_, eid_, n_).serialize(*sock_);
+  sock_->put(op);
+  // This call to flush dumps any reads which have been enqueued. The
+  // response contains every write and task which the batch produced,
+  // followed by an OKAY and a set of flags describing the core's state.
+  sock_->flush();
+  recv();
+  flags_ = sock_->get();
+  flags_valid_ = true;
+  return flags_;
+}
+
 template <typename T>
 inline void ProxyCore<T>::recv() {
   Rpc rpc;
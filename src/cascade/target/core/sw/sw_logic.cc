@@ -33,10 +33,12 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include "target/core/common/interfacestream.h"
 #include "target/core/common/printf.h"
 #include "target/core/common/scanf.h"
 #include "target/core/sw/monitor.h"
+#include "verilog/analyze/read_set.h"
 #include "target/input.h"
 #include "target/state.h"
 #include "verilog/analyze/module_info.h"
@@ -49,20 +51,32 @@ using namespace std;
 namespace cascade::sw {
 
 SwLogic::SwLogic(Interface* interface, ModuleDeclaration* md) : Logic(interface), Visitor() { 
-  // Record pointer to source code and provision update pool
+  // Record pointer to source code
   src_ = md;
-  update_pool_.resize(1);
 
   // Initialize monitors and system tasks
   for (auto i = src_->begin_items(), ie = src_->end_items(); i != ie; ++i) {
     Monitor().init(*i);
   }
+  level_min_ = 0;
+  level_size_ = 0;
+  if (src_->get_attrs()->get<String>("__levelize") != nullptr) {
+    levelize();
+  }
   eval_.set_feof_handler([this](Evaluate* eval, const FeofExpression* fe) {
     const auto fd = eval_.get_value(fe->get_fd()).to_uint();
+    eof_fds_[fe->get_val<2,30>()] = fd;
     return get_stream(fd)->eof();
   });
   EofIndex ei(this);
   src_->accept(&ei);
+  IoIndex ii(this);
+  src_->accept(&ii);
+
+  // Index nonblocking assigns and provision one update slot for each
+  NbaIndex ni(this);
+  src_->accept(&ni);
+  overflow_ = 0;
 
   // Set silent mode, schedule always constructs and continuous assigns, and then
   // place the silent flag in its default, disabled state
@@ -197,12 +211,7 @@ void SwLogic::read(VId vid, const Bits* b) {
 void SwLogic::evaluate() {
   // This is a while loop. Active events can generate new active events.
   there_were_tasks_ = false;
-  while (!active_.empty()) {
-    auto* e = active_.back();
-    active_.pop_back();
-    const_cast<Node*>(e)->set_flag<1>(false);
-    schedule_now(e);
-  }
+  drain_active();
   for (auto& o : outputs_) {
     interface()->write(o.second, &eval_.get_value(o.first));
   }
@@ -214,22 +223,21 @@ bool SwLogic::there_are_updates() const {
 
 void SwLogic::update() {
   // This is a for loop. Updates happen simultaneously
-  for (size_t i = 0, ie = updates_.size(); i < ie; ++i) {
-    const auto& val = update_pool_[i];
-    if (eval_.assign_value(get<0>(updates_[i]), get<1>(updates_[i]), get<2>(updates_[i]), get<3>(updates_[i]), val)) {
-      notify(get<0>(updates_[i]));
+  for (const auto& u : updates_) {
+    if (u.r == nullptr) {
+      continue;
     }
+    if (eval_.assign_value(u.r, u.idx, u.msb, u.lsb, update_pool_[u.slot])) {
+      notify(u.r);
+    }
+    sites_[u.site].pos = numeric_limits<size_t>::max();
   }
   updates_.clear();
+  overflow_ = 0;
 
   // This is while loop. Active events can generate new active events.
   there_were_tasks_ = false;
-  while (!active_.empty()) {
-    auto* e = active_.back();
-    active_.pop_back();
-    const_cast<Node*>(e)->set_flag<1>(false);
-    schedule_now(e);
-  }
+  drain_active();
 
   for (auto& o : outputs_) {
     interface()->write(o.second, &eval_.get_value(o.first));
@@ -240,12 +248,67 @@ bool SwLogic::there_were_tasks() const {
   return there_were_tasks_;
 }
 
+bool SwLogic::supports_concurrency() const {
+  return true;
+}
+
 SwLogic::EofIndex::EofIndex(SwLogic* sw) : Visitor() {
   sw_ = sw;
 }
 
 void SwLogic::EofIndex::visit(const FeofExpression* fe) {
+  const_cast<Node*>(static_cast<const Node*>(fe))->set_val<2,30>(sw_->eofs_.size());
   sw_->eofs_.push_back(fe);
+  sw_->eof_fds_.push_back(numeric_limits<FId>::max());
+}
+
+SwLogic::NbaIndex::NbaIndex(SwLogic* sw) : Visitor() {
+  sw_ = sw;
+}
+
+void SwLogic::NbaIndex::visit(const NonblockingAssign* na) {
+  const auto* r = Resolve().get_resolution(na->get_lhs());
+  assert(r != nullptr);
+
+  SwLogic::NbaSite s = {r, !sw_->is_constant(na->get_lhs()), 0, -1, -1, numeric_limits<size_t>::max()};
+  if (!s.dynamic) {
+    const auto target = sw_->eval_.dereference(r, na->get_lhs());
+    s.idx = get<0>(target);
+    s.msb = get<1>(target);
+    s.lsb = get<2>(target);
+  }
+  const_cast<Node*>(static_cast<const Node*>(na))->set_val<2,30>(sw_->sites_.size());
+  sw_->sites_.push_back(s);
+  sw_->update_pool_.push_back(Bits(sw_->eval_.get_width(na->get_lhs()), 0));
+}
+
+SwLogic::IoIndex::IoIndex(SwLogic* sw) : Visitor() {
+  sw_ = sw;
+}
+
+void SwLogic::IoIndex::visit(const FflushStatement* fs) {
+  index(fs);
+}
+
+void SwLogic::IoIndex::visit(const FseekStatement* fs) {
+  index(fs);
+}
+
+void SwLogic::IoIndex::visit(const GetStatement* gs) {
+  index(gs);
+  sw_->io_sites_.back().get = Scanf::compile(gs);
+}
+
+void SwLogic::IoIndex::visit(const PutStatement* ps) {
+  index(ps);
+  sw_->io_sites_.back().put = Printf::compile(ps);
+}
+
+void SwLogic::IoIndex::index(const SystemTaskEnableStatement* s) {
+  const_cast<Node*>(static_cast<const Node*>(s))->set_val<2,30>(sw_->io_sites_.size());
+  sw_->io_sites_.emplace_back();
+  sw_->io_sites_.back().fd = 0;
+  sw_->io_sites_.back().is = nullptr;
 }
 
 void SwLogic::schedule_now(const Node* n) {
@@ -254,8 +317,15 @@ void SwLogic::schedule_now(const Node* n) {
 
 void SwLogic::schedule_active(const Node* n) {
   if (!n->get_flag<1>()) {
-    active_.push_back(n);
     const_cast<Node*>(n)->set_flag<1>(true);
+    const auto rank = (!levels_.empty() && n->is(Node::Tag::continuous_assign)) ? n->get_val<2,30>() : 0;
+    if (rank == 0) {
+      active_.push_back(n);
+    } else {
+      levels_[rank-1].push_back(n);
+      level_min_ = min(level_min_, static_cast<size_t>(rank-1));
+      ++level_size_;
+    }
   }
 }
 
@@ -281,18 +351,208 @@ void SwLogic::notify(const Node* n) {
   }
 }
 
-void SwLogic::silent_evaluate() {
-  // Turn on silent mode and drain the active queue
-  silent_ = true;
-  while (!active_.empty()) {
-    auto* e = active_.back();
-    active_.pop_back();
+void SwLogic::drain_active() {
+  // Ranked assigns go first, lowest rank first. Evaluating an assign can only
+  // activate assigns of higher rank, so this cursor only moves backwards when
+  // something else is run.
+  while (true) {
+    const Node* e = nullptr;
+    if (level_size_ > 0) {
+      while (levels_[level_min_].empty()) {
+        ++level_min_;
+      }
+      e = levels_[level_min_].back();
+      levels_[level_min_].pop_back();
+      --level_size_;
+    } else if (!active_.empty()) {
+      e = active_.back();
+      active_.pop_back();
+    } else {
+      break;
+    }
     const_cast<Node*>(e)->set_flag<1>(false);
     schedule_now(e);
   }
+}
+
+void SwLogic::levelize() {
+  // Index continuous assigns and record which of them write each variable
+  vector<const ContinuousAssign*> cas;
+  unordered_map<const Identifier*, vector<size_t>> writers;
+  for (auto i = src_->begin_items(), ie = src_->end_items(); i != ie; ++i) {
+    if ((*i)->is(Node::Tag::continuous_assign)) {
+      const auto* ca = static_cast<const ContinuousAssign*>(*i);
+      writers[Resolve().get_resolution(ca->get_lhs())].push_back(cas.size());
+      cas.push_back(ca);
+    }
+  }
+
+  // An assign depends on every assign which writes a variable that it reads
+  const auto n = cas.size();
+  vector<vector<size_t>> succs(n);
+  vector<bool> cyclic(n, false);
+  for (size_t j = 0; j < n; ++j) {
+    for (auto* e : ReadSet(cas[j]->get_rhs())) {
+      if (!e->is(Node::Tag::identifier)) {
+        continue;
+      }
+      const auto itr = writers.find(Resolve().get_resolution(static_cast<const Identifier*>(e)));
+      if (itr == writers.end()) {
+        continue;
+      }
+      for (auto i : itr->second) {
+        succs[i].push_back(j);
+        if (i == j) {
+          cyclic[j] = true;
+        }
+      }
+    }
+  }
+
+  // Find strongly connected components using an iterative version of
+  // Tarjan's algorithm. Components are emitted in reverse topological order.
+  // Anything in a component with more than one assign is part of a cycle.
+  const auto none = static_cast<size_t>(-1);
+  vector<size_t> index(n, none);
+  vector<size_t> low(n, 0);
+  vector<bool> on_stack(n, false);
+  vector<size_t> stack;
+  vector<pair<size_t, size_t>> calls;
+  vector<size_t> order;
+  size_t next = 0;
+  for (size_t s = 0; s < n; ++s) {
+    if (index[s] != none) {
+      continue;
+    }
+    index[s] = low[s] = next++;
+    stack.push_back(s);
+    on_stack[s] = true;
+    calls.push_back(make_pair(s, 0));
+
+    while (!calls.empty()) {
+      const auto v = calls.back().first;
+      if (calls.back().second < succs[v].size()) {
+        const auto w = succs[v][calls.back().second++];
+        if (index[w] == none) {
+          index[w] = low[w] = next++;
+          stack.push_back(w);
+          on_stack[w] = true;
+          calls.push_back(make_pair(w, 0));
+        } else if (on_stack[w]) {
+          low[v] = min(low[v], index[w]);
+        }
+        continue;
+      }
+      if (low[v] == index[v]) {
+        const auto begin = order.size();
+        size_t w = none;
+        do {
+          w = stack.back();
+          stack.pop_back();
+          on_stack[w] = false;
+          order.push_back(w);
+        } while (w != v);
+        if ((order.size() - begin) > 1) {
+          for (auto i = begin, ie = order.size(); i < ie; ++i) {
+            cyclic[order[i]] = true;
+          }
+        }
+      }
+      calls.pop_back();
+      if (!calls.empty()) {
+        auto& u = low[calls.back().first];
+        u = min(u, low[v]);
+      }
+    }
+  }
+
+  // Assign ranks in topological order, ignoring edges into and out of cycles.
+  // Rank zero is reserved for assigns which are scheduled as usual.
+  vector<uint32_t> rank(n, 1);
+  uint32_t max_rank = 0;
+  for (auto i = order.rbegin(), ie = order.rend(); i != ie; ++i) {
+    const auto v = *i;
+    if (cyclic[v]) {
+      rank[v] = 0;
+      continue;
+    }
+    max_rank = max(max_rank, rank[v]);
+    for (auto w : succs[v]) {
+      if (!cyclic[w]) {
+        rank[w] = max(rank[w], rank[v]+1);
+      }
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    const_cast<Node*>(static_cast<const Node*>(cas[i]))->set_val<2,30>(rank[i]);
+  }
+  levels_.resize(max_rank);
+}
+
+void SwLogic::silent_evaluate() {
+  // Turn on silent mode and drain the active queue
+  silent_ = true;
+  drain_active();
   silent_ = false;
 }
 
+void SwLogic::enqueue_update(const NonblockingAssign* na, const Bits& val) {
+  const auto site = na->get_val<2,30>();
+  auto& s = sites_[site];
+
+  size_t idx = s.idx;
+  int msb = s.msb;
+  int lsb = s.lsb;
+  if (s.dynamic) {
+    const auto target = eval_.dereference(s.r, na->get_lhs());
+    idx = get<0>(target);
+    msb = get<1>(target);
+    lsb = get<2>(target);
+  }
+
+  // The common case: this is the first time this site has fired this step.
+  size_t slot = site;
+  if (s.pos < updates_.size()) {
+    auto& u = updates_[s.pos];
+    if ((u.idx == idx) && (u.msb == msb) && (u.lsb == lsb)) {
+      // This site is overwriting its own pending update. If nothing has been
+      // enqueued since, we can overwrite the value in place. Otherwise, the
+      // old update is superseded and we requeue its slot at the end.
+      slot = u.slot;
+      if (s.pos+1 == updates_.size()) {
+        update_pool_[slot].copy(val);
+        return;
+      }
+      u.r = nullptr;
+    } else {
+      // This site is writing a different location. Spill into overflow.
+      slot = sites_.size() + overflow_++;
+      if (slot == update_pool_.size()) {
+        update_pool_.emplace_back();
+      }
+    }
+  }
+  s.pos = updates_.size();
+  updates_.push_back({s.r, idx, msb, lsb, site, slot});
+  update_pool_[slot].copy(val);
+}
+
+bool SwLogic::is_constant(const Identifier* id) const {
+  for (auto i = id->begin_dim(), ie = id->end_dim(); i != ie; ++i) {
+    if ((*i)->is(Node::Tag::number)) {
+      continue;
+    } 
+    if ((*i)->is(Node::Tag::range_expression)) {
+      const auto* re = static_cast<const RangeExpression*>(*i);
+      if (re->get_upper()->is(Node::Tag::number) && re->get_lower()->is(Node::Tag::number)) {
+        continue;
+      }
+    }
+    return false;
+  }
+  return true;
+}
+
 interfacestream* SwLogic::get_stream(FId fd) {
   const auto itr = streams_.find(fd);
   if (itr != streams_.end()) {
@@ -303,10 +563,24 @@ interfacestream* SwLogic::get_stream(FId fd) {
   return is;
 }
 
-void SwLogic::update_eofs() {
-  for (auto* fe : eofs_) {
-    eval_.flag_changed(fe);
-    notify(fe);
+interfacestream* SwLogic::get_stream(const Node* site, const Expression* fd) {
+  auto& s = io_sites_[site->get_val<2,30>()];
+  const auto val = eval_.get_value(fd).to_uint();
+  if ((s.is == nullptr) || (s.fd != val)) {
+    s.fd = val;
+    s.is = get_stream(val);
+  }
+  return s.is;
+}
+
+void SwLogic::update_eofs(FId fd) {
+  // An $feof which hasn't been evaluated yet doesn't have an fd, so there's
+  // no telling what it depends on.
+  for (size_t i = 0, ie = eofs_.size(); i < ie; ++i) {
+    if ((eof_fds_[i] == fd) || (eof_fds_[i] == numeric_limits<FId>::max())) {
+      eval_.flag_changed(eofs_[i]);
+      notify(eofs_[i]);
+    }
   }
 }
 
@@ -345,18 +619,7 @@ void SwLogic::visit(const NonblockingAssign* na) {
   assert(na->is_null_ctrl());
   
   if (!silent_) {
-    const auto* r = Resolve().get_resolution(na->get_lhs());
-    assert(r != nullptr);
-    const auto target = eval_.dereference(r, na->get_lhs());
-    const auto& res = eval_.get_value(na->get_rhs());
-
-    const auto idx = updates_.size();
-    if (idx >= update_pool_.size()) {
-      update_pool_.resize(2*update_pool_.size());
-    } 
-
-    updates_.push_back(make_tuple(r, get<0>(target), get<1>(target), get<2>(target)));
-    update_pool_[idx].copy(res);
+    enqueue_update(na, eval_.get_value(na->get_rhs()));
   }
 }
 
@@ -393,11 +656,10 @@ void SwLogic::visit(const ConditionalStatement* cs) {
 
 void SwLogic::visit(const FflushStatement* fs) {
   if (!silent_) {
-    const auto fd = eval_.get_value(fs->get_fd()).to_uint();
-    auto* is = get_stream(fd);
+    auto* is = get_stream(fs, fs->get_fd());
     is->clear();
     is->flush();
-    update_eofs();
+    update_eofs(io_sites_[fs->get_val<2,30>()].fd);
   }
 }
 
@@ -410,8 +672,7 @@ void SwLogic::visit(const FinishStatement* fs) {
 
 void SwLogic::visit(const FseekStatement* fs) {
   if (!silent_) {
-    const auto fd = eval_.get_value(fs->get_fd()).to_uint();
-    auto* is = get_stream(fd);
+    auto* is = get_stream(fs, fs->get_fd());
 
     const auto offset = eval_.get_value(fs->get_offset()).to_uint();
     const auto op = eval_.get_value(fs->get_op()).to_uint();
@@ -420,7 +681,7 @@ void SwLogic::visit(const FseekStatement* fs) {
     is->clear();
     is->seekg(offset, way); 
     is->seekp(offset, way);
-    update_eofs();
+    update_eofs(io_sites_[fs->get_val<2,30>()].fd);
   }
 }
 
@@ -435,25 +696,25 @@ void SwLogic::visit(const DebugStatement* ds) {
 
 void SwLogic::visit(const GetStatement* gs) {
   if (!silent_) {
-    const auto fd = eval_.get_value(gs->get_fd()).to_uint();
-    auto* is = get_stream(fd);
-    Scanf().read(*is, &eval_, gs);
+    const auto& site = io_sites_[gs->get_val<2,30>()];
+    auto* is = get_stream(gs, gs->get_fd());
+    Scanf().read(*is, &eval_, gs, site.get);
 
     if (gs->is_non_null_var()) {
       const auto* r = Resolve().get_resolution(gs->get_var());
       assert(r != nullptr);
       notify(r);
     }
-    update_eofs();
+    update_eofs(site.fd);
   }
 }
 
 void SwLogic::visit(const PutStatement* ps) {
   if (!silent_) {
-    const auto fd = eval_.get_value(ps->get_fd()).to_uint();
-    auto* is = get_stream(fd);
-    Printf().write(*is, &eval_, ps);
-    update_eofs();
+    const auto& site = io_sites_[ps->get_val<2,30>()];
+    auto* is = get_stream(ps, ps->get_fd());
+    Printf().write(*is, &eval_, ps, site.put);
+    update_eofs(site.fd);
   }
 }
 
@@ -32,11 +32,12 @@
 #define CASCADE_SRC_TARGET_CORE_SW_SW_LOGIC_H
 
 #include <string>
-#include <tuple>
 #include <unordered_map>
 #include <vector>
 #include "common/bits.h"
 #include "target/core.h"
+#include "target/core/common/printf.h"
+#include "target/core/common/scanf.h"
 #include "verilog/analyze/evaluate.h"
 #include "verilog/ast/visitors/visitor.h"
 
@@ -68,6 +69,7 @@ class SwLogic : public Logic, public Visitor {
     bool there_are_updates() const override;
     void update() override;
     bool there_were_tasks() const override;
+    bool supports_concurrency() const override;
 
   private:
     class EofIndex : public Visitor {
@@ -77,6 +79,68 @@ class SwLogic : public Logic, public Visitor {
       private:
         SwLogic* sw_;
     };
+    class NbaIndex : public Visitor {
+      public:
+        NbaIndex(SwLogic* sw);
+        void visit(const NonblockingAssign* na);
+      private:
+        SwLogic* sw_;
+    };
+    class IoIndex : public Visitor {
+      public:
+        IoIndex(SwLogic* sw);
+        void visit(const FflushStatement* fs);
+        void visit(const FseekStatement* fs);
+        void visit(const GetStatement* gs);
+        void visit(const PutStatement* ps);
+      private:
+        SwLogic* sw_;
+        void index(const SystemTaskEnableStatement* s);
+    };
+
+  protected:
+    // Nonblocking Update Queue:
+    //
+    // Every nonblocking assign in the module is a site, and owns a slot in the
+    // update pool which is sized when the core is constructed. Updates point
+    // into the pool rather than owning their values, and a site which fires
+    // more than once in a time step overwrites its pending update rather than
+    // adding a new one. Sites with dynamic subscripts which write more than
+    // one location in a step spill into overflow slots at the end of the pool.
+    // Neither the pool nor the queue shrinks, so once a module has warmed up,
+    // enqueueing an update never allocates.
+    struct NbaSite {
+      const Identifier* r;
+      bool dynamic;
+      size_t idx;
+      int msb;
+      int lsb;
+      size_t pos;
+    };
+    struct Update {
+      // Resolved target, nullptr if this update was superseded
+      const Identifier* r;
+      size_t idx;
+      int msb;
+      int lsb;
+      size_t site;
+      size_t slot;
+    };
+
+    // System Task Sites:
+    //
+    // Every stream task in the module is also a site. Format strings are
+    // parsed once when the core is constructed, and each site remembers the
+    // last stream that it touched, so that repeated accesses to the same fd
+    // skip the stream table. Likewise, every $feof remembers the fd that it
+    // was last evaluated against, so that a stream task only needs to notify
+    // the $feofs which could have observed it.
+    struct IoSite {
+      FId fd;
+      interfacestream* is;
+      Printf::Format put;
+      Scanf::Format get;
+    };
 
     // Source Management:
     ModuleDeclaration* src_;
@@ -84,27 +148,47 @@ class SwLogic : public Logic, public Visitor {
     std::vector<std::pair<const Identifier*, VId>> outputs_;
     std::unordered_map<VId, const Identifier*> state_;
     std::vector<const FeofExpression*> eofs_;
+    std::vector<FId> eof_fds_;
+    std::vector<IoSite> io_sites_;
 
     // Control State:
     bool silent_;
     bool there_were_tasks_;
     std::vector<const Node*> active_;
-    std::vector<std::tuple<const Identifier*,size_t,int,int>> updates_;
+    std::vector<std::vector<const Node*>> levels_;
+    size_t level_min_;
+    size_t level_size_;
+    std::vector<NbaSite> sites_;
+    std::vector<Update> updates_;
     std::vector<Bits> update_pool_;
+    size_t overflow_;
     Evaluate eval_;
     std::unordered_map<FId, interfacestream*> streams_;
 
     // Scheduling: 
-    void schedule_now(const Node* n);
+    virtual void schedule_now(const Node* n);
     void schedule_active(const Node* n);
     void notify(const Node* n);
+    void drain_active();
+
+    // Levelization:
+    //
+    // When a module is annotated with __levelize, continuous assigns which
+    // aren't part of a combinational cycle are ranked in topological order.
+    // Ranked assigns are scheduled ahead of everything else in rank order, so
+    // that a chain of assigns settles after evaluating each link at most once.
+    // Everything else is scheduled as usual.
+    void levelize();
 
     // Finalize Helpers:
     void silent_evaluate();
 
     // Control Helpers:
+    void enqueue_update(const NonblockingAssign* na, const Bits& val);
+    bool is_constant(const Identifier* id) const;
     interfacestream* get_stream(FId fd);
-    void update_eofs();
+    interfacestream* get_stream(const Node* site, const Expression* fd);
+    void update_eofs(FId fd);
 
     // Visitor Interface:
     void visit(const Event* e) override;
@@ -0,0 +1,437 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/sw/vm_logic.h"
+
+#include <cassert>
+#include <tuple>
+#include "verilog/analyze/resolve.h"
+#include "verilog/ast/ast.h"
+
+using namespace std;
+
+namespace cascade::sw {
+
+VmLogic::VmLogic(Interface* interface, ModuleDeclaration* md) : SwLogic(interface, md) {
+  // Lower every construct which the scheduler can place on the active queue.
+  // Events are left alone; they're cheap and SwLogic handles them directly.
+  for (auto i = src_->begin_items(), ie = src_->end_items(); i != ie; ++i) {
+    if ((*i)->is(Node::Tag::continuous_assign)) {
+      const auto* ca = static_cast<const ContinuousAssign*>(*i);
+      entry_[ca] = code_.size();
+      compile_assign(Op::BLOCKING, ca->get_lhs(), compile_expr(ca->get_rhs()));
+      emit(Op::HALT);
+    } else if ((*i)->is(Node::Tag::always_construct)) {
+      const auto* ac = static_cast<const AlwaysConstruct*>(*i);
+      if (ac->get_stmt()->is(Node::Tag::timing_control_statement)) {
+        const auto* tcs = static_cast<const TimingControlStatement*>(ac->get_stmt());
+        compile_entry(tcs->get_stmt(), tcs->get_stmt());
+      }
+    } else if ((*i)->is(Node::Tag::initial_construct)) {
+      const auto* ic = static_cast<const InitialConstruct*>(*i);
+      compile_entry(ic, ic->get_stmt());
+    }
+  }
+}
+
+void VmLogic::schedule_now(const Node* n) {
+  const auto itr = entry_.find(n);
+  if (itr != entry_.end()) {
+    run(itr->second);
+  } else {
+    SwLogic::schedule_now(n);
+  }
+}
+
+void VmLogic::compile_entry(const Node* n, const Statement* s) {
+  entry_[n] = code_.size();
+  compile_stmt(s);
+  emit(Op::HALT);
+}
+
+void VmLogic::compile_stmt(const Statement* s) {
+  switch (s->get_tag()) {
+    case Node::Tag::seq_block: {
+      const auto* sb = static_cast<const SeqBlock*>(s);
+      for (auto i = sb->begin_stmts(), ie = sb->end_stmts(); i != ie; ++i) {
+        compile_stmt(*i);
+      }
+      break;
+    }
+    case Node::Tag::conditional_statement: {
+      const auto* cs = static_cast<const ConditionalStatement*>(s);
+      const auto br = emit(Op::JMP_FALSE, nullptr, compile_expr(cs->get_if()));
+      compile_stmt(cs->get_then());
+      const auto end = emit(Op::JMP);
+      code_[br].idx = code_.size();
+      compile_stmt(cs->get_else());
+      code_[end].idx = code_.size();
+      break;
+    }
+    case Node::Tag::case_statement: {
+      // Case items are tested in order, and the first default item which we
+      // encounter terminates the search. This mirrors SwLogic.
+      const auto* cs = static_cast<const CaseStatement*>(s);
+      const auto* cond = compile_expr(cs->get_cond());
+      vector<pair<const Statement*, vector<size_t>>> bodies;
+      for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) {
+        bodies.push_back(make_pair((*i)->get_stmt(), vector<size_t>()));
+        for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) {
+          const auto* val = compile_expr(*j);
+          bodies.back().second.push_back(emit(Op::JMP_EQ, nullptr, cond, val));
+        }
+        if ((*i)->empty_exprs()) {
+          break;
+        }
+      }
+      vector<size_t> ends;
+      if (bodies.empty() || !bodies.back().second.empty()) {
+        ends.push_back(emit(Op::JMP));
+      } else {
+        bodies.back().second.push_back(emit(Op::JMP));
+      }
+      for (auto& b : bodies) {
+        for (auto j : b.second) {
+          code_[j].idx = code_.size();
+        }
+        compile_stmt(b.first);
+        ends.push_back(emit(Op::JMP));
+      }
+      for (auto j : ends) {
+        code_[j].idx = code_.size();
+      }
+      break;
+    }
+    case Node::Tag::blocking_assign: {
+      // TODO(eschkufz) Support for timing control
+      const auto* ba = static_cast<const BlockingAssign*>(s);
+      assert(ba->is_null_ctrl());
+      compile_assign(Op::BLOCKING, ba->get_lhs(), compile_expr(ba->get_rhs()));
+      break;
+    }
+    case Node::Tag::nonblocking_assign: {
+      // TODO(eschkufz) Support for timing control
+      const auto* na = static_cast<const NonblockingAssign*>(s);
+      assert(na->is_null_ctrl());
+      emit(Op::NONBLOCKING, nullptr, compile_expr(na->get_rhs()), nullptr, na);
+      break;
+    }
+    default:
+      emit(Op::VISIT, nullptr, nullptr, nullptr, s);
+      break;
+  }
+}
+
+void VmLogic::compile_assign(Op op, const Identifier* lhs, const Bits* val) {
+  const auto* r = Resolve().get_resolution(lhs);
+  assert(r != nullptr);
+
+  auto& i = code_[emit(op, nullptr, val, nullptr, lhs)];
+  i.r = r;
+  i.dynamic = !is_constant(lhs);
+  if (!i.dynamic) {
+    const auto target = eval_.dereference(r, lhs);
+    i.idx = get<0>(target);
+    i.msb = get<1>(target);
+    i.lsb = get<2>(target);
+  }
+}
+
+const Bits* VmLogic::compile_expr(const Expression* e) {
+  switch (e->get_tag()) {
+    case Node::Tag::binary_expression: {
+      const auto* be = static_cast<const BinaryExpression*>(e);
+      const auto* l = compile_expr(be->get_lhs());
+      const auto* r = compile_expr(be->get_rhs());
+      auto op = Op::EVAL;
+      switch (be->get_op()) {
+        case BinaryExpression::Op::PLUS:   op = Op::PLUS; break;
+        case BinaryExpression::Op::MINUS:  op = Op::MINUS; break;
+        case BinaryExpression::Op::TIMES:  op = Op::TIMES; break;
+        case BinaryExpression::Op::DIV:    op = Op::DIV; break;
+        case BinaryExpression::Op::MOD:    op = Op::MOD; break;
+        // NOTE: These are equivalent because we don't support x and z
+        case BinaryExpression::Op::EEEQ:
+        case BinaryExpression::Op::EEQ:    op = Op::EQ; break;
+        case BinaryExpression::Op::BEEQ:
+        case BinaryExpression::Op::BEQ:    op = Op::NE; break;
+        case BinaryExpression::Op::AAMP:   op = Op::LAND; break;
+        case BinaryExpression::Op::PPIPE:  op = Op::LOR; break;
+        case BinaryExpression::Op::TTIMES: op = Op::POW; break;
+        case BinaryExpression::Op::LT:     op = Op::LT; break;
+        case BinaryExpression::Op::LEQ:    op = Op::LEQ; break;
+        case BinaryExpression::Op::GT:     op = Op::GT; break;
+        case BinaryExpression::Op::GEQ:    op = Op::GEQ; break;
+        case BinaryExpression::Op::AMP:    op = Op::AND; break;
+        case BinaryExpression::Op::PIPE:   op = Op::OR; break;
+        case BinaryExpression::Op::CARAT:  op = Op::XOR; break;
+        case BinaryExpression::Op::TCARAT: op = Op::XNOR; break;
+        case BinaryExpression::Op::LLT:    op = Op::SLL; break;
+        case BinaryExpression::Op::LLLT:   op = Op::SAL; break;
+        case BinaryExpression::Op::GGT:    op = Op::SLR; break;
+        case BinaryExpression::Op::GGGT:   op = Op::SAR; break;
+        default:
+          assert(false);
+          break;
+      }
+      emit(op, slot(e), l, r, e);
+      return slot(e);
+    }
+    case Node::Tag::unary_expression: {
+      const auto* ue = static_cast<const UnaryExpression*>(e);
+      const auto* l = compile_expr(ue->get_lhs());
+      auto op = Op::EVAL;
+      switch (ue->get_op()) {
+        case UnaryExpression::Op::PLUS:   op = Op::UPLUS; break;
+        case UnaryExpression::Op::MINUS:  op = Op::UMINUS; break;
+        case UnaryExpression::Op::BANG:   op = Op::LNOT; break;
+        case UnaryExpression::Op::TILDE:  op = Op::NOT; break;
+        case UnaryExpression::Op::AMP:    op = Op::RAND; break;
+        case UnaryExpression::Op::TAMP:   op = Op::RNAND; break;
+        case UnaryExpression::Op::PIPE:   op = Op::ROR; break;
+        case UnaryExpression::Op::TPIPE:  op = Op::RNOR; break;
+        case UnaryExpression::Op::CARAT:  op = Op::RXOR; break;
+        case UnaryExpression::Op::TCARAT: op = Op::RXNOR; break;
+        default:
+          assert(false);
+          break;
+      }
+      emit(op, slot(e), l, nullptr, e);
+      return slot(e);
+    }
+    case Node::Tag::conditional_expression: {
+      const auto* ce = static_cast<const ConditionalExpression*>(e);
+      const auto br = emit(Op::JMP_FALSE, nullptr, compile_expr(ce->get_cond()));
+      emit(Op::COPY, slot(e), compile_expr(ce->get_lhs()));
+      const auto end = emit(Op::JMP);
+      code_[br].idx = code_.size();
+      emit(Op::COPY, slot(e), compile_expr(ce->get_rhs()));
+      code_[end].idx = code_.size();
+      return slot(e);
+    }
+    case Node::Tag::concatenation: {
+      const auto* c = static_cast<const Concatenation*>(e);
+      auto i = c->begin_exprs();
+      emit(Op::COPY, slot(e), compile_expr(*i++));
+      for (auto ie = c->end_exprs(); i != ie; ++i) {
+        emit(Op::CONCAT, slot(e), compile_expr(*i));
+      }
+      return slot(e);
+    }
+    case Node::Tag::identifier: {
+      // Fast Path: Unsubscripted references to scalars which agree with their
+      // declaration on width and type can be read directly from storage.
+      const auto* id = static_cast<const Identifier*>(e);
+      const auto* r = Resolve().get_resolution(id);
+      assert(r != nullptr);
+      if (id->empty_dim() && r->empty_dim() && 
+          (eval_.get_width(id) == eval_.get_width(r)) && 
+          (eval_.get_type(id) == eval_.get_type(r))) {
+        return slot(r);
+      }
+      emit(Op::EVAL, slot(e), nullptr, nullptr, e);
+      return slot(e);
+    }
+    case Node::Tag::number:
+    case Node::Tag::string:
+      return slot(e);
+    default:
+      emit(Op::EVAL, slot(e), nullptr, nullptr, e);
+      return slot(e);
+  }
+}
+
+Bits* VmLogic::slot(const Expression* e) {
+  // Evaluate allocates storage for an entire expression tree at once, and
+  // that storage is never reallocated for as long as this module is alive.
+  return eval_.get_storage(e);
+}
+
+size_t VmLogic::emit(Op op, Bits* dst, const Bits* a, const Bits* b, const Node* n) {
+  code_.push_back({op, dst, a, b, n, nullptr, 0, -1, -1, false});
+  return code_.size()-1;
+}
+
+void VmLogic::run(size_t pc) {
+  const auto* code = code_.data();
+  for (;;) {
+    const auto& i = code[pc++];
+    switch (i.op) {
+      case Op::EVAL:
+        eval_.get_value(static_cast<const Expression*>(i.n));
+        break;
+      case Op::COPY:
+        i.dst->assign(*i.a);
+        break;
+      case Op::CONCAT:
+        i.dst->concat(*i.a);
+        break;
+
+      case Op::PLUS:
+        i.dst->arithmetic_plus(*i.a, *i.b);
+        break;
+      case Op::MINUS:
+        i.dst->arithmetic_minus(*i.a, *i.b);
+        break;
+      case Op::TIMES:
+        i.dst->arithmetic_multiply(*i.a, *i.b);
+        break;
+      case Op::DIV:
+        i.dst->arithmetic_divide(*i.a, *i.b);
+        break;
+      case Op::MOD:
+        i.dst->arithmetic_mod(*i.a, *i.b);
+        break;
+      case Op::POW:
+        i.dst->arithmetic_pow(*i.a, *i.b);
+        break;
+      case Op::EQ:
+        i.dst->logical_eq(*i.a, *i.b);
+        break;
+      case Op::NE:
+        i.dst->logical_ne(*i.a, *i.b);
+        break;
+      case Op::LAND:
+        i.dst->logical_and(*i.a, *i.b);
+        break;
+      case Op::LOR:
+        i.dst->logical_or(*i.a, *i.b);
+        break;
+      case Op::LT:
+        i.dst->logical_lt(*i.a, *i.b);
+        break;
+      case Op::LEQ:
+        i.dst->logical_lte(*i.a, *i.b);
+        break;
+      case Op::GT:
+        i.dst->logical_gt(*i.a, *i.b);
+        break;
+      case Op::GEQ:
+        i.dst->logical_gte(*i.a, *i.b);
+        break;
+      case Op::AND:
+        i.dst->bitwise_and(*i.a, *i.b);
+        break;
+      case Op::OR:
+        i.dst->bitwise_or(*i.a, *i.b);
+        break;
+      case Op::XOR:
+        i.dst->bitwise_xor(*i.a, *i.b);
+        break;
+      case Op::XNOR:
+        i.dst->bitwise_xnor(*i.a, *i.b);
+        break;
+      case Op::SLL:
+        i.dst->bitwise_sll(*i.a, *i.b);
+        break;
+      case Op::SAL:
+        i.dst->bitwise_sal(*i.a, *i.b);
+        break;
+      case Op::SLR:
+        i.dst->bitwise_slr(*i.a, *i.b);
+        break;
+      case Op::SAR:
+        i.dst->bitwise_sar(*i.a, *i.b);
+        break;
+
+      case Op::UPLUS:
+        i.dst->arithmetic_plus(*i.a);
+        break;
+      case Op::UMINUS:
+        i.dst->arithmetic_minus(*i.a);
+        break;
+      case Op::LNOT:
+        i.dst->logical_not(*i.a);
+        break;
+      case Op::NOT:
+        i.dst->bitwise_not(*i.a);
+        break;
+      case Op::RAND:
+        i.dst->reduce_and(*i.a);
+        break;
+      case Op::RNAND:
+        i.dst->reduce_nand(*i.a);
+        break;
+      case Op::ROR:
+        i.dst->reduce_or(*i.a);
+        break;
+      case Op::RNOR:
+        i.dst->reduce_nor(*i.a);
+        break;
+      case Op::RXOR:
+        i.dst->reduce_xor(*i.a);
+        break;
+      case Op::RXNOR:
+        i.dst->reduce_xnor(*i.a);
+        break;
+
+      case Op::JMP:
+        pc = i.idx;
+        break;
+      case Op::JMP_FALSE:
+        if (!i.a->to_bool()) {
+          pc = i.idx;
+        }
+        break;
+      case Op::JMP_EQ:
+        if (i.a->to_uint() == i.b->to_uint()) {
+          pc = i.idx;
+        }
+        break;
+
+      case Op::BLOCKING: 
+        if (i.dynamic) {
+          const auto target = eval_.dereference(i.r, static_cast<const Identifier*>(i.n));
+          if (eval_.assign_value(i.r, get<0>(target), get<1>(target), get<2>(target), *i.a)) {
+            notify(i.r);
+          }
+        } else if (eval_.assign_value(i.r, i.idx, i.msb, i.lsb, *i.a)) {
+          notify(i.r);
+        }
+        break;
+      case Op::NONBLOCKING:
+        if (!silent_) {
+          enqueue_update(static_cast<const NonblockingAssign*>(i.n), *i.a);
+        }
+        break;
+      case Op::VISIT:
+        i.n->accept(this);
+        break;
+      case Op::HALT:
+        return;
+
+      default:
+        assert(false);
+        return;
+    }
+  }
+}
+
+} // namespace cascade::sw
@@ -0,0 +1,148 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_SW_VM_LOGIC_H
+#define CASCADE_SRC_TARGET_CORE_SW_VM_LOGIC_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "common/bits.h"
+#include "target/core/sw/sw_logic.h"
+
+namespace cascade::sw {
+
+// This class is a drop-in replacement for SwLogic which trades the visitor
+// based interpretation of statements and expressions for a flat bytecode
+// program. Every continuous assign, always block body, and initial construct
+// is lowered to a sequence of instructions whose operands are pointers
+// directly into the bit storage which decorates the AST. Identifiers are
+// resolved, widths are fixed, and constant subscripts are dereferenced ahead of
+// time. Scheduling, system tasks, and state management are inherited
+// unchanged from SwLogic. Anything which the compiler doesn't know how to
+// lower is handed back to the SwLogic visitor.
+
+class VmLogic : public SwLogic {
+  public:
+    VmLogic(Interface* interface, ModuleDeclaration* md);
+    ~VmLogic() override = default;
+
+  private:
+    enum class Op : uint8_t {
+      // Expressions:
+      EVAL = 0,
+      COPY,
+      CONCAT,
+      PLUS,
+      MINUS,
+      TIMES,
+      DIV,
+      MOD,
+      POW,
+      EQ,
+      NE,
+      LAND,
+      LOR,
+      LT,
+      LEQ,
+      GT,
+      GEQ,
+      AND,
+      OR,
+      XOR,
+      XNOR,
+      SLL,
+      SAL,
+      SLR,
+      SAR,
+      UPLUS,
+      UMINUS,
+      LNOT,
+      NOT,
+      RAND,
+      RNAND,
+      ROR,
+      RNOR,
+      RXOR,
+      RXNOR,
+
+      // Control:
+      JMP,
+      JMP_FALSE,
+      JMP_EQ,
+
+      // Statements:
+      BLOCKING,
+      NONBLOCKING,
+      VISIT,
+      HALT
+    };
+
+    struct Instr {
+      Op op;
+      // Expression operands. For jumps, a and b are the values to test.
+      Bits* dst;
+      const Bits* a;
+      const Bits* b;
+      // The node this instruction was generated from. For blocking assignments
+      // this is the lhs of the assignment, for nonblocking assignments it is the
+      // assignment itself.
+      const Node* n;
+      // Assignments: the resolved target and, if its subscripts are constant,
+      // a pre-computed index and bit range. Jumps: the target pc in idx.
+      const Identifier* r;
+      size_t idx;
+      int msb;
+      int lsb;
+      bool dynamic;
+    };
+
+    // Program State:
+    std::vector<Instr> code_;
+    std::unordered_map<const Node*, size_t> entry_;
+
+    // Scheduling:
+    void schedule_now(const Node* n) override;
+
+    // Code Generation:
+    void compile_entry(const Node* n, const Statement* s);
+    void compile_stmt(const Statement* s);
+    void compile_assign(Op op, const Identifier* lhs, const Bits* val);
+    const Bits* compile_expr(const Expression* e);
+    Bits* slot(const Expression* e);
+    size_t emit(Op op, Bits* dst = nullptr, const Bits* a = nullptr, const Bits* b = nullptr, const Node* n = nullptr);
+
+    // Execution:
+    void run(size_t pc);
+};
+
+} // namespace cascade::sw
+
+#endif
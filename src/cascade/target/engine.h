@@ -32,6 +32,10 @@
 #define CASCADE_SRC_TARGET_ENGINE_H
 
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "common/bits.h"
 #include "runtime/ids.h"
 #include "target/core/sw/sw_clock.h"
 #include "target/core.h"
@@ -60,6 +64,7 @@ class Engine {
     void done_step();
     bool overrides_done_simulation() const;
     void done_simulation();
+    bool supports_concurrency() const;
     bool there_are_reads() const;
     void evaluate();
     bool there_are_updates() const;
@@ -72,7 +77,21 @@ class Engine {
     size_t open_loop(VId clk, bool val, size_t itr);
 
     // I/O Interface:
+    //
+    // read() hands a value to this engine's core immediately. mark() only
+    // records that the value of id in slots has changed. Marked values are
+    // delivered from slots the next time the core is used, so an id which
+    // changes several times in between is only copied once.
     void read(VId id, const Bits* b);
+    void mark(VId id, const std::vector<Bits>* slots);
+
+    // Scheduler Interface:
+    //
+    // Engines which are given a schedule set bit idx in it whenever they have
+    // reads. Bits may be stale, so the scheduler should still check
+    // there_are_reads() before evaluating an engine. Passing nullptr detaches
+    // an engine from its schedule.
+    void set_schedule(std::vector<uint64_t>* sched, size_t idx);
 
     // State Management Interface:
     State* get_state();
@@ -89,12 +108,43 @@ class Engine {
     // Compiler Interface:
     void replace_with(Engine* e);
 
+    // Profiling Interface:
+    //
+    // Engines keep a running tally of the work they've done. These counters
+    // survive calls to replace_with(), so they describe a module rather than
+    // whichever core currently implements it. Evaluations and updates are
+    // timed once every sample_ calls, so time is an estimate. Yields count
+    // the calls to open_loop() which returned before running for as long as
+    // they were asked to.
+    struct Profile {
+      uint64_t evaluations;
+      uint64_t updates;
+      uint64_t open_loops;
+      uint64_t open_loop_itrs;
+      uint64_t open_loop_yields;
+      uint64_t time_ns;
+    };
+    const Profile& get_profile() const;
+
   private:
+    static constexpr uint64_t sample_ = 64;
+
     Id id_;
     Interface* i_;
     Core* c_;
 
     bool there_are_reads_;
+    Profile profile_;
+
+    const std::vector<Bits>* slots_;
+    std::vector<VId> pending_;
+    std::vector<uint64_t> marked_;
+    std::vector<uint64_t>* sched_;
+    size_t sched_idx_;
+
+    void deliver();
+    void flag();
+    static uint64_t now();
 };
 
 inline Engine::Engine(Id id, Interface* i, Core* c) {
@@ -104,6 +154,10 @@ inline Engine::Engine(Id id, Interface* i, Core* c) {
   i_ = i;
   c_ = c;
   there_are_reads_ = false;
+  profile_ = {0, 0, 0, 0, 0, 0};
+  slots_ = nullptr;
+  sched_ = nullptr;
+  sched_idx_ = 0;
 }
 
 inline Engine::~Engine() {
@@ -147,12 +201,23 @@ inline void Engine::done_simulation() {
   c_->done_simulation();
 }
 
+inline bool Engine::supports_concurrency() const {
+  return c_->supports_concurrency();
+}
+
 inline bool Engine::there_are_reads() const {
-  return there_are_reads_;
+  return there_are_reads_ || !pending_.empty();
 }
 
 inline void Engine::evaluate() {
-  c_->evaluate();
+  deliver();
+  if ((++profile_.evaluations % sample_) == 0) {
+    const auto begin = now();
+    c_->evaluate();
+    profile_.time_ns += sample_ * (now() - begin);
+  } else {
+    c_->evaluate();
+  }
   there_are_reads_ = false;
 }
 
@@ -161,7 +226,14 @@ inline bool Engine::there_are_updates() const {
 }
 
 inline void Engine::update() {
-  c_->update();
+  deliver();
+  if ((++profile_.updates % sample_) == 0) {
+    const auto begin = now();
+    c_->update();
+    profile_.time_ns += sample_ * (now() - begin);
+  } else {
+    c_->update();
+  }
   there_are_reads_ = false;
 }
 
@@ -170,7 +242,7 @@ inline bool Engine::there_were_tasks() const {
 }
 
 inline bool Engine::conditional_evaluate() {
-  if (there_are_reads_) {
+  if (there_are_reads()) {
     evaluate();
     return true;
   }
@@ -178,19 +250,61 @@ inline bool Engine::conditional_evaluate() {
 }
 
 inline bool Engine::conditional_update() {
-  return c_->conditional_update();
+  deliver();
+  const auto sample = ((profile_.updates + 1) % sample_) == 0;
+  const auto begin = sample ? now() : 0;
+  if (!c_->conditional_update()) {
+    return false;
+  }
+  ++profile_.updates;
+  if (sample) {
+    profile_.time_ns += sample_ * (now() - begin);
+  }
+  return true;
 }
 
 inline size_t Engine::open_loop(VId clk, bool val, size_t itr) {
-  return c_->open_loop(clk, val, itr);
+  deliver();
+  const auto begin = now();
+  const auto res = c_->open_loop(clk, val, itr);
+  profile_.time_ns += now() - begin;
+  ++profile_.open_loops;
+  profile_.open_loop_itrs += res;
+  profile_.open_loop_yields += (res < itr) ? 1 : 0;
+  return res;
 }
 
 inline void Engine::read(VId id, const Bits* b) {
   c_->read(id, b);
   there_are_reads_ = true;
+  flag();
+}
+
+inline void Engine::mark(VId id, const std::vector<Bits>* slots) {
+  slots_ = slots;
+  const auto w = id >> 6;
+  const auto b = static_cast<uint64_t>(1) << (id & 63);
+  if (w >= marked_.size()) {
+    marked_.resize(w+1, 0);
+  }
+  if (marked_[w] & b) {
+    return;
+  }
+  marked_[w] |= b;
+  pending_.push_back(id);
+  flag();
+}
+
+inline void Engine::set_schedule(std::vector<uint64_t>* sched, size_t idx) {
+  sched_ = sched;
+  sched_idx_ = idx;
+  if (there_are_reads()) {
+    flag();
+  }
 }
 
 inline State* Engine::get_state() {
+  deliver();
   return c_->get_state();
 }
 
@@ -199,6 +313,7 @@ inline void Engine::set_state(const State* s) {
 }
 
 inline Input* Engine::get_input() {
+  deliver();
   return c_->get_input();
 }
 
@@ -230,6 +345,7 @@ inline void Engine::set_clock_val(bool v) {
 
 inline void Engine::replace_with(Engine* e) {
   // Move state and inputs from this engine into the new engine
+  deliver();
   const auto* s = c_->get_state();
   e->c_->set_state(s);
   delete s;
@@ -246,6 +362,9 @@ inline void Engine::replace_with(Engine* e) {
   c_ = e->c_;
   i_ = e->i_;
   there_are_reads_ = e->there_are_reads_;
+  if (there_are_reads_) {
+    flag();
+  }
 
   // Delete the shell which is left over
   e->i_ = nullptr;
@@ -253,6 +372,32 @@ inline void Engine::replace_with(Engine* e) {
   delete e;
 }
 
+inline const Engine::Profile& Engine::get_profile() const {
+  return profile_;
+}
+
+inline void Engine::deliver() {
+  if (pending_.empty()) {
+    return;
+  }
+  for (auto id : pending_) {
+    marked_[id >> 6] &= ~(static_cast<uint64_t>(1) << (id & 63));
+    c_->read(id, &(*slots_)[id]);
+  }
+  pending_.clear();
+  there_are_reads_ = true;
+}
+
+inline void Engine::flag() {
+  if (sched_ != nullptr) {
+    (*sched_)[sched_idx_ >> 6] |= (static_cast<uint64_t>(1) << (sched_idx_ & 63));
+  }
+}
+
+inline uint64_t Engine::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 } // namespace cascade
 
 #endif
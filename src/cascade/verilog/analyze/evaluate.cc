@@ -120,6 +120,13 @@ const Vector<Bits>& Evaluate::get_array_value(const Identifier* i) {
   return i->bit_val_;
 }
 
+Bits* Evaluate::get_storage(const Expression* e) {
+  if (e->bit_val_.empty()) {
+    init(const_cast<Expression*>(e));
+  }
+  return &const_cast<Expression*>(e)->bit_val_[0];
+}
+
 pair<size_t, size_t> Evaluate::get_range(const Expression* e) {
   if (e->is(Node::Tag::range_expression)) {
     const auto* re = static_cast<const RangeExpression*>(e);
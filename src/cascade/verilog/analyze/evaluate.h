@@ -101,6 +101,12 @@ class Evaluate : public Editor {
     // Returns upper and lower values for ranges, get_value() twice otherwise.
     std::pair<size_t, size_t> get_range(const Expression* e);
 
+    // Low-level interface: Returns a pointer to the storage which holds the
+    // bit value of an expression, allocating it if necessary. The value is
+    // NOT brought up to date. The pointer remains valid until e is
+    // invalidated.
+    Bits* get_storage(const Expression* e);
+
     // High-level interface: Resolves id and sets the value of its target val.
     // Invoking this method on an unresolvable id or one which refers to an
     // array is undefined. Returns true if the value of id was changed.
@@ -125,6 +131,11 @@ class Evaluate : public Editor {
     // DOES NOT resolve id and then update the value which it finds there.
     template <typename B>
     void assign_word(const Identifier* id, size_t idx, size_t n, B b);
+    // Low-level interface: Sets the value of every element in id's underlying
+    // array from a contiguous block of words, n per element. This method has
+    // the same semantics as assign_word, but only flags id as changed once.
+    template <typename B>
+    void assign_words(const Identifier* id, const B* bs, size_t n);
 
     // Forced a recomputation for the next evaluation of any expression that
     // depends on this variable.
@@ -238,6 +249,19 @@ inline void Evaluate::assign_word(const Identifier* id, size_t idx, size_t n, B
   flag_changed(id);
 }
 
+template <typename B>
+inline void Evaluate::assign_words(const Identifier* id, const B* bs, size_t n) {
+  if (id->bit_val_.empty()) {      
+    init(const_cast<Identifier*>(id));
+  }
+  for (auto& v : const_cast<Identifier*>(id)->bit_val_) {
+    for (size_t i = 0; i < n; ++i) {
+      v.write_word<B>(i, *bs++);
+    }
+  }
+  flag_changed(id);
+}
+
 } // namespace cascade
 
 #endif
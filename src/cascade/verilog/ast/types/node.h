@@ -167,6 +167,9 @@ class Node {
     // common_[2-4]  Number:   format_
     // common_[5]    Number:   signed_
     // common_[6-31] Number:   size_
+    // common_[2-31] SwLogic:  rank_ (continuous assigns), site_ (nonblocking assigns)
+    // common_[2-31] SwLogic:  site_ (fflush, fseek, get, and put statements)
+    // common_[2-31] SwLogic:  site_ (feof expressions, an index into eofs_)
 
     DECORATION(Tag, tag);
 
@@ -34,7 +34,9 @@
 #include "target/core/avmm/de10/de10_compiler.h"
 #include "target/core/avmm/ulx3s/ulx3s_compiler.h"
 #include "target/core/avmm/verilator/verilator_compiler.h"
+#include "target/core/native/native_compiler.h"
 #include "target/core/sw/sw_compiler.h"
+#include "target/core/sw/vm_compiler.h"
 #include "target/core/proxy/proxy_compiler.h"
 
 using namespace std;
@@ -46,8 +48,10 @@ CascadeSlave::CascadeSlave() {
 
   remote_compiler_.set("avalon32", new avmm::Avalon32Compiler());
   remote_compiler_.set("de10", new avmm::De10Compiler());
+  remote_compiler_.set("native", new native::NativeCompiler());
   remote_compiler_.set("proxy", new proxy::ProxyCompiler());
   remote_compiler_.set("sw", new sw::SwCompiler());
+  remote_compiler_.set("sw_vm", new sw::VmCompiler());
   remote_compiler_.set("ulx3s32", new avmm::Ulx3s32Compiler());
   remote_compiler_.set("verilator32", new avmm::Verilator32Compiler());
   #if __x86_64__ || __ppc64__
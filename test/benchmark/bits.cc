@@ -0,0 +1,197 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdint>
+#include <random>
+#include "benchmark/benchmark.h"
+#include "common/bits.h"
+
+using namespace cascade;
+using namespace std;
+
+namespace {
+
+// Microbenchmarks for the core Bits operators. Every operator is measured at
+// the same set of widths so that regressions in either the single-word fast
+// paths or the multi-word slow paths show up.
+
+void widths(benchmark::internal::Benchmark* b) {
+  for (auto w : {1, 32, 64, 128, 256, 1024}) {
+    b->Arg(w);
+  }
+}
+
+Bits random_bits(size_t w, uint64_t seed) {
+  mt19937_64 gen(seed);
+  Bits res(w, Bits::Type::UNSIGNED);
+  for (size_t i = 0; i < w; i += 32) {
+    res.write_word<uint32_t>(i/32, static_cast<uint32_t>(gen()));
+  }
+  res.resize(w);
+  return res;
+}
+
+Bits small_bits(size_t w, uint32_t val) {
+  Bits res(w, Bits::Type::UNSIGNED);
+  res.write_word<uint32_t>(0, val);
+  res.resize(w);
+  return res;
+}
+
+void BM_BitsUnary(benchmark::State& state, void (Bits::*op)(const Bits&), size_t rw) {
+  const auto w = state.range(0);
+  const auto lhs = random_bits(w, 1);
+  Bits res(rw == 0 ? w : rw, Bits::Type::UNSIGNED);
+  for (auto _ : state) {
+    (res.*op)(lhs);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+void BM_BitsBinary(benchmark::State& state, void (Bits::*op)(const Bits&, const Bits&), size_t rw) {
+  const auto w = state.range(0);
+  const auto lhs = random_bits(w, 1);
+  const auto rhs = random_bits(w, 2);
+  Bits res(rw == 0 ? w : rw, Bits::Type::UNSIGNED);
+  for (auto _ : state) {
+    (res.*op)(lhs, rhs);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+// Shifts and powers are measured with a small right hand side; random values
+// would almost always shift everything out or loop over every exponent bit.
+void BM_BitsSmallRhs(benchmark::State& state, void (Bits::*op)(const Bits&, const Bits&)) {
+  const auto w = state.range(0);
+  const auto lhs = random_bits(w, 1);
+  const auto rhs = small_bits(w, (w == 1) ? 1 : 13);
+  Bits res(w, Bits::Type::UNSIGNED);
+  for (auto _ : state) {
+    (res.*op)(lhs, rhs);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+// Division is measured against a half-width divisor so that both the
+// estimation and the multiply-subtract steps of long division are exercised.
+void BM_BitsDivide(benchmark::State& state, void (Bits::*op)(const Bits&, const Bits&)) {
+  const auto w = state.range(0);
+  const auto lhs = random_bits(w, 1);
+  auto rhs = random_bits((w+1)/2, 2);
+  rhs.resize(w);
+  Bits res(w, Bits::Type::UNSIGNED);
+  for (auto _ : state) {
+    (res.*op)(lhs, rhs);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+void BM_BitsConcat(benchmark::State& state) {
+  const auto w = state.range(0);
+  const auto lhs = random_bits(w, 1);
+  const auto rhs = random_bits(w, 2);
+  for (auto _ : state) {
+    auto res = lhs;
+    res.concat(rhs);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+void BM_BitsAssignSlice(benchmark::State& state) {
+  const auto w = state.range(0);
+  const auto rhs = random_bits(w, 2);
+  auto res = random_bits(w, 1);
+  for (auto _ : state) {
+    res.assign(w-1, w/2, rhs);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+void BM_BitsEq(benchmark::State& state) {
+  const auto w = state.range(0);
+  const auto lhs = random_bits(w, 1);
+  const auto rhs = lhs;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs == rhs);
+  }
+}
+
+void BM_BitsLt(benchmark::State& state) {
+  const auto w = state.range(0);
+  const auto lhs = random_bits(w, 1);
+  const auto rhs = random_bits(w, 2);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs < rhs);
+  }
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_BitsUnary, bitwise_not, &Bits::bitwise_not, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsUnary, arithmetic_plus, &Bits::arithmetic_plus, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsUnary, arithmetic_minus, &Bits::arithmetic_minus, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsUnary, logical_not, &Bits::logical_not, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsUnary, reduce_and, &Bits::reduce_and, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsUnary, reduce_nand, &Bits::reduce_nand, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsUnary, reduce_or, &Bits::reduce_or, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsUnary, reduce_nor, &Bits::reduce_nor, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsUnary, reduce_xor, &Bits::reduce_xor, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsUnary, reduce_xnor, &Bits::reduce_xnor, 1)->Apply(widths);
+
+BENCHMARK_CAPTURE(BM_BitsBinary, bitwise_and, &Bits::bitwise_and, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, bitwise_or, &Bits::bitwise_or, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, bitwise_xor, &Bits::bitwise_xor, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, bitwise_xnor, &Bits::bitwise_xnor, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, arithmetic_plus, &Bits::arithmetic_plus, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, arithmetic_minus, &Bits::arithmetic_minus, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, arithmetic_multiply, &Bits::arithmetic_multiply, 0)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, logical_and, &Bits::logical_and, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, logical_or, &Bits::logical_or, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, logical_eq, &Bits::logical_eq, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, logical_ne, &Bits::logical_ne, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, logical_lt, &Bits::logical_lt, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, logical_lte, &Bits::logical_lte, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, logical_gt, &Bits::logical_gt, 1)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsBinary, logical_gte, &Bits::logical_gte, 1)->Apply(widths);
+
+BENCHMARK_CAPTURE(BM_BitsSmallRhs, bitwise_sll, &Bits::bitwise_sll)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsSmallRhs, bitwise_sal, &Bits::bitwise_sal)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsSmallRhs, bitwise_slr, &Bits::bitwise_slr)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsSmallRhs, bitwise_sar, &Bits::bitwise_sar)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsSmallRhs, arithmetic_pow, &Bits::arithmetic_pow)->Apply(widths);
+
+BENCHMARK_CAPTURE(BM_BitsDivide, arithmetic_divide, &Bits::arithmetic_divide)->Apply(widths);
+BENCHMARK_CAPTURE(BM_BitsDivide, arithmetic_mod, &Bits::arithmetic_mod)->Apply(widths);
+
+BENCHMARK(BM_BitsConcat)->Apply(widths);
+BENCHMARK(BM_BitsAssignSlice)->Apply(widths);
+BENCHMARK(BM_BitsEq)->Apply(widths);
+BENCHMARK(BM_BitsLt)->Apply(widths);
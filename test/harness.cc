@@ -77,16 +77,27 @@ void run_code(const string& march, const string& path, const string& expected, b
   if (::coverage && omit_from_coverage) {
     return;
   }
+  Config config;
+  config.march = march;
+  run_code(config, path, expected);
+}
 
+void run_code(const Config& config, const string& path, const string& expected, bool omit_from_coverage) {
+  if (::coverage && omit_from_coverage) {
+    return;
+  }
   auto* sb = new stringbuf();
 
   Cascade c;
   c.set_fopen_dirs(System::src_root());
+  c.set_parallel_threads(config.parallel_threads);
+  c.set_enable_tiering(config.enable_tiering);
+  c.set_enable_fusion(config.enable_fusion);
   c.set_stdout(sb);
   c.set_stderr(cout.rdbuf());
   c.run();
 
-  c << "`include \"share/cascade/march/" << march << ".v\"\n"
+  c << "`include \"share/cascade/march/" << config.march << ".v\"\n"
     << "`include \"" << path << "\"" << endl;
 
   c.stop_now();
@@ -101,8 +112,10 @@ void run_concurrent(const string& march, const string& path, const string& expec
   if (::coverage && omit_from_coverage) {
     return;
   }
-  std::thread t1(run_code, march, path, expected, false);
-  std::thread t2(run_code, march, path, expected, false);
+  Config config;
+  config.march = march;
+  std::thread t1([&config, &path, &expected]{run_code(config, path, expected);});
+  std::thread t2([&config, &path, &expected]{run_code(config, path, expected);});
   t1.join();
   t2.join();
 }
@@ -35,9 +35,20 @@
 
 namespace cascade {
 
+// Runtime options which vary between regression configurations. The
+// defaults match those of a freshly constructed Cascade.
+struct Config {
+  std::string name;
+  std::string march;
+  size_t parallel_threads = 0;
+  bool enable_tiering = false;
+  bool enable_fusion = false;
+};
+
 void run_parse(const std::string& path, bool expected);
 void run_typecheck(const std::string& march, const std::string& path, bool expected);
 void run_code(const std::string& march, const std::string& path, const std::string& expected, bool omit_from_coverage = false);
+void run_code(const Config& config, const std::string& path, const std::string& expected, bool omit_from_coverage = false);
 void run_concurrent(const std::string& march, const std::string& path, const std::string& expected, bool omit_from_coverage = false);
 void run_benchmark(const std::string& path, const std::string& expected);
 
@@ -0,0 +1,110 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <string>
+#include <tuple>
+#include "gtest/gtest.h"
+#include "test/harness.h"
+
+using namespace cascade;
+using namespace std;
+
+struct Benchmark {
+  string name;
+  string path;
+  string expected;
+};
+
+class configs_test : public ::testing::TestWithParam<tuple<Config, Benchmark>> { };
+
+namespace {
+
+const Config sw_vm_config {"sw_vm", "regression/sw_vm"};
+const Config native_config {"native", "regression/native"};
+const Config levelize_config {"levelize", "regression/levelize"};
+const Config parallel_config {"parallel", "regression/no_inline", 4};
+const Config tiered_config {"tiered", "regression/native", 0, true};
+const Config fused_config {"fused", "regression/no_inline", 0, false, true};
+
+// Every benchmark is run under every configuration
+const Config all_configs[] = {
+  sw_vm_config,
+  native_config,
+  levelize_config,
+  parallel_config,
+  tiered_config,
+  fused_config
+};
+const Benchmark all_benchmarks[] = {
+  {"array", "share/cascade/test/benchmark/array/run_5.v", "1048577\n"},
+  {"bitcoin", "share/cascade/test/benchmark/bitcoin/run_4.v", "0000000f 00000093\n"},
+  {"mips32", "share/cascade/test/benchmark/mips32/run_bubble_128.v", "1"},
+  {"nw", "share/cascade/test/benchmark/nw/run_4.v", "-1126"},
+  {"regex", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424"}
+};
+
+} // namespace
+
+TEST_P(configs_test, benchmark) {
+  const auto& b = get<1>(GetParam());
+  run_code(get<0>(GetParam()), b.path, b.expected, true);
+}
+
+INSTANTIATE_TEST_SUITE_P(configs, configs_test,
+  ::testing::Combine(::testing::ValuesIn(all_configs), ::testing::ValuesIn(all_benchmarks)),
+  [](const ::testing::TestParamInfo<configs_test::ParamType>& info) {
+    return get<0>(info.param).name + "_" + get<1>(info.param).name;
+  }
+);
+
+TEST(sw_vm, case_4) {
+  run_code(sw_vm_config, "share/cascade/test/regression/simple/case_4.v", "11");
+}
+TEST(native, pow_1) {
+  run_code(native_config, "share/cascade/test/regression/simple/pow_1.v", "19978251e2bc2000");
+}
+TEST(native, pow_2) {
+  run_code(native_config, "share/cascade/test/regression/simple/pow_2.v", "97540bffe4209000");
+}
+TEST(levelize, assign_chain_1) {
+  run_code(levelize_config, "share/cascade/test/regression/simple/assign_chain_1.v", "514229 1346269 2178309 3010349 3842389 4674429 5506469 6338509 7170549 8002589 8834629 9666669 10498709 11330749 12162789 12994829 13826869 14658909 15490949 16322989 ");
+}
+TEST(parallel, inst_4) {
+  run_code(parallel_config, "share/cascade/test/regression/simple/inst_4.v", "1000");
+}
+TEST(parallel, inst_6) {
+  run_code(parallel_config, "share/cascade/test/regression/simple/inst_6.v", "11223344");
+}
+TEST(tiered, initial) {
+  run_code(tiered_config, "share/cascade/test/regression/jit/initial.v", "once");
+}
+TEST(fused, initial) {
+  run_code(fused_config, "share/cascade/test/regression/jit/fused_initial.v", "once");
+}
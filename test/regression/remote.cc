@@ -56,6 +56,9 @@ TEST(one_to_one, pipeline_1) {
 TEST(one_to_one, pipeline_2) {
   run_code("regression/remote", "share/cascade/test/regression/simple/pipeline_2.v", "0123456789");
 }
+TEST(one_to_one, batch) {
+  run_code("regression/remote", "share/cascade/test/regression/simple/batch_1.v", "0 1 3 6 10 15 ");
+}
 TEST(one_to_one, io) {
   run_code("regression/remote", "share/cascade/test/regression/simple/io_1.v", "1234512345");
 }
@@ -36,12 +36,18 @@ using namespace cascade;
 TEST(simple, arithmetic_divide) {
   run_code("regression/minimal","share/cascade/test/regression/simple/arithmetic_divide.v", "2"); 
 }
+TEST(simple, arithmetic_divide_2) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/arithmetic_divide_2.v", "00000000000000000123456789abcdef 00000000000000000000000000000000 00000000000000000000000000000000 0000000000000000ffffffffffffffff ffffffffd663cca33099702468acf136 00000000000000000000000123456789 00000000000000007f6e5d4c3b2a19084048d159e26af37b ");
+}
 TEST(simple, arithmetic_minus) {
   run_code("regression/minimal","share/cascade/test/regression/simple/arithmetic_minus.v", "0"); 
 }
 TEST(simple, arithmetic_mod) {
   run_code("regression/minimal","share/cascade/test/regression/simple/arithmetic_mod.v", "3"); 
 }
+TEST(simple, arithmetic_mod_2) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/arithmetic_mod_2.v", "0000000000000000fb72ea61d950c843 00000000000000000000000000000005 00000000000000000000000000000000 0000000000000000ffffffffffffffff fffffffffffffffffffffffffffffffd ffffffffffffffff5432110000000000 00000000000000000000000000000001516b049e37d16b03 ");
+}
 TEST(simple, arithmetic_multiply) {
   run_code("regression/minimal","share/cascade/test/regression/simple/arithmetic_multiply.v", "56"); 
 }
@@ -51,6 +57,9 @@ TEST(simple, arithmetic_plus) {
 TEST(simple, arithmetic_pow) {
   run_code("regression/minimal","share/cascade/test/regression/simple/arithmetic_pow.v", "16"); 
 }
+TEST(simple, arithmetic_pow_2) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/arithmetic_pow_2.v", "673768565b41f775d6947d55cf3813d1 00000000000000050000000000000001 80000000000000000000000000000000 00000000000000000000000000000000 00000000000000000000000000000001 ");
+}
 TEST(simple, array_1) {
   run_code("regression/minimal","share/cascade/test/regression/simple/array_1.v", "0123");
 }
@@ -84,6 +93,12 @@ TEST(simple, assign_6) {
 TEST(simple, assign_7) {
   run_code("regression/minimal","share/cascade/test/regression/simple/assign_7.v", "170");
 }
+TEST(simple, assign_chain_1) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/assign_chain_1.v", "514229 1346269 2178309 3010349 3842389 4674429 5506469 6338509 7170549 8002589 8834629 9666669 10498709 11330749 12162789 12994829 13826869 14658909 15490949 16322989 ");
+}
+TEST(simple, batch_1) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/batch_1.v", "0 1 3 6 10 15 ");
+}
 TEST(simple, bitwise_and) {
   run_code("regression/minimal","share/cascade/test/regression/simple/bitwise_and.v", "1");
 }
@@ -114,6 +129,9 @@ TEST(simple, case_2) {
 TEST(simple, case_3) {
   run_code("regression/minimal","share/cascade/test/regression/simple/case_3.v", "123");
 }
+TEST(simple, case_4) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/case_4.v", "11");
+}
 TEST(simple, concat_1) {
   run_code("regression/minimal","share/cascade/test/regression/simple/concat_1.v", "170");
 }
@@ -180,6 +198,9 @@ TEST(simple, inst_2) {
 TEST(simple, inst_3) {
   run_code("regression/minimal","share/cascade/test/regression/simple/inst_3.v", "1");
 }
+TEST(simple, inst_4) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/inst_4.v", "1000");
+}
 TEST(simple, io_1) {
   run_code("regression/minimal","share/cascade/test/regression/simple/io_1.v", "1234512345");
 }
@@ -288,6 +309,12 @@ TEST(simple, pipeline_1) {
 TEST(simple, pipeline_2) {
   run_code("regression/minimal","share/cascade/test/regression/simple/pipeline_2.v", "0123456789");
 }
+TEST(simple, pow_1) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/pow_1.v", "19978251e2bc2000");
+}
+TEST(simple, pow_2) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/pow_2.v", "97540bffe4209000");
+}
 TEST(simple, precedence) {
   run_code("regression/minimal","share/cascade/test/regression/simple/precedence.v", "7");
 }
@@ -48,6 +48,9 @@ TEST(verilator32, nw) {
 TEST(verilator32, regex) {
   run_code("regression/verilator32", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424");
 }
+TEST(verilator32, slots) {
+  run_code("regression/verilator32_no_inline", "share/cascade/test/regression/simple/inst_5.v", "4000000 8000000", true);
+}
 
 #if __x86_64__ || __ppc64__
 TEST(verilator64, array) {
@@ -65,4 +68,7 @@ TEST(verilator64, nw) {
 TEST(verilator64, regex) {
   run_code("regression/verilator64", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424");
 }
+TEST(verilator64, slots) {
+  run_code("regression/verilator64_no_inline", "share/cascade/test/regression/simple/inst_5.v", "4000000 8000000", true);
+}
 #endif
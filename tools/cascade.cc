@@ -85,10 +85,40 @@ auto& enable_log = FlagArg::create("--enable_log")
 __attribute__((unused)) auto& g4 = Group::create("Optimization Options");
 auto& disable_inlining = FlagArg::create("--disable_inlining")
   .description("Prevents cascade from inlining modules");
-auto& open_loop_target = StrArg<size_t>::create("--open_loop_target")
+auto& enable_fusion = FlagArg::create("--enable_fusion")
+  .description("Compiles modules which can't be inlined but share a software target into a single engine");
+auto& enable_tiering = FlagArg::create("--enable_tiering")
+  .description("Only promotes modules to their next compilation target once they account for a significant share of simulation time");
+auto& promotion_threshold = StrArg<size_t>::create("--promotion_threshold")
   .usage("<n>")
-  .description("Maximum number of seconds to run in open loop for before transferring control back to runtime")
-  .initial(1);
+  .description("Percentage of simulation time a module must account for before it's promoted; only effective with --enable_tiering")
+  .initial(5);
+auto& open_loop_target = StrArg<double>::create("--open_loop_target")
+  .usage("<n>")
+  .description("Target number of milliseconds to run in open loop for before transferring control back to runtime; n may be fractional, and setting it to zero returns control as often as possible")
+  .initial(10);
+auto& parallel_threads = StrArg<size_t>::create("--parallel_threads")
+  .usage("<n>")
+  .description("Number of threads to use for scheduling independent modules concurrently; setting n to zero or one disables parallel scheduling")
+  .initial(0);
+auto& verilator_opt = StrArg<size_t>::create("--verilator_opt")
+  .usage("<n>")
+  .description("Optimization level to build verilated models with; lower levels compile faster")
+  .initial(3);
+auto& verilator_disable_lto = FlagArg::create("--verilator_disable_lto")
+  .description("Disables link-time optimization when building verilated models");
+auto& verilator_jobs = StrArg<size_t>::create("--verilator_jobs")
+  .usage("<n>")
+  .description("Number of compiler processes to use when building verilated models; setting n to zero uses one per hardware thread")
+  .initial(0);
+auto& cache_path = StrArg<string>::create("--cache_path")
+  .usage("<path>")
+  .description("Directory to store the results of hardware and native compilations in between runs")
+  .initial("/tmp/cascade/cache/");
+auto& cache_capacity = StrArg<size_t>::create("--cache_capacity")
+  .usage("<n>")
+  .description("Maximum number of megabytes to store in the compilation cache; setting n to zero disables the cache")
+  .initial(1024);
 
 __attribute__((unused)) auto& g5 = Group::create("REPL Options");
 auto& disable_repl = FlagArg::create("--disable_repl")
@@ -200,9 +230,16 @@ int main(int argc, char** argv) {
   ::cascade_->set_fopen_dirs(::fopen_dirs.value());
   ::cascade_->set_include_dirs(::inc_dirs.value());
   ::cascade_->set_enable_inlining(!::disable_inlining.value());
+  ::cascade_->set_enable_fusion(::enable_fusion.value());
+  ::cascade_->set_enable_tiering(::enable_tiering.value());
+  ::cascade_->set_promotion_threshold(::promotion_threshold.value());
   ::cascade_->set_open_loop_target(::open_loop_target.value());
   ::cascade_->set_quartus_server(::quartus_host.value(), ::quartus_port.value());
+  ::cascade_->set_verilator_build(::verilator_opt.value(), !::verilator_disable_lto.value(), ::verilator_jobs.value());
   ::cascade_->set_profile_interval(::profile.value());
+  ::cascade_->set_parallel_threads(::parallel_threads.value());
+  ::cascade_->set_cache_path(::cache_path.value());
+  ::cascade_->set_cache_capacity(::cache_capacity.value());
 
   // Map standard streams to colored outbufs
   if (::disable_repl.value()) {